@@ -0,0 +1,156 @@
+﻿#include "../../RStein.AsyncCpp/AsyncPrimitives/BroadcastRingBuffer.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/CancellationTokenSource.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/OperationCanceledException.h"
+#include "../../RStein.AsyncCpp/Tasks/Task.h"
+
+#include <future>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace RStein::AsyncCpp::AsyncPrimitives;
+using namespace RStein::AsyncCpp::Tasks;
+using namespace std;
+
+namespace RStein::AsyncCpp::AsyncPrimitivesTest
+{
+  class BroadcastRingBufferWaitStrategyTest : public TestWithParam<BroadcastRingBuffer<long>::WaitStrategy>
+  {
+  protected:
+    using RingBuffer = BroadcastRingBuffer<long>;
+
+    static Task<long> sumItemsAsync(RingBuffer& ringBuffer, RingBuffer::ConsumerPtr consumer, long itemsCount)
+    {
+      long sum = 0;
+      RingBuffer::Sequence sequence = 0;
+      while (sequence < itemsCount)
+      {
+        auto availableSequence = co_await ringBuffer.WaitForAsync(consumer);
+        for (; sequence <= availableSequence; sequence++)
+        {
+          sum += ringBuffer.Get(sequence);
+        }
+
+        ringBuffer.Release(consumer, availableSequence);
+      }
+
+      co_return sum;
+    }
+  };
+
+  TEST(BroadcastRingBufferTest, WaitForAsyncWhenItemsPublishedThenEveryConsumerReadsSameSlot)
+  {
+    BroadcastRingBuffer<int> ringBuffer{4};
+    auto firstConsumer = ringBuffer.AddConsumer();
+    auto secondConsumer = ringBuffer.AddConsumer();
+
+    ASSERT_TRUE(ringBuffer.TryPublish(10));
+    ASSERT_TRUE(ringBuffer.TryPublish(20));
+
+    auto firstAvailableSequence = ringBuffer.WaitForAsync(firstConsumer).Result();
+    auto secondAvailableSequence = ringBuffer.WaitForAsync(secondConsumer).Result();
+    ASSERT_EQ(1, firstAvailableSequence);
+    ASSERT_EQ(1, secondAvailableSequence);
+    ASSERT_EQ(10, ringBuffer.Get(0));
+    ASSERT_EQ(20, ringBuffer.Get(1));
+    ASSERT_EQ(&ringBuffer.Get(0), &ringBuffer.Get(4));
+  }
+
+  TEST(BroadcastRingBufferTest, PublishAsyncWhenSlotIsNotReleasedByAllConsumersThenWaits)
+  {
+    BroadcastRingBuffer<int> ringBuffer{2};
+    auto firstConsumer = ringBuffer.AddConsumer();
+    auto secondConsumer = ringBuffer.AddConsumer();
+    ringBuffer.PublishAsync(0).Wait();
+    ringBuffer.PublishAsync(1).Wait();
+
+    ASSERT_FALSE(ringBuffer.TryPublish(2));
+    auto publishTask = ringBuffer.PublishAsync(2);
+    ringBuffer.Release(firstConsumer, 0);
+    ASSERT_FALSE(ringBuffer.TryPublish(3));
+    ringBuffer.Release(secondConsumer, 0);
+    publishTask.Wait();
+
+    ASSERT_EQ(2, ringBuffer.WaitForAsync(firstConsumer).Result());
+    ASSERT_EQ(2, ringBuffer.Get(2));
+  }
+
+  TEST(BroadcastRingBufferTest, WaitForAsyncWhenConsumerHasDependencyThenWaitsForDependencyRelease)
+  {
+    BroadcastRingBuffer<int> ringBuffer{4};
+    auto journalConsumer = ringBuffer.AddConsumer();
+    auto businessLogicConsumer = ringBuffer.AddConsumer({journalConsumer});
+    ringBuffer.TryPublish(1);
+    ringBuffer.TryPublish(2);
+
+    auto businessLogicTask = ringBuffer.WaitForAsync(businessLogicConsumer);
+    ASSERT_EQ(1, ringBuffer.WaitForAsync(journalConsumer).Result());
+    ringBuffer.Release(journalConsumer, 0);
+
+    ASSERT_EQ(0, businessLogicTask.Result());
+  }
+
+  TEST(BroadcastRingBufferTest, WaitForAsyncWhenCanceledThenThrowsOperationCanceledException)
+  {
+    BroadcastRingBuffer<int> ringBuffer{4};
+    auto consumer = ringBuffer.AddConsumer();
+    CancellationTokenSource cts;
+
+    auto waitTask = ringBuffer.WaitForAsync(consumer, cts.Token());
+    cts.Cancel();
+
+    ASSERT_THROW(waitTask.Wait(), OperationCanceledException);
+  }
+
+  TEST_P(BroadcastRingBufferWaitStrategyTest, PublishAsyncWhenManyProducersAndConsumersThenEveryConsumerReadsAllItems)
+  {
+    const int PRODUCERS_COUNT = 2;
+    const long ITEMS_PER_PRODUCER = 1000;
+    const long ITEMS_COUNT = PRODUCERS_COUNT * ITEMS_PER_PRODUCER;
+    RingBuffer ringBuffer{64, GetParam()};
+    auto firstConsumer = ringBuffer.AddConsumer();
+    auto secondConsumer = ringBuffer.AddConsumer();
+    auto dependentConsumer = ringBuffer.AddConsumer({firstConsumer, secondConsumer});
+
+    //Spinning consumers block their threads.
+    auto sumItems = [&ringBuffer, ITEMS_COUNT](RingBuffer::ConsumerPtr consumer)
+    {
+      return async(launch::async, [&ringBuffer, consumer, ITEMS_COUNT]
+      {
+        return sumItemsAsync(ringBuffer, consumer, ITEMS_COUNT).Result();
+      });
+    };
+    auto firstSumFuture = sumItems(firstConsumer);
+    auto secondSumFuture = sumItems(secondConsumer);
+    auto dependentSumFuture = sumItems(dependentConsumer);
+    vector<thread> producers;
+    for (int i = 0; i < PRODUCERS_COUNT; i++)
+    {
+      producers.emplace_back([&ringBuffer, ITEMS_PER_PRODUCER]
+      {
+        for (long item = 1; item <= ITEMS_PER_PRODUCER; item++)
+        {
+          ringBuffer.PublishAsync(item).Wait();
+        }
+      });
+    }
+
+    for (auto& producer : producers)
+    {
+      producer.join();
+    }
+
+    const auto expectedSum = PRODUCERS_COUNT * ITEMS_PER_PRODUCER * (ITEMS_PER_PRODUCER + 1) / 2;
+    ASSERT_EQ(expectedSum, firstSumFuture.get());
+    ASSERT_EQ(expectedSum, secondSumFuture.get());
+    ASSERT_EQ(expectedSum, dependentSumFuture.get());
+  }
+
+  INSTANTIATE_TEST_SUITE_P(WaitStrategies,
+                           BroadcastRingBufferWaitStrategyTest,
+                           Values(BroadcastRingBuffer<long>::WaitStrategy::BusySpin,
+                                  BroadcastRingBuffer<long>::WaitStrategy::Yield,
+                                  BroadcastRingBuffer<long>::WaitStrategy::Park));
+}
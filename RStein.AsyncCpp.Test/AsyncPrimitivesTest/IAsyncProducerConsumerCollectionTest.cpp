@@ -1,13 +1,34 @@
+#include "../../RStein.AsyncCpp/AsyncPrimitives/AddingCompletedException.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/AsyncDelayQueue.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/AsyncPriorityProducerConsumerCollection.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/AsyncSpillingProducerConsumerCollection.h"
 #include "../../RStein.AsyncCpp/AsyncPrimitives/CancellationTokenSource.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/Channel.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/ConflatingChannel.h"
 #include "../../RStein.AsyncCpp/AsyncPrimitives/OperationCanceledException.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/Select.h"
 #include "../../RStein.AsyncCpp/AsyncPrimitives/SimpleAsyncProducerConsumerCollection.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/SpscChannel.h"
+#include "../../RStein.AsyncCpp/Schedulers/SimpleThreadPool.h"
+#include "../../RStein.AsyncCpp/Schedulers/ThreadPoolScheduler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <experimental/coroutine>
+#include <filesystem>
+#include <functional>
+#include <future>
 #include <gtest/gtest.h>
 #include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace testing;
 using namespace RStein::AsyncCpp::AsyncPrimitives;
+using namespace RStein::AsyncCpp::Schedulers;
 using namespace std;
 using namespace std::experimental;
 
@@ -51,7 +72,15 @@ namespace RStein::AsyncCpp::AsyncPrimitivesTest
     }
   };
 
-  using Collections = Types<SimpleAsyncProducerConsumerCollection<int>>;
+  //The priority collection returns the smallest item first, so the items added in the ascending order are taken in the FIFO order.
+  //Every item of the conflating channel has a distinct key (the item itself), so no item is replaced.
+  //Items added to the delay queue without the due time are available immediately.
+  using Collections = Types<SimpleAsyncProducerConsumerCollection<int>,
+                            Channel<int>,
+                            SpscChannel<int>,
+                            AsyncPriorityProducerConsumerCollection<int, greater<int>>,
+                            ConflatingChannel<int>,
+                            AsyncDelayQueue<int>>;
   TYPED_TEST_SUITE(AsyncProducerConsumerCollectionTest, Collections);
 
   TYPED_TEST(AsyncProducerConsumerCollectionTest, TakeAsyncWhenCollectionHaveValueThenReturnValue)
@@ -92,4 +121,631 @@ namespace RStein::AsyncCpp::AsyncPrimitivesTest
     ASSERT_TRUE(asyncCollectionItemsEqualToItems);
 
   }
+
+  TYPED_TEST(AsyncProducerConsumerCollectionTest, TakeManyAsyncWhenHasItemsThenReturnsAtMostMaxItems)
+  {
+    const int ITEMS_IN_COLLECTION = 10;
+    const size_t MAX_ITEMS = 4;
+    typename TestFixture::Collection asyncCollection;
+    vector<int> takenItems;
+
+    auto takeManyTask = asyncCollection.TakeManyAsync(takenItems, MAX_ITEMS, CancellationToken::None());
+    ASSERT_FALSE(takeManyTask.IsCompleted());
+
+    for (int i = 0; i < ITEMS_IN_COLLECTION; i++)
+    {
+      asyncCollection.Add(i);
+    }
+
+    auto firstTakenCount = takeManyTask.Result();
+    auto secondTakenCount = asyncCollection.TakeManyAsync(takenItems, MAX_ITEMS, CancellationToken::None()).Result();
+
+    ASSERT_GE(firstTakenCount, 1u);
+    ASSERT_LE(firstTakenCount, MAX_ITEMS);
+    ASSERT_EQ(MAX_ITEMS, secondTakenCount);
+    vector<int> expectedItems(firstTakenCount + secondTakenCount);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, takenItems);
+  }
+
+  TYPED_TEST(AsyncProducerConsumerCollectionTest, SelectWhenCollectionsAreEmptyThenCompletesAfterAddAndTakesOneItem)
+  {
+    typename TestFixture::Collection firstCollection;
+    typename TestFixture::Collection secondCollection;
+
+    auto selectTask = Select<int>({&firstCollection, &secondCollection});
+    ASSERT_FALSE(selectTask.IsCompleted());
+    secondCollection.Add(1);
+    secondCollection.Add(2);
+    auto selectResult = selectTask.Result();
+
+    ASSERT_EQ(1u, selectResult.Index);
+    ASSERT_EQ(1, selectResult.Item);
+    ASSERT_TRUE(firstCollection.TryTakeAll().empty());
+    ASSERT_EQ((vector<int>{2}), secondCollection.TryTakeAll());
+  }
+
+  TYPED_TEST(AsyncProducerConsumerCollectionTest, SelectWhenCanceledThenThrowsOperationCanceledExceptionAndNoItemIsTaken)
+  {
+    typename TestFixture::Collection firstCollection;
+    typename TestFixture::Collection secondCollection;
+    CancellationTokenSource cts;
+
+    auto selectTask = Select<int>({&firstCollection, &secondCollection}, cts.Token());
+    cts.Cancel();
+    firstCollection.Add(1);
+
+    ASSERT_THROW(selectTask.Wait(), OperationCanceledException);
+    ASSERT_EQ((vector<int>{1}), firstCollection.TryTakeAll());
+  }
+
+  TEST(SimpleAsyncProducerConsumerCollectionTest, AddAsyncWhenCollectionIsFullThenProducersAreResumedInFifoOrder)
+  {
+    const int CAPACITY = 1;
+    SimpleAsyncProducerConsumerCollection<int> collection{CAPACITY};
+    collection.AddAsync(0).Wait();
+
+    auto firstAddTask = collection.AddAsync(1);
+    auto secondAddTask = collection.AddAsync(2);
+    ASSERT_FALSE(firstAddTask.IsCompleted());
+    ASSERT_FALSE(secondAddTask.IsCompleted());
+    ASSERT_FALSE(collection.TryAdd(3));
+
+    vector<int> takenItems;
+    takenItems.push_back(collection.TakeAsync().Result());
+    firstAddTask.Wait();
+    ASSERT_FALSE(secondAddTask.IsCompleted());
+    takenItems.push_back(collection.TakeAsync().Result());
+    secondAddTask.Wait();
+    takenItems.push_back(collection.TakeAsync().Result());
+
+    ASSERT_EQ((vector<int>{0, 1, 2}), takenItems);
+  }
+
+  TEST(SimpleAsyncProducerConsumerCollectionTest, AddAsyncWhenCanceledThenThrowsOperationCanceledExceptionAndItemIsNotAdded)
+  {
+    const int CAPACITY = 1;
+    SimpleAsyncProducerConsumerCollection<int> collection{CAPACITY};
+    collection.Add(0);
+    CancellationTokenSource cts;
+
+    auto addTask = collection.AddAsync(1, cts.Token());
+    cts.Cancel();
+
+    ASSERT_THROW(addTask.Wait(), OperationCanceledException);
+    ASSERT_EQ(0, collection.TakeAsync().Result());
+    ASSERT_TRUE(collection.TryAdd(2));
+    ASSERT_EQ((vector<int>{2}), collection.TryTakeAll());
+  }
+
+  TEST(SimpleAsyncProducerConsumerCollectionTest, CompleteAddingWhenItemsTakenThenWaitingTakersAndProducersThrowAddingCompletedException)
+  {
+    const int CAPACITY = 1;
+    SimpleAsyncProducerConsumerCollection<int> collection{CAPACITY};
+    collection.Add(0);
+    auto waitingAddTask = collection.AddAsync(1);
+
+    collection.CompleteAdding();
+
+    ASSERT_THROW(waitingAddTask.Wait(), AddingCompletedException);
+    ASSERT_FALSE(collection.TryAdd(2));
+    ASSERT_THROW(collection.Add(2), AddingCompletedException);
+    ASSERT_EQ(0, collection.TakeAsync().Result());
+    auto firstTakeTask = collection.TakeAsync();
+    auto secondTakeTask = collection.TakeAsync();
+    ASSERT_THROW(firstTakeTask.Wait(), AddingCompletedException);
+    ASSERT_THROW(secondTakeTask.Wait(), AddingCompletedException);
+    ASSERT_TRUE(collection.TryTakeAll().empty());
+  }
+
+  struct PriorityItem
+  {
+    int Priority;
+    int Value;
+  };
+
+  struct PriorityItemCompare
+  {
+    bool operator()(const PriorityItem& first, const PriorityItem& second) const
+    {
+      return first.Priority < second.Priority;
+    }
+  };
+
+  vector<int> takePriorityItemValues(AsyncPriorityProducerConsumerCollection<PriorityItem, PriorityItemCompare>& collection, int count)
+  {
+    vector<int> values;
+    for (int i = 0; i < count; i++)
+    {
+      values.push_back(collection.TakeAsync().Result().Value);
+    }
+
+    return values;
+  }
+
+  TEST(AsyncPriorityProducerConsumerCollectionTest, TakeAsyncWhenItemsHaveDifferentPriorityThenReturnsHighestPriorityFirstAndEqualPriorityInFifoOrder)
+  {
+    AsyncPriorityProducerConsumerCollection<PriorityItem, PriorityItemCompare> collection;
+    collection.Add({0, 1});
+    collection.Add({0, 2});
+    collection.Add({5, 3});
+    collection.Add({1, 4});
+    collection.Add({5, 5});
+
+    auto values = takePriorityItemValues(collection, 5);
+
+    ASSERT_EQ((vector<int>{3, 5, 4, 1, 2}), values);
+  }
+
+  TEST(AsyncPriorityProducerConsumerCollectionTest, TakeAsyncWhenMaxBypassedTakesReachedThenReturnsOldestItem)
+  {
+    const size_t MAX_BYPASSED_TAKES = 2;
+    AsyncPriorityProducerConsumerCollection<PriorityItem, PriorityItemCompare> collection{PriorityItemCompare{}, MAX_BYPASSED_TAKES};
+    collection.Add({0, 1});
+    collection.Add({0, 2});
+    for (int i = 0; i < 6; i++)
+    {
+      collection.Add({10, 10 + i});
+    }
+
+    auto values = takePriorityItemValues(collection, 8);
+
+    ASSERT_EQ((vector<int>{10, 11, 1, 12, 13, 2, 14, 15}), values);
+  }
+
+  TEST(AsyncPriorityProducerConsumerCollectionTest, TakeAsyncWhenCollectionIsEmptyThenCompletesAfterAdd)
+  {
+    AsyncPriorityProducerConsumerCollection<PriorityItem, PriorityItemCompare> collection;
+
+    auto takeTask = collection.TakeAsync();
+    ASSERT_FALSE(takeTask.IsCompleted());
+    collection.Add({1, 42});
+
+    ASSERT_EQ(42, takeTask.Result().Value);
+    ASSERT_EQ(0u, collection.Count());
+  }
+
+  TEST(ConflatingChannelTest, AddWhenKeyHasUnconsumedItemThenItemIsReplacedInPlace)
+  {
+    ConflatingChannel<pair<string, int>, string> channel{[](const pair<string, int>& quote) { return quote.first; }};
+    channel.Add({"A", 1});
+    channel.Add({"B", 1});
+    channel.Add({"A", 2});
+    channel.Add({"C", 1});
+    channel.Add({"A", 3});
+
+    auto quotes = channel.TryTakeAll();
+
+    ASSERT_EQ((vector<pair<string, int>>{{"A", 3}, {"B", 1}, {"C", 1}}), quotes);
+    ASSERT_EQ(2u, channel.ConflatedItemsCount());
+  }
+
+  TEST(ConflatingChannelTest, AddWhenProducerIsFasterThanConsumerThenCountIsBoundedByDistinctKeys)
+  {
+    const int KEYS_COUNT = 10;
+    const int UPDATES_COUNT = 1000;
+    ConflatingChannel<pair<int, int>, int> channel{[](const pair<int, int>& update) { return update.first; }};
+
+    for (int i = 0; i < UPDATES_COUNT; i++)
+    {
+      channel.Add({i % KEYS_COUNT, i});
+    }
+
+    ASSERT_EQ(static_cast<size_t>(KEYS_COUNT), channel.Count());
+    auto firstUpdate = channel.TakeAsync().Result();
+    ASSERT_EQ((pair<int, int>{0, UPDATES_COUNT - KEYS_COUNT}), firstUpdate);
+    channel.Add({0, UPDATES_COUNT});
+    ASSERT_EQ(static_cast<size_t>(KEYS_COUNT), channel.Count());
+  }
+
+  TEST(AsyncSpillingProducerConsumerCollectionTest, TakeAsyncWhenItemsAreSpilledThenReturnsItemsInFifoOrderAndRemovesSegments)
+  {
+    const int ITEMS_COUNT = 100;
+    const size_t IN_MEMORY_CAPACITY = 4;
+    const size_t SEGMENT_CAPACITY = 8;
+    const auto segmentDirectory = filesystem::temp_directory_path() / "RStein.AsyncCpp.Test.Spill";
+    filesystem::remove_all(segmentDirectory);
+    SimpleThreadPool ioThreadPool{1};
+    auto ioScheduler = make_shared<ThreadPoolScheduler>(ioThreadPool);
+    ioScheduler->Start();
+    vector<int> takenItems;
+    {
+      AsyncSpillingProducerConsumerCollection<int> collection{IN_MEMORY_CAPACITY,
+                                                              SEGMENT_CAPACITY,
+                                                              segmentDirectory,
+                                                              [](const int& item) { return to_string(item); },
+                                                              [](const string& itemBytes) { return stoi(itemBytes); },
+                                                              ioScheduler};
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        collection.Add(i);
+      }
+
+      ASSERT_EQ(static_cast<size_t>(ITEMS_COUNT), collection.Count());
+      ASSERT_GT(collection.SpilledItemsCount(), 0u);
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        takenItems.push_back(collection.TakeAsync().Result());
+      }
+
+      ASSERT_EQ(0u, collection.Count());
+      ASSERT_TRUE(filesystem::is_empty(segmentDirectory));
+    }
+
+    ioScheduler->Stop();
+    filesystem::remove_all(segmentDirectory);
+    vector<int> expectedItems(ITEMS_COUNT);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, takenItems);
+  }
+
+  TEST(AsyncSpillingProducerConsumerCollectionTest, TakeAsyncWhenSegmentCannotBeWrittenThenItemsStayInMemory)
+  {
+    const int ITEMS_COUNT = 20;
+    const size_t IN_MEMORY_CAPACITY = 2;
+    const size_t SEGMENT_CAPACITY = 4;
+    const auto segmentDirectory = filesystem::temp_directory_path() / "RStein.AsyncCpp.Test.SpillFailure";
+    SimpleThreadPool ioThreadPool{1};
+    auto ioScheduler = make_shared<ThreadPoolScheduler>(ioThreadPool);
+    ioScheduler->Start();
+    vector<int> takenItems;
+    {
+      AsyncSpillingProducerConsumerCollection<int> collection{IN_MEMORY_CAPACITY,
+                                                              SEGMENT_CAPACITY,
+                                                              segmentDirectory,
+                                                              [](const int& item) -> string { throw invalid_argument("item"); },
+                                                              [](const string& itemBytes) { return stoi(itemBytes); },
+                                                              ioScheduler};
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        collection.Add(i);
+      }
+
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        takenItems.push_back(collection.TakeAsync().Result());
+      }
+    }
+
+    ioScheduler->Stop();
+    filesystem::remove_all(segmentDirectory);
+    vector<int> expectedItems(ITEMS_COUNT);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, takenItems);
+  }
+
+  TEST(AsyncSpillingProducerConsumerCollectionTest, AddAsyncWhenUnwrittenItemsExceedLimitThenCompletesAfterSegmentIsWritten)
+  {
+    const size_t IN_MEMORY_CAPACITY = 2;
+    const size_t SEGMENT_CAPACITY = 4;
+    const auto ITEMS_COUNT = static_cast<int>(IN_MEMORY_CAPACITY + SEGMENT_CAPACITY + AsyncSpillingProducerConsumerCollection<int>::MAX_UNWRITTEN_SEGMENTS * SEGMENT_CAPACITY);
+    const auto segmentDirectory = filesystem::temp_directory_path() / "RStein.AsyncCpp.Test.SpillBackpressure";
+    filesystem::remove_all(segmentDirectory);
+    SimpleThreadPool ioThreadPool{1};
+    auto ioScheduler = make_shared<ThreadPoolScheduler>(ioThreadPool);
+    ioScheduler->Start();
+    promise<void> writePromise;
+    auto writeFuture = writePromise.get_future().share();
+    vector<int> takenItems;
+    {
+      AsyncSpillingProducerConsumerCollection<int> collection{IN_MEMORY_CAPACITY,
+                                                              SEGMENT_CAPACITY,
+                                                              segmentDirectory,
+                                                              [writeFuture](const int& item)
+                                                              {
+                                                                writeFuture.wait();
+                                                                return to_string(item);
+                                                              },
+                                                              [](const string& itemBytes) { return stoi(itemBytes); },
+                                                              ioScheduler};
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        ASSERT_TRUE(collection.AddAsync(i).IsCompleted());
+      }
+
+      auto addTask = collection.AddAsync(ITEMS_COUNT);
+      const auto isAddCompletedBeforeWrite = addTask.IsCompleted();
+      writePromise.set_value();
+      addTask.Wait();
+      for (int i = 0; i <= ITEMS_COUNT; i++)
+      {
+        takenItems.push_back(collection.TakeAsync().Result());
+      }
+
+      ASSERT_FALSE(isAddCompletedBeforeWrite);
+    }
+
+    ioScheduler->Stop();
+    filesystem::remove_all(segmentDirectory);
+    vector<int> expectedItems(ITEMS_COUNT + 1);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, takenItems);
+  }
+
+  TEST(AsyncSpillingProducerConsumerCollectionTest, TakeAsyncWhenSegmentCannotBeReadThenReadIsRetried)
+  {
+    const int ITEMS_COUNT = 20;
+    const size_t IN_MEMORY_CAPACITY = 2;
+    const size_t SEGMENT_CAPACITY = 4;
+    const auto segmentDirectory = filesystem::temp_directory_path() / "RStein.AsyncCpp.Test.SpillReadFailure";
+    filesystem::remove_all(segmentDirectory);
+    SimpleThreadPool ioThreadPool{1};
+    auto ioScheduler = make_shared<ThreadPoolScheduler>(ioThreadPool);
+    ioScheduler->Start();
+    atomic<bool> isReadFailed{false};
+    vector<int> takenItems;
+    {
+      AsyncSpillingProducerConsumerCollection<int> collection{IN_MEMORY_CAPACITY,
+                                                              SEGMENT_CAPACITY,
+                                                              segmentDirectory,
+                                                              [](const int& item) { return to_string(item); },
+                                                              [&isReadFailed](const string& itemBytes)
+                                                              {
+                                                                if (!isReadFailed.exchange(true))
+                                                                {
+                                                                  throw invalid_argument("itemBytes");
+                                                                }
+
+                                                                return stoi(itemBytes);
+                                                              },
+                                                              ioScheduler};
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        collection.Add(i);
+      }
+
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        takenItems.push_back(collection.TakeAsync().Result());
+      }
+    }
+
+    ioScheduler->Stop();
+    filesystem::remove_all(segmentDirectory);
+    vector<int> expectedItems(ITEMS_COUNT);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_TRUE(isReadFailed.load());
+    ASSERT_EQ(expectedItems, takenItems);
+  }
+
+  TEST(AsyncSpillingProducerConsumerCollectionTest, TryTakeManyWhenSpilledItemsAreNotReadThenReturnsOnlyItemsInMemory)
+  {
+    const int ITEMS_COUNT = 20;
+    const size_t IN_MEMORY_CAPACITY = 4;
+    const size_t SEGMENT_CAPACITY = 8;
+    const auto segmentDirectory = filesystem::temp_directory_path() / "RStein.AsyncCpp.Test.SpillTryTakeMany";
+    filesystem::remove_all(segmentDirectory);
+    SimpleThreadPool ioThreadPool{1};
+    auto ioScheduler = make_shared<ThreadPoolScheduler>(ioThreadPool);
+    ioScheduler->Start();
+    promise<void> readPromise;
+    auto readFuture = readPromise.get_future().share();
+    vector<int> takenItems;
+    size_t secondTakenCount = 0;
+    {
+      AsyncSpillingProducerConsumerCollection<int> collection{IN_MEMORY_CAPACITY,
+                                                              SEGMENT_CAPACITY,
+                                                              segmentDirectory,
+                                                              [](const int& item) { return to_string(item); },
+                                                              [readFuture](const string& itemBytes)
+                                                              {
+                                                                readFuture.wait();
+                                                                return stoi(itemBytes);
+                                                              },
+                                                              ioScheduler};
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        collection.Add(i);
+      }
+
+      const auto firstTakenCount = collection.TryTakeMany(takenItems, ITEMS_COUNT);
+      secondTakenCount = collection.TryTakeMany(takenItems, ITEMS_COUNT);
+      readPromise.set_value();
+      for (auto i = firstTakenCount; i < static_cast<size_t>(ITEMS_COUNT); i++)
+      {
+        takenItems.push_back(collection.TakeAsync().Result());
+      }
+
+      ASSERT_EQ(IN_MEMORY_CAPACITY, firstTakenCount);
+    }
+
+    ioScheduler->Stop();
+    filesystem::remove_all(segmentDirectory);
+    vector<int> expectedItems(ITEMS_COUNT);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(0u, secondTakenCount);
+    ASSERT_EQ(expectedItems, takenItems);
+  }
+
+  TEST(AsyncSpillingProducerConsumerCollectionTest, TryTakeAllWhenItemsAreSpilledThenReturnsAllItemsInFifoOrder)
+  {
+    const int ITEMS_COUNT = 100;
+    const size_t IN_MEMORY_CAPACITY = 4;
+    const size_t SEGMENT_CAPACITY = 8;
+    const auto segmentDirectory = filesystem::temp_directory_path() / "RStein.AsyncCpp.Test.SpillTryTakeAll";
+    filesystem::remove_all(segmentDirectory);
+    SimpleThreadPool ioThreadPool{1};
+    auto ioScheduler = make_shared<ThreadPoolScheduler>(ioThreadPool);
+    ioScheduler->Start();
+    vector<int> takenItems;
+    {
+      AsyncSpillingProducerConsumerCollection<int> collection{IN_MEMORY_CAPACITY,
+                                                              SEGMENT_CAPACITY,
+                                                              segmentDirectory,
+                                                              [](const int& item) { return to_string(item); },
+                                                              [](const string& itemBytes) { return stoi(itemBytes); },
+                                                              ioScheduler};
+      for (int i = 0; i < ITEMS_COUNT; i++)
+      {
+        collection.Add(i);
+      }
+
+      takenItems = collection.TryTakeAll();
+      ASSERT_EQ(0u, collection.Count());
+    }
+
+    ioScheduler->Stop();
+    filesystem::remove_all(segmentDirectory);
+    vector<int> expectedItems(ITEMS_COUNT);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, takenItems);
+  }
+
+  TEST(AsyncDelayQueueTest, TakeAsyncWhenItemsHaveDueTimeThenReturnsItemsInDueTimeOrderAfterDueTime)
+  {
+    AsyncDelayQueue<int> delayQueue;
+    const auto now = AsyncDelayQueue<int>::Clock::now();
+    delayQueue.Add(3, now + chrono::milliseconds(60));
+    delayQueue.Add(1, now + chrono::milliseconds(20));
+    delayQueue.Add(2, now + chrono::milliseconds(40));
+
+    auto firstTakeTask = delayQueue.TakeAsync();
+    ASSERT_FALSE(firstTakeTask.IsCompleted());
+    vector<int> takenItems{firstTakeTask.Result()};
+    takenItems.push_back(delayQueue.TakeAsync().Result());
+    takenItems.push_back(delayQueue.TakeAsync().Result());
+
+    ASSERT_GE(AsyncDelayQueue<int>::Clock::now(), now + chrono::milliseconds(60));
+    ASSERT_EQ((vector<int>{1, 2, 3}), takenItems);
+  }
+
+  TEST(AsyncDelayQueueTest, AddWhenDueTimesDecreaseThenOnlyOneTimerDelayIsPending)
+  {
+    const int ITEMS_COUNT = 50;
+    auto timer = make_shared<AsyncTimer>(RStein::AsyncCpp::Schedulers::Scheduler::DefaultScheduler());
+    AsyncDelayQueue<int> delayQueue{timer};
+    const auto now = AsyncDelayQueue<int>::Clock::now();
+    for (auto i = 0; i < ITEMS_COUNT; i++)
+    {
+      delayQueue.Add(i, now + chrono::milliseconds(100 - i));
+    }
+
+    const auto pendingDelaysCount = timer->PendingDelaysCount();
+    vector<int> takenItems;
+    for (auto i = 0; i < ITEMS_COUNT; i++)
+    {
+      takenItems.push_back(delayQueue.TakeAsync().Result());
+    }
+
+    ASSERT_EQ(1u, pendingDelaysCount);
+    vector<int> expectedItems(ITEMS_COUNT);
+    iota(expectedItems.rbegin(), expectedItems.rend(), 0);
+    ASSERT_EQ(expectedItems, takenItems);
+    ASSERT_EQ(0u, timer->PendingDelaysCount());
+  }
+
+  TEST(AsyncDelayQueueTest, TryTakeAllWhenItemIsNotDueThenReturnsOnlyDueItems)
+  {
+    AsyncDelayQueue<int> delayQueue;
+    delayQueue.Add(1, AsyncDelayQueue<int>::Clock::now() + chrono::hours(1));
+    delayQueue.Add(2);
+
+    auto dueItems = delayQueue.TryTakeAll();
+
+    ASSERT_EQ((vector<int>{2}), dueItems);
+    ASSERT_EQ(1u, delayQueue.Count());
+    ASSERT_EQ(1u, delayQueue.DelayedItemsCount());
+  }
+
+  TEST(ChannelTest, AddAsyncWhenChannelIsFullThenCompletesAfterTake)
+  {
+    const int CAPACITY = 2;
+    Channel<int> channel{CAPACITY};
+    channel.Add(0);
+    channel.Add(1);
+
+    auto addTask = channel.AddAsync(2);
+    ASSERT_FALSE(addTask.IsCompleted());
+
+    auto firstItem = channel.TakeAsync().Result();
+    addTask.Wait();
+    auto remainingItems = channel.TryTakeAll();
+
+    ASSERT_EQ(0, firstItem);
+    ASSERT_EQ((vector<int>{1, 2}), remainingItems);
+  }
+
+  TEST(ChannelTest, TakeAsyncWhenMoreProducersAndConsumersThenEveryItemIsTakenExactlyOnce)
+  {
+    const int CAPACITY = 16;
+    const int PRODUCERS_COUNT = 4;
+    const int CONSUMERS_COUNT = 4;
+    const int ITEMS_PER_PRODUCER = 10000;
+    const int ITEMS_PER_CONSUMER = PRODUCERS_COUNT * ITEMS_PER_PRODUCER / CONSUMERS_COUNT;
+    Channel<int> channel{CAPACITY};
+
+    vector<vector<int>> takenItems(CONSUMERS_COUNT);
+    vector<thread> threads{};
+    for (int consumerIndex = 0; consumerIndex < CONSUMERS_COUNT; ++consumerIndex)
+    {
+      threads.emplace_back([&channel, &consumerItems = takenItems[consumerIndex], ITEMS_PER_CONSUMER]
+      {
+        for (int i = 0; i < ITEMS_PER_CONSUMER; ++i)
+        {
+          consumerItems.push_back(channel.TakeAsync().Result());
+        }
+      });
+    }
+
+    for (int producerIndex = 0; producerIndex < PRODUCERS_COUNT; ++producerIndex)
+    {
+      threads.emplace_back([&channel, producerIndex, ITEMS_PER_PRODUCER]
+      {
+        for (int i = 0; i < ITEMS_PER_PRODUCER; ++i)
+        {
+          channel.AddAsync(producerIndex * ITEMS_PER_PRODUCER + i).Wait();
+        }
+      });
+    }
+
+    for (auto& workerThread : threads)
+    {
+      workerThread.join();
+    }
+
+    vector<int> allTakenItems{};
+    for (const auto& consumerItems : takenItems)
+    {
+      allTakenItems.insert(allTakenItems.end(), consumerItems.begin(), consumerItems.end());
+    }
+
+    sort(allTakenItems.begin(), allTakenItems.end());
+    vector<int> expectedItems(PRODUCERS_COUNT * ITEMS_PER_PRODUCER);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, allTakenItems);
+    ASSERT_TRUE(channel.TryTakeAll().empty());
+  }
+
+  TEST(SelectTest, SelectWhenMoreCollectionsHaveItemsThenTakesOneItemFromFirstCollection)
+  {
+    Channel<int> firstChannel;
+    SimpleAsyncProducerConsumerCollection<int> secondCollection;
+    SpscChannel<int> thirdChannel;
+    secondCollection.Add(20);
+    thirdChannel.Add(30);
+
+    auto firstResult = Select<int>({&firstChannel, &secondCollection, &thirdChannel}).Result();
+    auto secondResult = Select<int>({&firstChannel, &secondCollection, &thirdChannel}).Result();
+
+    ASSERT_EQ(1u, firstResult.Index);
+    ASSERT_EQ(20, firstResult.Item);
+    ASSERT_EQ(2u, secondResult.Index);
+    ASSERT_EQ(30, secondResult.Item);
+  }
+
+  TEST(SelectTest, SelectWhenTakeResumesWaitingProducerThenTakesExactlyOneItem)
+  {
+    const int CAPACITY = 1;
+    Channel<int> firstChannel{CAPACITY};
+    Channel<int> secondChannel{CAPACITY};
+    secondChannel.Add(0);
+    auto addTask = secondChannel.AddAsync(1);
+
+    auto selectResult = Select<int>({&firstChannel, &secondChannel}).Result();
+    addTask.Wait();
+
+    ASSERT_EQ(1u, selectResult.Index);
+    ASSERT_EQ(0, selectResult.Item);
+    ASSERT_EQ((vector<int>{1}), secondChannel.TryTakeAll());
+  }
 }
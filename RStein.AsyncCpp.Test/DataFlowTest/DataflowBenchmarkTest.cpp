@@ -0,0 +1,106 @@
+﻿#include "../../RStein.AsyncCpp/DataFlow/DataFlowSyncFactory.h"
+#include "../../RStein.AsyncCpp/Schedulers/SimpleThreadPool.h"
+#include "../../RStein.AsyncCpp/Schedulers/ThreadPoolScheduler.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <span>
+
+using namespace RStein::AsyncCpp::DataFlow;
+using namespace RStein::AsyncCpp::Schedulers;
+using namespace std;
+
+namespace RStein::AsyncCpp::DataFlowTest
+{
+  //Benchmarks are disabled by default. Run them with the --gtest_also_run_disabled_tests --gtest_filter=DataFlowBenchmark.* arguments.
+  class DataFlowBenchmark : public testing::Test
+  {
+  public:
+    using FloatTransformBlockPtr = typename IInputOutputBlock<float, float>::IInputOutputBlockPtr;
+    static constexpr int ITEMS_COUNT = 1'000'000;
+
+    static float TransformItem(float item)
+    {
+      return item * 1.5f + 0.5f;
+    }
+
+    //Measures the throughput of the block when the input items are waiting in the input queue.
+    template<typename TCreateBlockFunc>
+    static double RunBenchmark(TCreateBlockFunc createBlockFunc, const string& name)
+    {
+      SimpleThreadPool threadPool{1};
+      auto scheduler = make_shared<ThreadPoolScheduler>(threadPool);
+      scheduler->Start();
+      DataFlowBlockOptions options{};
+      options.TaskScheduler = scheduler;
+      FloatTransformBlockPtr transformBlock = createBlockFunc(options);
+
+      auto sum = 0.0;
+      auto processedItemsCount = 0;
+      promise<void> allItemsProcessedPromise{};
+      auto sumAction = DataFlowSyncFactory::CreateActionBlock<float>([&sum, &processedItemsCount, &allItemsProcessedPromise](const float& item)
+                                                                     {
+                                                                       sum += item;
+                                                                       if (++processedItemsCount == ITEMS_COUNT)
+                                                                       {
+                                                                         allItemsProcessedPromise.set_value();
+                                                                       }
+                                                                     });
+      transformBlock->Then(sumAction);
+      transformBlock->Start();
+
+      //Block the scheduler until all input items are added.
+      promise<void> startPromise{};
+      auto startFuture = startPromise.get_future().share();
+      scheduler->EnqueueItem([startFuture]{startFuture.wait();});
+      for (int i = 0; i < ITEMS_COUNT; ++i)
+      {
+        transformBlock->AcceptInputAsync(static_cast<float>(i % 1024));
+      }
+
+      const auto start = chrono::steady_clock::now();
+      startPromise.set_value();
+      allItemsProcessedPromise.get_future().wait();
+      const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+      cout << "\n" << name << ": " << static_cast<long long>(ITEMS_COUNT / elapsed.count()) << " items/s\n";
+
+      transformBlock->Complete();
+      sumAction->Completion().Wait();
+      scheduler->Stop();
+      return sum;
+    }
+  };
+
+  TEST_F(DataFlowBenchmark, DISABLED_FloatTransformPerItemVsBatched)
+  {
+    const auto perItemSum = RunBenchmark([](const DataFlowBlockOptions& options)
+                                         {
+                                           return DataFlowSyncFactory::CreateTransformBlock<float, float>([](const float& item)
+                                                                                                          {
+                                                                                                            return TransformItem(item);
+                                                                                                          },
+                                                                                                          [](auto& _){return true;},
+                                                                                                          options);
+                                         },
+                                         "Per item transform");
+
+    const auto batchedSum = RunBenchmark([](const DataFlowBlockOptions& options)
+                                         {
+                                           return DataFlowSyncFactory::CreateBatchTransformBlock<float, float>([](span<const float> inputItems, span<float> outputItems)
+                                                                                                               {
+                                                                                                                 //Simple loop over contiguous items, vectorized by the compiler.
+                                                                                                                 for (size_t i = 0; i < inputItems.size(); ++i)
+                                                                                                                 {
+                                                                                                                   outputItems[i] = TransformItem(inputItems[i]);
+                                                                                                                 }
+                                                                                                               },
+                                                                                                               BatchTransformBlock<float, float>::DEFAULT_MAX_BATCH_SIZE,
+                                                                                                               [](auto& _){return true;},
+                                                                                                               options);
+                                         },
+                                         "Batched transform");
+
+    ASSERT_DOUBLE_EQ(perItemSum, batchedSum);
+  }
+}
@@ -1,21 +1,121 @@
+#include "../../RStein.AsyncCpp/AsyncPrimitives/AsyncPriorityProducerConsumerCollection.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/AsyncTimer.h"
 #include "../../RStein.AsyncCpp/AsyncPrimitives/FutureEx.h"
+#include "../../RStein.AsyncCpp/AsyncPrimitives/SimpleAsyncProducerConsumerCollection.h"
 #include "../../RStein.AsyncCpp/DataFlow/ActionBlock.h"
+#include "../../RStein.AsyncCpp/DataFlow/BroadcastBlock.h"
+#include "../../RStein.AsyncCpp/DataFlow/BufferBlock.h"
 #include "../../RStein.AsyncCpp/DataFlow/DataflowAsyncFactory.h"
 #include "../../RStein.AsyncCpp/DataFlow/DataFlowSyncFactory.h"
+#include "../../RStein.AsyncCpp/DataFlow/JoinBlock.h"
 #include "../../RStein.AsyncCpp/DataFlow/TransformBlock.h"
+#include "../../RStein.AsyncCpp/DataFlow/TransformManyBlock.h"
+#include "../../RStein.AsyncCpp/Schedulers/SimpleThreadPool.h"
+#include "../../RStein.AsyncCpp/Schedulers/ThreadPoolScheduler.h"
 #include "../../RStein.AsyncCpp/Tasks/Task.h"
 #include "../../RStein.AsyncCpp/Tasks/TaskCombinators.h"
 #include "../../RStein.AsyncCpp/Tasks/TaskCompletionSource.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <thread>
+#include <tuple>
 #include <vector>
 using namespace std;
 
 using namespace RStein::AsyncCpp::DataFlow;
 using namespace RStein::AsyncCpp::AsyncPrimitives;
+using namespace RStein::AsyncCpp::Schedulers;
 using namespace std;
 
 namespace RStein::AsyncCpp::DataFlowTest
 {
+  template<typename TInputItem>
+  class RejectingInputBlock : public IInputBlock<TInputItem>
+  {
+  public:
+    //Accepts the first acceptedItemsCount items, the next items are rejected.
+    explicit RejectingInputBlock(size_t acceptedItemsCount = 0) : _completionTcs{},
+                                                                 _acceptedItemsCount{acceptedItemsCount}
+    {
+    }
+
+    [[nodiscard]] std::string Name() const override
+    {
+      return "RejectingInputBlock";
+    }
+
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override
+    {
+      return _completionTcs.GetTask();
+    }
+
+    void Start() override
+    {
+    }
+
+    void Complete() override
+    {
+      _completionTcs.TrySetResult();
+    }
+
+    IDataFlowBlock::TaskVoidType CompleteAsync() override
+    {
+      Complete();
+      return Completion();
+    }
+
+    void SetFaulted(std::exception_ptr exception) override
+    {
+      _completionTcs.TrySetException(exception);
+    }
+
+    bool CanAcceptInput(const TInputItem& item) override
+    {
+      return true;
+    }
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override
+    {
+      return acceptOrReject();
+    }
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override
+    {
+      return acceptOrReject();
+    }
+
+    [[nodiscard]] size_t PendingInputCount() const override
+    {
+      return 0;
+    }
+
+  private:
+    IDataFlowBlock::PromiseVoidType _completionTcs;
+    atomic<size_t> _acceptedItemsCount;
+
+    IDataFlowBlock::TaskVoidType acceptOrReject()
+    {
+      auto acceptedItemsCount = _acceptedItemsCount.load();
+      while (acceptedItemsCount > 0)
+      {
+        if (_acceptedItemsCount.compare_exchange_weak(acceptedItemsCount, acceptedItemsCount - 1))
+        {
+          return Tasks::GetCompletedTask();
+        }
+      }
+
+      return Tasks::TaskFromException<void>(make_exception_ptr(logic_error("Input rejected.")));
+    }
+  };
+
   class DataFlowTest : public testing::Test
   {
   public:
@@ -269,6 +369,1509 @@ namespace RStein::AsyncCpp::DataFlowTest
     ASSERT_EQ(EXPECTED_PROCESSED_ITEMS, processedItemsCount);
   }
 
+  TEST_F(DataFlowTest, WhenPropagationWindowIsLargerThanOneThenAllInputsProcessed)
+  {
+    const int EXPECTED_PROCESSED_ITEMS = 1000;
+    DataFlowBlockOptions options{};
+    options.MaxPropagationWindow = 8;
+    auto transform1 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item * 2;
+                                                                          },
+                                                                          [](auto& _){return true;},
+                                                                          options);
+
+    auto transform2 = DataFlowSyncFactory::CreateTransformBlock<int, string>([](const int& item)
+                                                                             {
+                                                                               return to_string(item);
+                                                                             },
+                                                                             [](auto& _){return true;},
+                                                                             options);
+
+    vector<string> _processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<string>([&_processedItems](const string& item)
+                                                                      {
+                                                                        _processedItems.push_back(item);
+                                                                      });
+
+    transform1->Then(transform2)
+              ->Then(finalAction);
+
+    transform1->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    transform1->Complete();
+    finalAction->Completion().Wait();
+    const auto processedItemsCount = _processedItems.size();
+
+    ASSERT_EQ(EXPECTED_PROCESSED_ITEMS, processedItemsCount);
+  }
+
+  TEST_F(DataFlowTest, WhenLinkedBlockRejectsInputThenBlockIsFaulted)
+  {
+    auto transform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                         {
+                                                                           return item;
+                                                                         });
+    auto rejectingBlock = std::make_shared<RejectingInputBlock<int>>();
+    transform->ConnectTo(rejectingBlock);
+
+    transform->Start();
+    transform->AcceptInputAsync(1).Wait();
+
+    ASSERT_THROW(transform->Completion().Wait(), logic_error);
+    ASSERT_THROW(rejectingBlock->Completion().Wait(), logic_error);
+  }
+
+  TEST_F(DataFlowTest, WhenRoundRobinLinksThenInputsAreDistributedEvenly)
+  {
+    const int WORKERS_COUNT = 3;
+    const int ITEMS_PER_WORKER = 100;
+    auto transform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                         {
+                                                                           return item;
+                                                                         });
+
+    vector<vector<int>> workerItems(WORKERS_COUNT);
+    vector<IInputBlock<int>::InputBlockPtr> workers{};
+    for (auto& items : workerItems)
+    {
+      auto worker = DataFlowSyncFactory::CreateActionBlock<int>([&items](const int& item)
+                                                                {
+                                                                  items.push_back(item);
+                                                                });
+      transform->ConnectTo(worker, DataFlowLinkOptions<int>::RoundRobin());
+      workers.push_back(worker);
+    }
+
+    transform->Start();
+    for (int i = 0; i < WORKERS_COUNT * ITEMS_PER_WORKER; ++i)
+    {
+      transform->AcceptInputAsync(i).Wait();
+    }
+
+    transform->Complete();
+    for (auto& worker : workers)
+    {
+      worker->Completion().Wait();
+    }
+
+    for (auto& items : workerItems)
+    {
+      ASSERT_EQ(ITEMS_PER_WORKER, items.size());
+    }
+  }
+
+  TEST_F(DataFlowTest, WhenHashPartitionedLinksThenInputsWithSameKeyAreProcessedBySameBlock)
+  {
+    const int WORKERS_COUNT = 4;
+    const int KEYS_COUNT = 10;
+    const int EXPECTED_PROCESSED_ITEMS = 1000;
+    auto transform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                         {
+                                                                           return item;
+                                                                         });
+
+    vector<vector<int>> workerItems(WORKERS_COUNT);
+    vector<IInputBlock<int>::InputBlockPtr> workers{};
+    for (auto& items : workerItems)
+    {
+      auto worker = DataFlowSyncFactory::CreateActionBlock<int>([&items](const int& item)
+                                                                {
+                                                                  items.push_back(item);
+                                                                });
+      transform->ConnectTo(worker, DataFlowLinkOptions<int>::HashPartitioned([](const int& item)
+                                                                             {
+                                                                               return static_cast<size_t>(item % KEYS_COUNT);
+                                                                             }));
+      workers.push_back(worker);
+    }
+
+    transform->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      transform->AcceptInputAsync(i).Wait();
+    }
+
+    transform->Complete();
+    for (auto& worker : workers)
+    {
+      worker->Completion().Wait();
+    }
+
+    size_t processedItemsCount = 0;
+    vector<int> keyWorkers(KEYS_COUNT, -1);
+    for (int workerIndex = 0; workerIndex < WORKERS_COUNT; ++workerIndex)
+    {
+      for (auto item : workerItems[workerIndex])
+      {
+        auto& keyWorker = keyWorkers[item % KEYS_COUNT];
+        ASSERT_TRUE(keyWorker == -1 || keyWorker == workerIndex);
+        keyWorker = workerIndex;
+      }
+
+      processedItemsCount += workerItems[workerIndex].size();
+    }
+
+    ASSERT_EQ(EXPECTED_PROCESSED_ITEMS, processedItemsCount);
+  }
+
+  TEST_F(DataFlowTest, WhenHashPartitionedBlockDoesNotAcceptInputThenInputIsSkippedAndNotSentToOtherBlock)
+  {
+    const int WORKERS_COUNT = 2;
+    const int EXPECTED_PROCESSED_ITEMS = 100;
+    auto transform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                         {
+                                                                           return item;
+                                                                         });
+
+    vector<vector<int>> workerItems(WORKERS_COUNT);
+    vector<IInputBlock<int>::InputBlockPtr> workers{};
+    for (int workerIndex = 0; workerIndex < WORKERS_COUNT; ++workerIndex)
+    {
+      auto& items = workerItems[workerIndex];
+      auto worker = DataFlowSyncFactory::CreateActionBlock<int>([&items](const int& item)
+                                                                {
+                                                                  items.push_back(item);
+                                                                },
+                                                                [workerIndex](const int& item)
+                                                                {
+                                                                  return workerIndex != 0;
+                                                                });
+      transform->ConnectTo(worker, DataFlowLinkOptions<int>::HashPartitioned([](const int& item)
+                                                                             {
+                                                                               return static_cast<size_t>(item % WORKERS_COUNT);
+                                                                             }));
+      workers.push_back(worker);
+    }
+
+    transform->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      transform->AcceptInputAsync(i).Wait();
+    }
+
+    transform->Complete();
+    for (auto& worker : workers)
+    {
+      worker->Completion().Wait();
+    }
+
+    ASSERT_TRUE(workerItems[0].empty());
+    ASSERT_EQ(static_cast<size_t>(EXPECTED_PROCESSED_ITEMS / WORKERS_COUNT), workerItems[1].size());
+    ASSERT_TRUE(all_of(workerItems[1].begin(), workerItems[1].end(), [](int item)
+    {
+      return item % WORKERS_COUNT == 1;
+    }));
+  }
+
+  TEST_F(DataFlowTest, WhenBroadcastLinksChangeAtRuntimeThenInputsAreSentToCurrentLinks)
+  {
+    const int ITEMS_PER_PHASE = 10;
+    auto transform = std::make_shared<TransformBlock<int, int>>([](const int& item, Detail::NoState*& _)
+                                                                {
+                                                                  return item;
+                                                                });
+
+    atomic<int> processedItemsCount{};
+    vector<vector<int>> workerItems(2);
+    vector<IInputBlock<int>::InputBlockPtr> workers{};
+    for (auto& items : workerItems)
+    {
+      workers.push_back(DataFlowSyncFactory::CreateActionBlock<int>([&items, &processedItemsCount](const int& item)
+                                                                    {
+                                                                      items.push_back(item);
+                                                                      ++processedItemsCount;
+                                                                    }));
+    }
+
+    const auto sendPhaseItems = [&transform, &processedItemsCount, ITEMS_PER_PHASE](int phase, int expectedProcessedItemsCount)
+    {
+      for (int i = phase * ITEMS_PER_PHASE; i < (phase + 1) * ITEMS_PER_PHASE; ++i)
+      {
+        transform->AcceptInputAsync(i).Wait();
+      }
+
+      while (processedItemsCount.load() != expectedProcessedItemsCount)
+      {
+        this_thread::yield();
+      }
+    };
+
+    transform->ConnectTo(workers[0]);
+    transform->Start();
+    sendPhaseItems(0, ITEMS_PER_PHASE);
+
+    workers[1]->Start();
+    transform->ConnectTo(workers[1]);
+    sendPhaseItems(1, 3 * ITEMS_PER_PHASE);
+
+    transform->DisconnectFrom(workers[0]);
+    sendPhaseItems(2, 4 * ITEMS_PER_PHASE);
+
+    transform->Complete();
+    workers[1]->Completion().Wait();
+    workers[0]->Complete();
+    workers[0]->Completion().Wait();
+
+    vector<int> expectedFirstWorkerItems(2 * ITEMS_PER_PHASE);
+    iota(expectedFirstWorkerItems.begin(), expectedFirstWorkerItems.end(), 0);
+    vector<int> expectedSecondWorkerItems(2 * ITEMS_PER_PHASE);
+    iota(expectedSecondWorkerItems.begin(), expectedSecondWorkerItems.end(), ITEMS_PER_PHASE);
+    ASSERT_EQ(expectedFirstWorkerItems, workerItems[0]);
+    ASSERT_EQ(expectedSecondWorkerItems, workerItems[1]);
+  }
+
+  TEST_F(DataFlowTest, WhenRoundRobinLinksChangeAtRuntimeThenInputsAreDistributedToCurrentLinks)
+  {
+    auto transform = std::make_shared<TransformBlock<int, int>>([](const int& item, Detail::NoState*& _)
+                                                                {
+                                                                  return item;
+                                                                });
+
+    atomic<int> processedItemsCount{};
+    vector<vector<int>> workerItems(3);
+    vector<IInputBlock<int>::InputBlockPtr> workers{};
+    for (auto& items : workerItems)
+    {
+      workers.push_back(DataFlowSyncFactory::CreateActionBlock<int>([&items, &processedItemsCount](const int& item)
+                                                                    {
+                                                                      items.push_back(item);
+                                                                      ++processedItemsCount;
+                                                                    }));
+    }
+
+    int nextItem = 0;
+    const auto sendItems = [&transform, &processedItemsCount, &nextItem](int itemsCount)
+    {
+      for (int i = 0; i < itemsCount; ++i)
+      {
+        transform->AcceptInputAsync(nextItem++).Wait();
+      }
+
+      while (processedItemsCount.load() != nextItem)
+      {
+        this_thread::yield();
+      }
+    };
+
+    transform->ConnectTo(workers[0], DataFlowLinkOptions<int>::RoundRobin());
+    transform->ConnectTo(workers[1], DataFlowLinkOptions<int>::RoundRobin());
+    transform->Start();
+    sendItems(10);
+
+    workers[2]->Start();
+    transform->ConnectTo(workers[2], DataFlowLinkOptions<int>::RoundRobin());
+    sendItems(9);
+
+    transform->DisconnectFrom(workers[0]);
+    sendItems(8);
+
+    transform->Complete();
+    workers[1]->Completion().Wait();
+    workers[2]->Completion().Wait();
+    workers[0]->Complete();
+    workers[0]->Completion().Wait();
+
+    ASSERT_EQ(8, workerItems[0].size());
+    ASSERT_EQ(12, workerItems[1].size());
+    ASSERT_EQ(7, workerItems[2].size());
+  }
+
+  TEST_F(DataFlowTest, WhenLeastQueuedLinksThenEveryInputIsProcessedOnce)
+  {
+    const int WORKERS_COUNT = 4;
+    const int EXPECTED_PROCESSED_ITEMS = 1000;
+    auto transform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                         {
+                                                                           return item;
+                                                                         });
+
+    vector<vector<int>> workerItems(WORKERS_COUNT);
+    vector<IInputBlock<int>::InputBlockPtr> workers{};
+    for (auto& items : workerItems)
+    {
+      auto worker = DataFlowSyncFactory::CreateActionBlock<int>([&items](const int& item)
+                                                                {
+                                                                  items.push_back(item);
+                                                                });
+      transform->Then(worker, DataFlowLinkOptions<int>::LeastQueued());
+      workers.push_back(worker);
+    }
+
+    transform->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      transform->AcceptInputAsync(i).Wait();
+    }
+
+    transform->Complete();
+    for (auto& worker : workers)
+    {
+      worker->Completion().Wait();
+    }
+
+    vector<int> processedItems{};
+    for (auto& items : workerItems)
+    {
+      processedItems.insert(processedItems.end(), items.begin(), items.end());
+    }
+
+    sort(processedItems.begin(), processedItems.end());
+    vector<int> expectedItems(EXPECTED_PROCESSED_ITEMS);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, ConnectToWhenPartitionedLinksUseDifferentModesThenThrowsLogicError)
+  {
+    auto transform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                         {
+                                                                           return item;
+                                                                         });
+    auto worker1 = DataFlowSyncFactory::CreateActionBlock<int>([](const int& item){});
+    auto worker2 = DataFlowSyncFactory::CreateActionBlock<int>([](const int& item){});
+    transform->ConnectTo(worker1, DataFlowLinkOptions<int>::RoundRobin());
+
+    ASSERT_THROW(transform->ConnectTo(worker2, DataFlowLinkOptions<int>::LeastQueued()), logic_error);
+
+    transform->Start();
+    worker2->Start();
+    transform->Complete();
+    worker2->Complete();
+  }
+
+  TEST_F(DataFlowTest, WhenLinearChainOfSyncBlocksThenBlocksProcessItemInSameThread)
+  {
+    const int ITEMS_COUNT = 100;
+    auto transform1 = DataFlowSyncFactory::CreateTransformBlock<int, thread::id>([](const int& item)
+                                                                                 {
+                                                                                   return this_thread::get_id();
+                                                                                 });
+    auto transform2 = DataFlowSyncFactory::CreateTransformBlock<thread::id, bool>([](const thread::id& threadId)
+                                                                                  {
+                                                                                    return threadId == this_thread::get_id();
+                                                                                  });
+    auto sameThreadCount = 0;
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<bool>([&sameThreadCount](const bool& isSameThread)
+                                                                    {
+                                                                      if (isSameThread)
+                                                                      {
+                                                                        sameThreadCount++;
+                                                                      }
+                                                                    });
+    transform1->Then(transform2)
+              ->Then(finalAction);
+
+    transform1->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    transform1->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(ITEMS_COUNT, sameThreadCount);
+  }
+
+  TEST_F(DataFlowTest, WhenTransformInLinearChainFailsThenFailedBlockAndNextBlocksAreFaulted)
+  {
+    const int ITEMS_COUNT = 10;
+    const int FAILING_ITEM = 5;
+    auto transform1 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    auto transform2 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            if (item == FAILING_ITEM)
+                                                                            {
+                                                                              throw invalid_argument("item");
+                                                                            }
+
+                                                                            return item;
+                                                                          });
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   });
+    transform1->Then(transform2)
+              ->Then(finalAction);
+
+    transform1->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    transform1->Complete();
+    transform1->Completion().Wait();
+
+    ASSERT_THROW(transform2->Completion().Wait(), invalid_argument);
+    ASSERT_THROW(finalAction->Completion().Wait(), invalid_argument);
+    vector<int> expectedItems(FAILING_ITEM);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenBlocksUseSchedulersThenItemsAreProcessedInTheSchedulerOfTheBlock)
+  {
+    const int ITEMS_COUNT = 100;
+    SimpleThreadPool ioThreadPool{2};
+    SimpleThreadPool cpuThreadPool{2};
+    auto ioScheduler = std::make_shared<ThreadPoolScheduler>(ioThreadPool);
+    auto cpuScheduler = std::make_shared<ThreadPoolScheduler>(cpuThreadPool);
+    ioScheduler->Start();
+    cpuScheduler->Start();
+
+    DataFlowBlockOptions ioOptions{};
+    ioOptions.TaskScheduler = ioScheduler;
+    auto ioTransform = DataFlowSyncFactory::CreateTransformBlock<int, bool>([ioScheduler](const int& item)
+                                                                            {
+                                                                              return Scheduler::CurrentScheduler() == ioScheduler;
+                                                                            },
+                                                                            [](auto& _){return true;},
+                                                                            ioOptions);
+    DataFlowBlockOptions cpuOptions{};
+    cpuOptions.TaskScheduler = cpuScheduler;
+    auto inSchedulerCount = 0;
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<bool>([cpuScheduler, &inSchedulerCount](const bool& isIoTransformInScheduler)
+                                                                    {
+                                                                      if (isIoTransformInScheduler && Scheduler::CurrentScheduler() == cpuScheduler)
+                                                                      {
+                                                                        inSchedulerCount++;
+                                                                      }
+                                                                    },
+                                                                    [](auto& _){return true;},
+                                                                    cpuOptions);
+    auto linkOptions = DataFlowLinkOptions<bool>::Broadcast();
+    linkOptions.TaskScheduler = cpuScheduler;
+    ioTransform->ConnectTo(finalAction, linkOptions);
+
+    ioTransform->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      ioTransform->AcceptInputAsync(i).Wait();
+    }
+
+    ioTransform->Complete();
+    finalAction->Completion().Wait();
+    ioScheduler->Stop();
+    cpuScheduler->Stop();
+
+    ASSERT_EQ(ITEMS_COUNT, inSchedulerCount);
+  }
+
+  TEST_F(DataFlowTest, WhenLinkWithoutSchedulerFollowsLinkWithSchedulerThenItemsAreNotDeliveredInSchedulerOfOtherLink)
+  {
+    const int ITEMS_COUNT = 100;
+    SimpleThreadPool ioThreadPool{2};
+    SimpleThreadPool cpuThreadPool{2};
+    auto ioScheduler = std::make_shared<ThreadPoolScheduler>(ioThreadPool);
+    auto cpuScheduler = std::make_shared<ThreadPoolScheduler>(cpuThreadPool);
+    ioScheduler->Start();
+    cpuScheduler->Start();
+
+    DataFlowBlockOptions ioOptions{};
+    ioOptions.TaskScheduler = ioScheduler;
+    auto ioTransform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                           {
+                                                                             return item;
+                                                                           },
+                                                                           [](auto& _){return true;},
+                                                                           ioOptions);
+    auto cpuAction = DataFlowSyncFactory::CreateActionBlock<int>([](const int& _)
+                                                                 {
+                                                                 });
+    //CanAcceptInput runs in the thread which delivers the item.
+    auto inIoSchedulerCount = 0;
+    auto unscheduledAction = DataFlowSyncFactory::CreateActionBlock<int>([](const int& _)
+                                                                         {
+                                                                         },
+                                                                         [ioScheduler, &inIoSchedulerCount](const int& _)
+                                                                         {
+                                                                           if (Scheduler::CurrentScheduler() == ioScheduler)
+                                                                           {
+                                                                             inIoSchedulerCount++;
+                                                                           }
+
+                                                                           return true;
+                                                                         });
+    auto cpuLinkOptions = DataFlowLinkOptions<int>::Broadcast();
+    cpuLinkOptions.TaskScheduler = cpuScheduler;
+    ioTransform->ConnectTo(cpuAction, cpuLinkOptions);
+    ioTransform->ConnectTo(unscheduledAction);
+
+    ioTransform->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      ioTransform->AcceptInputAsync(i).Wait();
+    }
+
+    ioTransform->Complete();
+    cpuAction->Completion().Wait();
+    unscheduledAction->Completion().Wait();
+    ioScheduler->Stop();
+    cpuScheduler->Stop();
+
+    ASSERT_EQ(ITEMS_COUNT, inIoSchedulerCount);
+  }
+
+  TEST_F(DataFlowTest, WhenBatchBlockIsCompletedThenAllInputsAreProcessedInBatches)
+  {
+    const int BATCH_SIZE = 10;
+    const int EXPECTED_PROCESSED_ITEMS = 95;
+    auto batchBlock = DataFlowSyncFactory::CreateBatchBlock<int>(BATCH_SIZE);
+
+    vector<vector<int>> batches{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<vector<int>>([&batches](const vector<int>& batch)
+                                                                           {
+                                                                             batches.push_back(batch);
+                                                                           });
+    batchBlock->Then(finalAction);
+
+    batchBlock->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      batchBlock->AcceptInputAsync(i).Wait();
+    }
+
+    batchBlock->Complete();
+    finalAction->Completion().Wait();
+
+    vector<int> processedItems{};
+    for (auto& batch : batches)
+    {
+      ASSERT_LE(batch.size(), BATCH_SIZE);
+      processedItems.insert(processedItems.end(), batch.begin(), batch.end());
+    }
+
+    vector<int> expectedItems(EXPECTED_PROCESSED_ITEMS);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(EXPECTED_PROCESSED_ITEMS / BATCH_SIZE + 1, batches.size());
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenBatchMaxLatencyElapsedThenPartialBatchIsProcessed)
+  {
+    const int BATCH_SIZE = 100;
+    const int EXPECTED_PROCESSED_ITEMS = 3;
+    auto batchBlock = DataFlowSyncFactory::CreateBatchBlock<int>(BATCH_SIZE, chrono::milliseconds{10});
+
+    promise<vector<int>> batchPromise{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<vector<int>>([&batchPromise](const vector<int>& batch)
+                                                                           {
+                                                                             batchPromise.set_value(batch);
+                                                                           });
+    batchBlock->Then(finalAction);
+
+    batchBlock->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      batchBlock->AcceptInputAsync(i).Wait();
+    }
+
+    auto batchFuture = batchPromise.get_future();
+    const auto batchStatus = batchFuture.wait_for(chrono::seconds{10});
+    batchBlock->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(future_status::ready, batchStatus);
+    ASSERT_EQ(EXPECTED_PROCESSED_ITEMS, batchFuture.get().size());
+  }
+
+  TEST_F(DataFlowTest, WhenBatchMaxLatencyElapsedThenTimeoutIsNotPendingInput)
+  {
+    const int BATCH_SIZE = 100;
+    auto batchBlock = DataFlowSyncFactory::CreateBatchBlock<int>(BATCH_SIZE, chrono::milliseconds{10});
+
+    promise<size_t> pendingInputCountPromise{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<vector<int>>([&pendingInputCountPromise, &batchBlock](const vector<int>& _)
+                                                                           {
+                                                                             pendingInputCountPromise.set_value(batchBlock->PendingInputCount());
+                                                                           });
+    batchBlock->Then(finalAction);
+
+    batchBlock->Start();
+    batchBlock->AcceptInputAsync(1).Wait();
+
+    auto pendingInputCountFuture = pendingInputCountPromise.get_future();
+    const auto batchStatus = pendingInputCountFuture.wait_for(chrono::seconds{10});
+    batchBlock->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(future_status::ready, batchStatus);
+    ASSERT_EQ(0, pendingInputCountFuture.get());
+  }
+
+  TEST_F(DataFlowTest, WhenBatchIsSentBeforeMaxLatencyElapsedThenBatchTimeoutIsNotPending)
+  {
+    const int BATCH_SIZE = 10;
+    const int BATCHES_COUNT = 20;
+    const auto timer = AsyncTimer::DefaultTimer();
+    const auto pendingDelaysCountBefore = timer->PendingDelaysCount();
+    auto batchBlock = DataFlowSyncFactory::CreateBatchBlock<int>(BATCH_SIZE, chrono::hours{1});
+
+    size_t batchesCount = 0;
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<vector<int>>([&batchesCount](const vector<int>& _)
+                                                                           {
+                                                                             batchesCount++;
+                                                                           });
+    batchBlock->Then(finalAction);
+
+    batchBlock->Start();
+    for (int i = 0; i < BATCH_SIZE * BATCHES_COUNT; ++i)
+    {
+      batchBlock->AcceptInputAsync(i).Wait();
+    }
+
+    batchBlock->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(BATCHES_COUNT, batchesCount);
+    ASSERT_EQ(pendingDelaysCountBefore, timer->PendingDelaysCount());
+  }
+
+  TEST_F(DataFlowTest, WhenBatchTransformBlockThenAllInputsAreTransformedInOrder)
+  {
+    const int ITEMS_COUNT = 1000;
+    auto batchTransform = DataFlowSyncFactory::CreateBatchTransformBlock<int, int>([](span<const int> inputItems, span<int> outputItems)
+                                                                                   {
+                                                                                     transform(inputItems.begin(), inputItems.end(), outputItems.begin(), [](int item)
+                                                                                     {
+                                                                                       return item * 2;
+                                                                                     });
+                                                                                   },
+                                                                                   16);
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   });
+    batchTransform->Then(finalAction);
+
+    batchTransform->Start();
+    vector<int> expectedItems{};
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      batchTransform->AcceptInputAsync(i);
+      expectedItems.push_back(i * 2);
+    }
+
+    batchTransform->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenTumblingWindowBlockByCountThenEveryWindowIsAggregated)
+  {
+    const int ITEMS_COUNT = 25;
+    const int WINDOW_SIZE = 10;
+    auto windowBlock = DataFlowSyncFactory::CreateTumblingWindowBlock<int, int>(DataFlowWindowOptions<int>::ByCount(WINDOW_SIZE),
+                                                                                [](int& sum, const int& item)
+                                                                                {
+                                                                                  sum += item;
+                                                                                });
+    vector<int> windowSums{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&windowSums](const int& windowSum)
+                                                                   {
+                                                                     windowSums.push_back(windowSum);
+                                                                   });
+    windowBlock->Then(finalAction);
+
+    windowBlock->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      windowBlock->AcceptInputAsync(i).Wait();
+    }
+
+    windowBlock->Complete();
+    finalAction->Completion().Wait();
+
+    //Partial window is sent when the block is completed.
+    const vector<int> expectedWindowSums{45, 145, 110};
+    ASSERT_EQ(expectedWindowSums, windowSums);
+  }
+
+  TEST_F(DataFlowTest, WhenSlidingWindowBlockByTimeThenItemsOutsideWindowAreRemoved)
+  {
+    using TimedItem = pair<chrono::milliseconds, int>;
+    auto windowBlock = DataFlowSyncFactory::CreateSlidingWindowBlock<TimedItem, int>(DataFlowWindowOptions<TimedItem>::ByTime(100ms, [](const TimedItem& item)
+                                                                                     {
+                                                                                       return item.first;
+                                                                                     }),
+                                                                                     [](int& sum, const TimedItem& item)
+                                                                                     {
+                                                                                       sum += item.second;
+                                                                                     },
+                                                                                     [](int& sum, const TimedItem& item)
+                                                                                     {
+                                                                                       sum -= item.second;
+                                                                                     });
+    vector<int> windowSums{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&windowSums](const int& windowSum)
+                                                                   {
+                                                                     windowSums.push_back(windowSum);
+                                                                   });
+    windowBlock->Then(finalAction);
+
+    windowBlock->Start();
+    windowBlock->AcceptInputAsync(TimedItem{0ms, 1}).Wait();
+    windowBlock->AcceptInputAsync(TimedItem{50ms, 2}).Wait();
+    windowBlock->AcceptInputAsync(TimedItem{100ms, 4}).Wait();
+    windowBlock->AcceptInputAsync(TimedItem{120ms, 8}).Wait();
+    windowBlock->AcceptInputAsync(TimedItem{300ms, 16}).Wait();
+    windowBlock->Complete();
+    finalAction->Completion().Wait();
+
+    const vector<int> expectedWindowSums{1, 3, 6, 14, 16};
+    ASSERT_EQ(expectedWindowSums, windowSums);
+  }
+
+  TEST_F(DataFlowTest, WhenKeyedTransformBlockThenItemsWithSameKeyAreProcessedInOrderWithKeyState)
+  {
+    const int LANES_COUNT = 4;
+    const int KEYS_COUNT = 10;
+    const int ITEMS_PER_KEY_COUNT = 100;
+    using KeyCount = pair<int, int>;
+    auto countBlock = DataFlowSyncFactory::CreateKeyedTransformBlock<int, KeyCount, int, int>(LANES_COUNT,
+                                                                                              [](const int& item)
+                                                                                              {
+                                                                                                return item % KEYS_COUNT;
+                                                                                              },
+                                                                                              [](const int& item, int& keyCount)
+                                                                                              {
+                                                                                                return KeyCount{item % KEYS_COUNT, ++keyCount};
+                                                                                              });
+    map<int, vector<int>> keyCounts{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<KeyCount>([&keyCounts](const KeyCount& keyCount)
+                                                                        {
+                                                                          keyCounts[keyCount.first].push_back(keyCount.second);
+                                                                        });
+    countBlock->Then(finalAction);
+
+    countBlock->Start();
+    for (int i = 0; i < KEYS_COUNT * ITEMS_PER_KEY_COUNT; ++i)
+    {
+      countBlock->AcceptInputAsync(i).Wait();
+    }
+    countBlock->Complete();
+    finalAction->Completion().Wait();
+
+    vector<int> expectedKeyCounts(ITEMS_PER_KEY_COUNT);
+    iota(expectedKeyCounts.begin(), expectedKeyCounts.end(), 1);
+    ASSERT_EQ(KEYS_COUNT, keyCounts.size());
+    for (const auto& [key, counts] : keyCounts)
+    {
+      ASSERT_EQ(expectedKeyCounts, counts);
+    }
+  }
+
+  TEST_F(DataFlowTest, WhenCompleteAsyncCalledInSchedulerOfBlockThenAllInputsAreProcessed)
+  {
+    const int ITEMS_COUNT = 100;
+    SimpleThreadPool threadPool{1};
+    auto scheduler = make_shared<ThreadPoolScheduler>(threadPool);
+    scheduler->Start();
+    DataFlowBlockOptions options{};
+    options.TaskScheduler = scheduler;
+    auto transformBlock = DataFlowAsyncFactory::CreateTransformBlock<int, int>([](const int& item)-> Tasks::Task<int>
+                                                                               {
+                                                                                 co_await Tasks::GetCompletedTask();
+                                                                                 co_return item * 2;
+                                                                               },
+                                                                               [](auto& _){return true;},
+                                                                               options);
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   },
+                                                                   [](auto& _){return true;},
+                                                                   options);
+    transformBlock->Then(finalAction);
+
+    transformBlock->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      transformBlock->AcceptInputAsync(i).Wait();
+    }
+
+    //Complete would wait for the processing loop which needs the only thread of the scheduler.
+    promise<void> completeCalledPromise{};
+    scheduler->EnqueueItem([&transformBlock, &completeCalledPromise]
+    {
+      transformBlock->CompleteAsync();
+      completeCalledPromise.set_value();
+    });
+    completeCalledPromise.get_future().wait();
+    finalAction->Completion().Wait();
+    scheduler->Stop();
+
+    vector<int> expectedItems(ITEMS_COUNT);
+    generate(expectedItems.begin(), expectedItems.end(), [i = 0]() mutable { return 2 * i++; });
+    ASSERT_EQ(expectedItems, processedItems);
+    ASSERT_TRUE(transformBlock->Completion().IsCompleted());
+  }
+
+  TEST_F(DataFlowTest, WhenThrottleBlockThenItemsArePassedAtConfiguredRate)
+  {
+    const int ITEMS_COUNT = 20;
+    const int BURST_SIZE = 5;
+    const auto TOKEN_INTERVAL = 10ms;
+    auto throttleBlock = DataFlowSyncFactory::CreateThrottleBlock<int>(1, TOKEN_INTERVAL, BURST_SIZE, 2);
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   });
+    throttleBlock->Then(finalAction);
+
+    throttleBlock->Start();
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      throttleBlock->AcceptInputAsync(i).Wait();
+      //Bounded capacity slows down the producer.
+      ASSERT_LE(throttleBlock->PendingInputCount(), 2);
+    }
+    throttleBlock->Complete();
+    finalAction->Completion().Wait();
+    const auto elapsed = chrono::steady_clock::now() - start;
+
+    vector<int> expectedItems(ITEMS_COUNT);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, processedItems);
+    ASSERT_GE(elapsed, (ITEMS_COUNT - BURST_SIZE) * TOKEN_INTERVAL);
+  }
+
+  TEST_F(DataFlowTest, WhenThrottleBlockFaultsThenWaitingProducerThrows)
+  {
+    const int BOUNDED_CAPACITY = 2;
+    auto throttleBlock = DataFlowSyncFactory::CreateThrottleBlock<int>(1, 500ms, 1, BOUNDED_CAPACITY);
+    //The first item is delivered, the delivery of the second item faults the block.
+    auto rejectingBlock = std::make_shared<RejectingInputBlock<int>>(1);
+    throttleBlock->ConnectTo(rejectingBlock);
+
+    throttleBlock->Start();
+    //The rejected item waits for the token, the next item stays in the input queue and its slot is never released.
+    for (int i = 0; i <= BOUNDED_CAPACITY; ++i)
+    {
+      throttleBlock->AcceptInputAsync(i).Wait();
+    }
+
+    auto waitingProducerTask = throttleBlock->AcceptInputAsync(BOUNDED_CAPACITY + 1);
+    const auto isProducerWaiting = !waitingProducerTask.IsCompleted();
+    auto waitingProducerPromise = make_shared<promise<bool>>();
+    waitingProducerTask.ContinueWith([waitingProducerPromise](const auto& completedTask)
+    {
+      waitingProducerPromise->set_value(completedTask.IsFaulted());
+    });
+
+    auto waitingProducerFuture = waitingProducerPromise->get_future();
+    const auto waitingProducerStatus = waitingProducerFuture.wait_for(chrono::seconds{10});
+
+    ASSERT_TRUE(isProducerWaiting);
+    ASSERT_EQ(future_status::ready, waitingProducerStatus);
+    ASSERT_TRUE(waitingProducerFuture.get());
+    ASSERT_THROW(waitingProducerTask.Wait(), logic_error);
+    ASSERT_THROW(throttleBlock->Completion().Wait(), logic_error);
+  }
+
+  TEST_F(DataFlowTest, WhenBlockUsesSpscInputForSinglePredecessorThenAllInputsProcessedInOrder)
+  {
+    const int ITEMS_COUNT = 1000;
+    auto transformBlock = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                              {
+                                                                                return item * 2;
+                                                                              });
+    DataFlowBlockOptions options{};
+    options.UseSpscInputForSinglePredecessor = true;
+    options.SpscInputCapacity = 4;
+    vector<int> processedItems{};
+    //Async block is not fused with the predecessor, so the items pass through the input queue.
+    auto finalAction = DataFlowAsyncFactory::CreateActionBlock<int>([&processedItems](const int& item)-> Tasks::Task<void>
+                                                                    {
+                                                                      co_await Tasks::GetCompletedTask();
+                                                                      processedItems.push_back(item);
+                                                                    },
+                                                                    [](auto& _){return true;},
+                                                                    options);
+    transformBlock->Then(finalAction);
+
+    transformBlock->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      transformBlock->AcceptInputAsync(i).Wait();
+    }
+    transformBlock->Complete();
+    finalAction->Completion().Wait();
+
+    vector<int> expectedItems(ITEMS_COUNT);
+    generate(expectedItems.begin(), expectedItems.end(), [i = 0]() mutable { return 2 * i++; });
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, AcceptInputAsyncWhenSpscInputAddIsPendingThenThrowsLogicError)
+  {
+    auto transformBlock = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                              {
+                                                                                return item;
+                                                                              });
+    DataFlowBlockOptions options{};
+    options.UseSpscInputForSinglePredecessor = true;
+    options.SpscInputCapacity = 1;
+    Tasks::TaskCompletionSource<void> actionGateTcs{};
+    auto finalAction = DataFlowAsyncFactory::CreateActionBlock<int>([actionGateTcs](const int& item)-> Tasks::Task<void>
+                                                                    {
+                                                                      co_await actionGateTcs.GetTask();
+                                                                    },
+                                                                    [](auto& _){return true;},
+                                                                    options);
+    transformBlock->Then(finalAction);
+    transformBlock->Start();
+
+    //The action waits for the gate, so the input queue fills up and the next add is pending.
+    optional<Tasks::Task<void>> pendingAddTask{};
+    for (int i = 0; i < 3 && !pendingAddTask; ++i)
+    {
+      auto addTask = finalAction->AcceptInputAsync(i);
+      if (!addTask.IsCompleted())
+      {
+        pendingAddTask.emplace(std::move(addTask));
+      }
+    }
+
+    ASSERT_TRUE(pendingAddTask.has_value());
+    ASSERT_THROW(finalAction->AcceptInputAsync(-1), logic_error);
+
+    actionGateTcs.SetResult();
+    pendingAddTask->Wait();
+    transformBlock->Complete();
+    finalAction->Completion().Wait();
+  }
+
+  TEST_F(DataFlowTest, WhenBlockUsesPriorityInputThenWaitingItemsProcessedInPriorityOrder)
+  {
+    const int FIRST_ITEM = 0;
+    Tasks::TaskCompletionSource<void> firstItemStartedTcs{};
+    Tasks::TaskCompletionSource<void> firstItemGateTcs{};
+    vector<int> processedItems{};
+    Detail::DataFlowBlockCommon<int, Detail::NoOutput>::AsyncActionFuncType actionFunc = [&](const int& item, Detail::NoState*&)-> Tasks::Task<void>
+                                                                                        {
+                                                                                          if (item == FIRST_ITEM)
+                                                                                          {
+                                                                                            firstItemStartedTcs.SetResult();
+                                                                                            co_await firstItemGateTcs.GetTask();
+                                                                                          }
+                                                                                          processedItems.push_back(item);
+                                                                                        };
+    auto actionBlock = make_shared<ActionBlock<int>>(actionFunc);
+    actionBlock->InputItems(make_unique<AsyncPriorityProducerConsumerCollection<int>>());
+
+    actionBlock->Start();
+    actionBlock->AcceptInputAsync(FIRST_ITEM).Wait();
+    firstItemStartedTcs.GetTask().Wait();
+    for (auto item : {1, 5, 3, 4, 2})
+    {
+      actionBlock->AcceptInputAsync(item).Wait();
+    }
+    firstItemGateTcs.SetResult();
+    actionBlock->Complete();
+    actionBlock->Completion().Wait();
+
+    ASSERT_EQ((vector<int>{FIRST_ITEM, 5, 4, 3, 2, 1}), processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenInputQueueRejectsItemThenPendingInputCountIsNotIncreased)
+  {
+    const int FIRST_ITEM = 0;
+    Tasks::TaskCompletionSource<void> firstItemStartedTcs{};
+    Tasks::TaskCompletionSource<void> firstItemGateTcs{};
+    Detail::DataFlowBlockCommon<int, Detail::NoOutput>::AsyncActionFuncType actionFunc = [&](const int& item, Detail::NoState*&)-> Tasks::Task<void>
+                                                                                        {
+                                                                                          if (item == FIRST_ITEM)
+                                                                                          {
+                                                                                            firstItemStartedTcs.SetResult();
+                                                                                            co_await firstItemGateTcs.GetTask();
+                                                                                          }
+                                                                                        };
+    auto actionBlock = make_shared<ActionBlock<int>>(actionFunc);
+    auto inputItems = make_unique<SimpleAsyncProducerConsumerCollection<int>>();
+    auto* inputItemsPtr = inputItems.get();
+    actionBlock->InputItems(std::move(inputItems));
+
+    actionBlock->Start();
+    actionBlock->AcceptInputAsync(FIRST_ITEM).Wait();
+    firstItemStartedTcs.GetTask().Wait();
+    inputItemsPtr->CompleteAdding();
+
+    ASSERT_ANY_THROW(actionBlock->AcceptInputAsync(1).Wait());
+    ASSERT_EQ(1u, actionBlock->PendingInputCount());
+    firstItemGateTcs.SetResult();
+    actionBlock->Complete();
+  }
+
+  TEST_F(DataFlowTest, WhenTransformManyBlockThenAllOutputItemsProcessedInOrder)
+  {
+    const int LINES_COUNT = 100;
+    const int WORDS_PER_LINE = 3;
+    auto splitLine = DataFlowAsyncFactory::CreateTransformManyBlock<string, string>([](const string& line, const TransformManyBlock<string, string>::OutputSinkFuncType& outputSink)-> Tasks::Task<void>
+                                                                                    {
+                                                                                      istringstream lineStream{line};
+                                                                                      string word;
+                                                                                      while (lineStream >> word)
+                                                                                      {
+                                                                                        co_await outputSink(word);
+                                                                                      }
+                                                                                    });
+
+    vector<string> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<string>([&processedItems](const string& item)
+                                                                      {
+                                                                        processedItems.push_back(item);
+                                                                      });
+    splitLine->Then(finalAction);
+
+    splitLine->Start();
+    vector<string> expectedItems{};
+    for (int i = 0; i < LINES_COUNT; ++i)
+    {
+      string line{};
+      for (int j = 0; j < WORDS_PER_LINE; ++j)
+      {
+        const auto word = to_string(i) + "_" + to_string(j);
+        expectedItems.push_back(word);
+        line += word + " ";
+      }
+
+      splitLine->AcceptInputAsync(line).Wait();
+    }
+
+    splitLine->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenJoinBlockThenInputsFromAllPortsAreJoinedToTuples)
+  {
+    const int EXPECTED_PROCESSED_ITEMS = 100;
+    const int MAX_BUFFERED_ITEMS = 4;
+    auto transform1 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    auto transform2 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item * 2;
+                                                                          });
+    auto transform3 = DataFlowSyncFactory::CreateTransformBlock<int, string>([](const int& item)
+                                                                             {
+                                                                               return to_string(item);
+                                                                             });
+    auto joinBlock = std::make_shared<JoinBlock<int, string>>(MAX_BUFFERED_ITEMS);
+
+    vector<tuple<int, string>> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<tuple<int, string>>([&processedItems](const tuple<int, string>& item)
+                                                                                  {
+                                                                                    processedItems.push_back(item);
+                                                                                  });
+    transform1->ConnectTo(transform2);
+    transform1->ConnectTo(transform3);
+    transform2->ConnectTo(joinBlock->Port<0>());
+    transform3->ConnectTo(joinBlock->Port<1>());
+    joinBlock->Then(finalAction);
+
+    transform1->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    transform1->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(EXPECTED_PROCESSED_ITEMS, processedItems.size());
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      ASSERT_EQ(make_tuple(i * 2, to_string(i)), processedItems[i]);
+    }
+  }
+
+  TEST_F(DataFlowTest, AcceptInputAsyncWhenNonGreedyJoinPortHoldsItemThenCompletesAfterJoin)
+  {
+    auto joinBlock = std::make_shared<JoinBlock<int, int>>(1, JoinMode::NonGreedy);
+    auto port0 = joinBlock->Port<0>();
+    auto port1 = joinBlock->Port<1>();
+
+    promise<tuple<int, int>> joinedItemPromise{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<tuple<int, int>>([&joinedItemPromise](const tuple<int, int>& item)
+                                                                               {
+                                                                                 joinedItemPromise.set_value(item);
+                                                                               });
+    joinBlock->Then(finalAction);
+
+    joinBlock->Start();
+    auto port0Task = port0->AcceptInputAsync(1);
+    const auto isPort0TaskCompletedBeforeJoin = port0Task.IsCompleted();
+    const auto canAcceptHeldPortInput = port0->CanAcceptInput(2);
+    port1->AcceptInputAsync(2).Wait();
+    port0Task.Wait();
+    const auto joinedItem = joinedItemPromise.get_future().get();
+    joinBlock->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_FALSE(isPort0TaskCompletedBeforeJoin);
+    ASSERT_TRUE(canAcceptHeldPortInput);
+    ASSERT_EQ(make_tuple(1, 2), joinedItem);
+  }
+
+  TEST_F(DataFlowTest, WhenNonGreedyJoinPortHoldsItemThenBroadcastLinkPostponesItem)
+  {
+    const int ITEMS_COUNT = 3;
+    auto sourceBlock = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                           {
+                                                                             return item;
+                                                                           });
+    auto joinBlock = std::make_shared<JoinBlock<int, int>>(1, JoinMode::NonGreedy);
+    auto port1 = joinBlock->Port<1>();
+
+    vector<tuple<int, int>> joinedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<tuple<int, int>>([&joinedItems](const tuple<int, int>& item)
+                                                                               {
+                                                                                 joinedItems.push_back(item);
+                                                                               });
+    sourceBlock->ConnectTo(joinBlock->Port<0>());
+    joinBlock->Then(finalAction);
+
+    sourceBlock->Start();
+    joinBlock->Start();
+    for (int i = 1; i <= ITEMS_COUNT; ++i)
+    {
+      sourceBlock->AcceptInputAsync(i).Wait();
+    }
+
+    for (int i = 1; i <= ITEMS_COUNT; ++i)
+    {
+      port1->AcceptInputAsync(i * 10).Wait();
+    }
+
+    sourceBlock->Complete();
+    sourceBlock->Completion().Wait();
+    joinBlock->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ((vector<tuple<int, int>>{{1, 10}, {2, 20}, {3, 30}}), joinedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenNonGreedyJoinBlockCompletesThenWaitingProducerIsReleased)
+  {
+    auto joinBlock = std::make_shared<JoinBlock<int, int>>(1, JoinMode::NonGreedy);
+    auto port0 = joinBlock->Port<0>();
+
+    joinBlock->Start();
+    auto port0Task = port0->AcceptInputAsync(1);
+    const auto isPort0TaskCompletedBeforeCompletion = port0Task.IsCompleted();
+    joinBlock->Complete();
+    joinBlock->Completion().Wait();
+    port0Task.Wait();
+
+    ASSERT_FALSE(isPort0TaskCompletedBeforeCompletion);
+  }
+
+  TEST_F(DataFlowTest, WhenBufferBlockThenAllInputsProcessedInOrder)
+  {
+    const int EXPECTED_PROCESSED_ITEMS = 100;
+    auto bufferBlock = std::make_shared<BufferBlock<int>>();
+
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   });
+    bufferBlock->Then(finalAction);
+
+    bufferBlock->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      bufferBlock->AcceptInputAsync(i).Wait();
+    }
+
+    bufferBlock->Complete();
+    finalAction->Completion().Wait();
+
+    vector<int> expectedItems(EXPECTED_PROCESSED_ITEMS);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenBroadcastBlockHasSlowConsumerThenSlowConsumerSkipsStaleItems)
+  {
+    const int ITEMS_COUNT = 100;
+    const int LAST_ITEM = ITEMS_COUNT - 1;
+    auto broadcastBlock = std::make_shared<BroadcastBlock<int>>();
+
+    vector<BroadcastBlock<int>::SharedItemType> fastConsumerItems{};
+    promise<void> lastItemProcessedPromise{};
+    auto fastConsumer = DataFlowSyncFactory::CreateActionBlock<BroadcastBlock<int>::SharedItemType>([&](const BroadcastBlock<int>::SharedItemType& item)
+                                                                                                     {
+                                                                                                       fastConsumerItems.push_back(item);
+                                                                                                       if (*item == LAST_ITEM)
+                                                                                                       {
+                                                                                                         lastItemProcessedPromise.set_value();
+                                                                                                       }
+                                                                                                     });
+
+    vector<BroadcastBlock<int>::SharedItemType> slowConsumerItems{};
+    promise<void> slowConsumerGatePromise{};
+    shared_future<void> slowConsumerGate = slowConsumerGatePromise.get_future().share();
+    DataFlowBlockOptions slowConsumerOptions{};
+    slowConsumerOptions.ProcessLatestInputOnly = true;
+    auto slowConsumer = DataFlowSyncFactory::CreateActionBlock<BroadcastBlock<int>::SharedItemType>([&](const BroadcastBlock<int>::SharedItemType& item)
+                                                                                                     {
+                                                                                                       slowConsumerGate.wait();
+                                                                                                       slowConsumerItems.push_back(item);
+                                                                                                     },
+                                                                                                     [](auto& _){return true;},
+                                                                                                     slowConsumerOptions);
+    //Items are delivered to the slow consumer first, the last item is in the queue of the slow consumer when the fast consumer processes it.
+    broadcastBlock->ConnectTo(slowConsumer);
+    broadcastBlock->ConnectTo(fastConsumer);
+
+    broadcastBlock->Start();
+    for (int i = 0; i < ITEMS_COUNT; ++i)
+    {
+      broadcastBlock->AcceptInputAsync(i).Wait();
+    }
+
+    lastItemProcessedPromise.get_future().wait();
+    slowConsumerGatePromise.set_value();
+    broadcastBlock->Complete();
+    fastConsumer->Completion().Wait();
+    slowConsumer->Completion().Wait();
+
+    ASSERT_LE(slowConsumerItems.size(), 2);
+    ASSERT_EQ(LAST_ITEM, *slowConsumerItems.back());
+    ASSERT_EQ(fastConsumerItems.back(), slowConsumerItems.back());
+    ASSERT_EQ(fastConsumerItems.back(), broadcastBlock->LatestItem());
+  }
+
+  TEST_F(DataFlowTest, WhenFusedPipelineEndsWithBlockThenAllInputsProcessed)
+  {
+    const int EXPECTED_PROCESSED_ITEMS = 1000;
+    vector<string> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<string>([&processedItems](const string& item)
+                                                                      {
+                                                                        processedItems.push_back(item);
+                                                                      });
+
+    auto pipeline = DataFlowPipeline::Transform([](int item){return item * 2;})
+                    | DataFlowPipeline::Transform([](int item){return to_string(item);})
+                    | finalAction;
+    auto pipelineBlock = DataFlowSyncFactory::CreatePipelineBlock<int>(pipeline);
+
+    pipelineBlock->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      pipelineBlock->AcceptInputAsync(i).Wait();
+    }
+
+    pipelineBlock->Complete();
+    finalAction->Completion().Wait();
+
+    ASSERT_EQ(EXPECTED_PROCESSED_ITEMS, processedItems.size());
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      ASSERT_EQ(to_string(i * 2), processedItems[i]);
+    }
+  }
+
+  TEST_F(DataFlowTest, WhenFusedPipelineEndsWithActionThenAllInputsProcessed)
+  {
+    const int EXPECTED_PROCESSED_ITEMS = 1000;
+    int processedItemsSum = 0;
+    auto pipeline = DataFlowPipeline::Transform([](int item){return item + 1;})
+                    | DataFlowPipeline::Transform([](int item){return item - 1;})
+                    | DataFlowPipeline::Action([&processedItemsSum](int item){processedItemsSum += item;});
+    auto pipelineBlock = DataFlowSyncFactory::CreatePipelineBlock<int>(pipeline);
+
+    pipelineBlock->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      pipelineBlock->AcceptInputAsync(i).Wait();
+    }
+
+    pipelineBlock->Complete();
+    pipelineBlock->Completion().Wait();
+
+    ASSERT_EQ(EXPECTED_PROCESSED_ITEMS * (EXPECTED_PROCESSED_ITEMS - 1) / 2, processedItemsSum);
+  }
+
+  TEST_F(DataFlowTest, WhenFusedBlockFailsToDeliverOutputThenOnlyFusedBlockIsFaulted)
+  {
+    auto transform1 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    auto transform2 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    auto rejectingBlock = std::make_shared<RejectingInputBlock<int>>();
+    transform1->ConnectTo(transform2);
+    transform2->ConnectTo(rejectingBlock);
+
+    transform1->Start();
+    transform1->AcceptInputAsync(1).Wait();
+
+    ASSERT_THROW(transform2->Completion().Wait(), logic_error);
+    ASSERT_THROW(rejectingBlock->Completion().Wait(), logic_error);
+    ASSERT_TRUE(transform1->CanAcceptInput(2));
+    transform1->AcceptInputAsync(2).Wait();
+    transform1->Complete();
+    ASSERT_NO_THROW(transform1->Completion().Wait());
+  }
+
+  TEST_F(DataFlowTest, AcceptInputAsyncWhenBlockIsFusedWithPredecessorThenItemIsProcessed)
+  {
+    const int PREDECESSOR_ITEMS = 100;
+    const int EXTERNAL_ITEMS = 50;
+    auto transform1 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    auto transform2 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   });
+    transform1->ConnectTo(transform2);
+    transform2->ConnectTo(finalAction);
+    transform1->Start();
+    for (int i = 0; i < PREDECESSOR_ITEMS / 2; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    ASSERT_TRUE(transform2->CanAcceptInput(PREDECESSOR_ITEMS));
+    for (int i = PREDECESSOR_ITEMS; i < PREDECESSOR_ITEMS + EXTERNAL_ITEMS; ++i)
+    {
+      transform2->AcceptInputAsync(i).Wait();
+    }
+
+    for (int i = PREDECESSOR_ITEMS / 2; i < PREDECESSOR_ITEMS; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    transform1->Complete();
+    finalAction->Completion().Wait();
+
+    sort(processedItems.begin(), processedItems.end());
+    vector<int> expectedItems(PREDECESSOR_ITEMS + EXTERNAL_ITEMS);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenSecondPredecessorIsLinkedToFusedBlockThenItemsOfBothPredecessorsAreProcessed)
+  {
+    const int ITEMS_PER_PREDECESSOR = 100;
+    auto transform1 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    auto transform2 = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                          {
+                                                                            return item;
+                                                                          });
+    auto lateTransform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                             {
+                                                                               return item;
+                                                                             });
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   });
+    transform1->ConnectTo(transform2);
+    transform2->ConnectTo(finalAction);
+    transform1->Start();
+    for (int i = 0; i < ITEMS_PER_PREDECESSOR / 2; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    lateTransform->ConnectTo(transform2);
+    lateTransform->Start();
+    for (int i = ITEMS_PER_PREDECESSOR; i < 2 * ITEMS_PER_PREDECESSOR; ++i)
+    {
+      lateTransform->AcceptInputAsync(i).Wait();
+    }
+
+    for (int i = ITEMS_PER_PREDECESSOR / 2; i < ITEMS_PER_PREDECESSOR; ++i)
+    {
+      transform1->AcceptInputAsync(i).Wait();
+    }
+
+    transform1->Complete();
+    lateTransform->Complete();
+    finalAction->Completion().Wait();
+
+    sort(processedItems.begin(), processedItems.end());
+    vector<int> expectedItems(2 * ITEMS_PER_PREDECESSOR);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
+  TEST_F(DataFlowTest, WhenBufferBlockIsLinkedToPredecessorThenBufferBlockIsNotFused)
+  {
+    const int EXPECTED_PROCESSED_ITEMS = 100;
+    auto transform = DataFlowSyncFactory::CreateTransformBlock<int, int>([](const int& item)
+                                                                         {
+                                                                           return item;
+                                                                         });
+    auto bufferBlock = std::make_shared<BufferBlock<int>>();
+    vector<int> processedItems{};
+    auto finalAction = DataFlowSyncFactory::CreateActionBlock<int>([&processedItems](const int& item)
+                                                                   {
+                                                                     processedItems.push_back(item);
+                                                                   });
+    transform->ConnectTo(bufferBlock);
+    bufferBlock->ConnectTo(finalAction);
+
+    transform->Start();
+    for (int i = 0; i < EXPECTED_PROCESSED_ITEMS / 2; ++i)
+    {
+      transform->AcceptInputAsync(i).Wait();
+    }
+
+    //Buffer keeps its queue, so other producers can send items to the buffer directly.
+    ASSERT_TRUE(bufferBlock->CanAcceptInput(EXPECTED_PROCESSED_ITEMS / 2));
+    for (int i = EXPECTED_PROCESSED_ITEMS / 2; i < EXPECTED_PROCESSED_ITEMS; ++i)
+    {
+      bufferBlock->AcceptInputAsync(i).Wait();
+    }
+
+    transform->Complete();
+    finalAction->Completion().Wait();
+
+    sort(processedItems.begin(), processedItems.end());
+    vector<int> expectedItems(EXPECTED_PROCESSED_ITEMS);
+    iota(expectedItems.begin(), expectedItems.end(), 0);
+    ASSERT_EQ(expectedItems, processedItems);
+  }
+
   TEST_F(DataFlowTest, WhenAsyncFlatDataflowThenAllInputsProcessed)
   {
     const int EXPECTED_PROCESSED_ITEMS = 100;
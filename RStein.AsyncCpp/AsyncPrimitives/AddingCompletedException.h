@@ -0,0 +1,19 @@
+﻿#pragma once
+#include <exception>
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  class AddingCompletedException final : public std::exception
+  {
+    public:
+
+    AddingCompletedException() : std::exception("Adding to the collection has been completed.")
+    {
+      
+    }
+    AddingCompletedException(const AddingCompletedException& other) = default;
+    AddingCompletedException(AddingCompletedException&& other) noexcept = default;
+    AddingCompletedException& operator=(const AddingCompletedException& other) = default;
+    AddingCompletedException& operator=(AddingCompletedException&& other) noexcept = default;
+    ~AddingCompletedException() = default;
+  }; 
+}
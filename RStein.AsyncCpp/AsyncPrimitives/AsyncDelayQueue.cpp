@@ -0,0 +1 @@
+﻿#include "AsyncDelayQueue.h"
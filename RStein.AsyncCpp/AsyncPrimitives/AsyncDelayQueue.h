@@ -0,0 +1,317 @@
+﻿#pragma once
+#include "AsyncTimer.h"
+#include "CancellationToken.h"
+#include "CancellationTokenSource.h"
+#include "../Detail/AsyncPrimitives/SemaphoreGuardedCollection.h"
+#include "../Tasks/TaskCombinators.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Unbounded collection of items which can be taken at their due time. Items with the same due time are taken in the FIFO order.
+  //Delayed items are kept in a binary heap, only the earliest due time is registered with the AsyncTimer (no thread or task per item).
+  //The timer delay for the later due time is canceled when an item with the earlier due time is added.
+  //Items added without the due time are available immediately. TryTakeAll returns only the items which are due.
+  template <typename TItem>
+  class AsyncDelayQueue : public Detail::SemaphoreGuardedCollection<TItem, AsyncDelayQueue<TItem>>
+  {
+  public:
+    using Clock = AsyncTimer::Clock;
+
+    explicit AsyncDelayQueue(AsyncTimer::AsyncTimerPtr timer = AsyncTimer::DefaultTimer());
+    AsyncDelayQueue(const AsyncDelayQueue& other) = delete;
+    AsyncDelayQueue(AsyncDelayQueue&& other) noexcept = delete;
+    AsyncDelayQueue& operator=(const AsyncDelayQueue& other) = delete;
+    AsyncDelayQueue& operator=(AsyncDelayQueue&& other) noexcept = delete;
+    virtual ~AsyncDelayQueue();
+
+    void Add(const TItem& item, Clock::time_point dueTime);
+    void Add(TItem&& item, Clock::time_point dueTime);
+    void Add(const TItem& item) override;
+    void Add(TItem&& item) override;
+    Tasks::Task<void> AddAsync(const TItem& item) override;
+    Tasks::Task<void> AddAsync(TItem&& item) override;
+    //Number of all items including the items which are not due yet.
+    [[nodiscard]] std::size_t Count() const;
+    [[nodiscard]] std::size_t DelayedItemsCount() const;
+
+  private:
+    friend class Detail::SemaphoreGuardedCollection<TItem, AsyncDelayQueue>;
+
+    struct DelayedItem
+    {
+      Clock::time_point DueTime;
+      std::uint64_t Sequence;
+      TItem Item;
+
+      bool operator>(const DelayedItem& other) const
+      {
+        return DueTime != other.DueTime
+                 ? DueTime > other.DueTime
+                 : Sequence > other.Sequence;
+      }
+    };
+
+    //The wakeup which has been already scheduled when the queue is destroyed finds the null Queue.
+    struct TimerGuard
+    {
+      std::mutex Mutex;
+      AsyncDelayQueue* Queue;
+    };
+
+    using TimerGuardPtr = std::shared_ptr<TimerGuard>;
+
+    AsyncTimer::AsyncTimerPtr _timer;
+    mutable std::mutex _itemsMutex;
+    //Min-heap ordered by (DueTime, Sequence).
+    std::vector<DelayedItem> _delayedItems;
+    std::deque<TItem> _dueItems;
+    std::uint64_t _nextSequence;
+    //The earliest due time registered with the timer.
+    std::optional<Clock::time_point> _timerDueTime;
+    //Cancels the timer delay for the _timerDueTime.
+    CancellationTokenSource _timerCts;
+    TimerGuardPtr _timerGuard;
+
+    template <typename TUItem>
+    void addDelayedItem(TUItem&& item, Clock::time_point dueTime);
+    template <typename TUItem>
+    void addDueItem(TUItem&& item);
+    std::optional<std::pair<Clock::time_point, CancellationToken>> onTimer(Clock::time_point timerDueTime);
+    static void startTimer(const AsyncTimer::AsyncTimerPtr& timer,
+                           const TimerGuardPtr& timerGuard,
+                           Clock::time_point dueTime,
+                           CancellationToken cancellationToken);
+    std::size_t popMany(std::vector<TItem>& items, std::size_t maxItems);
+  };
+
+  template <typename TItem>
+  AsyncDelayQueue<TItem>::AsyncDelayQueue(AsyncTimer::AsyncTimerPtr timer) : Detail::SemaphoreGuardedCollection<TItem, AsyncDelayQueue>(),
+                                                                             _timer{std::move(timer)},
+                                                                             _itemsMutex{},
+                                                                             _delayedItems{},
+                                                                             _dueItems{},
+                                                                             _nextSequence{0},
+                                                                             _timerDueTime{},
+                                                                             _timerCts{},
+                                                                             _timerGuard{std::make_shared<TimerGuard>()}
+  {
+    if (!_timer)
+    {
+      throw std::invalid_argument("timer");
+    }
+
+    _timerGuard->Queue = this;
+  }
+
+  template <typename TItem>
+  AsyncDelayQueue<TItem>::~AsyncDelayQueue()
+  {
+    {
+      //Waits for the running timer wakeup.
+      std::lock_guard lock{_timerGuard->Mutex};
+      _timerGuard->Queue = nullptr;
+    }
+
+    //Removes the pending delay from the shared timer.
+    _timerCts.Cancel();
+  }
+
+  template <typename TItem>
+  void AsyncDelayQueue<TItem>::Add(const TItem& item, Clock::time_point dueTime)
+  {
+    addDelayedItem(item, dueTime);
+  }
+
+  template <typename TItem>
+  void AsyncDelayQueue<TItem>::Add(TItem&& item, Clock::time_point dueTime)
+  {
+    addDelayedItem(std::move(item), dueTime);
+  }
+
+  template <typename TItem>
+  void AsyncDelayQueue<TItem>::Add(const TItem& item)
+  {
+    addDueItem(item);
+  }
+
+  template <typename TItem>
+  void AsyncDelayQueue<TItem>::Add(TItem&& item)
+  {
+    addDueItem(std::move(item));
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> AsyncDelayQueue<TItem>::AddAsync(const TItem& item)
+  {
+    addDueItem(item);
+    return Tasks::GetCompletedTask();
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> AsyncDelayQueue<TItem>::AddAsync(TItem&& item)
+  {
+    addDueItem(std::move(item));
+    return Tasks::GetCompletedTask();
+  }
+
+  template <typename TItem>
+  std::size_t AsyncDelayQueue<TItem>::Count() const
+  {
+    std::lock_guard lock{_itemsMutex};
+    return _dueItems.size() + _delayedItems.size();
+  }
+
+  template <typename TItem>
+  std::size_t AsyncDelayQueue<TItem>::DelayedItemsCount() const
+  {
+    std::lock_guard lock{_itemsMutex};
+    return _delayedItems.size();
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  void AsyncDelayQueue<TItem>::addDelayedItem(TUItem&& item, Clock::time_point dueTime)
+  {
+    if (dueTime <= Clock::now())
+    {
+      addDueItem(std::forward<TUItem>(item));
+      return;
+    }
+
+    std::optional<CancellationTokenSource> previousTimerCts{};
+    std::optional<CancellationToken> timerCancellationToken{};
+    {
+      std::lock_guard lock{_itemsMutex};
+      _delayedItems.push_back(DelayedItem{dueTime, _nextSequence++, std::forward<TUItem>(item)});
+      std::push_heap(_delayedItems.begin(), _delayedItems.end(), std::greater<>{});
+      if (!_timerDueTime || dueTime < *_timerDueTime)
+      {
+        if (_timerDueTime)
+        {
+          previousTimerCts.emplace(_timerCts);
+        }
+
+        _timerDueTime = dueTime;
+        _timerCts = CancellationTokenSource{};
+        timerCancellationToken.emplace(_timerCts.Token());
+      }
+    }
+
+    //Only the delay for the earliest due time stays registered with the timer.
+    if (previousTimerCts)
+    {
+      previousTimerCts->Cancel();
+    }
+
+    if (timerCancellationToken)
+    {
+      startTimer(_timer, _timerGuard, dueTime, *timerCancellationToken);
+    }
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  void AsyncDelayQueue<TItem>::addDueItem(TUItem&& item)
+  {
+    {
+      std::lock_guard lock{_itemsMutex};
+      _dueItems.push_back(std::forward<TUItem>(item));
+    }
+
+    this->publishItems(1);
+  }
+
+  template <typename TItem>
+  std::optional<std::pair<typename AsyncDelayQueue<TItem>::Clock::time_point, CancellationToken>> AsyncDelayQueue<TItem>::onTimer(
+    Clock::time_point timerDueTime)
+  {
+    std::size_t dueItemsCount = 0;
+    std::optional<std::pair<Clock::time_point, CancellationToken>> nextTimer{};
+    {
+      std::lock_guard lock{_itemsMutex};
+      if (_timerDueTime == timerDueTime)
+      {
+        _timerDueTime.reset();
+      }
+
+      const auto now = Clock::now();
+      while (!_delayedItems.empty() && _delayedItems.front().DueTime <= now)
+      {
+        std::pop_heap(_delayedItems.begin(), _delayedItems.end(), std::greater<>{});
+        _dueItems.push_back(std::move(_delayedItems.back().Item));
+        _delayedItems.pop_back();
+        dueItemsCount++;
+      }
+
+      if (!_delayedItems.empty() && (!_timerDueTime || _delayedItems.front().DueTime < *_timerDueTime))
+      {
+        _timerDueTime = _delayedItems.front().DueTime;
+        _timerCts = CancellationTokenSource{};
+        nextTimer.emplace(*_timerDueTime, _timerCts.Token());
+      }
+    }
+
+    //One permit for every due item.
+    this->publishItems(dueItemsCount);
+    return nextTimer;
+  }
+
+  template <typename TItem>
+  void AsyncDelayQueue<TItem>::startTimer(const AsyncTimer::AsyncTimerPtr& timer,
+                                          const TimerGuardPtr& timerGuard,
+                                          Clock::time_point dueTime,
+                                          CancellationToken cancellationToken)
+  {
+    timer->DelayUntilAsync(dueTime, std::move(cancellationToken)).ContinueWith([timer, timerGuard, dueTime](const auto& delayTask)
+    {
+      //The delay has been replaced by the delay for the earlier due time.
+      if (delayTask.IsCanceled())
+      {
+        return;
+      }
+
+      std::optional<std::pair<Clock::time_point, CancellationToken>> nextTimer{};
+      {
+        std::lock_guard lock{timerGuard->Mutex};
+        if (timerGuard->Queue == nullptr)
+        {
+          return;
+        }
+
+        nextTimer = timerGuard->Queue->onTimer(dueTime);
+      }
+
+      if (nextTimer)
+      {
+        startTimer(timer, timerGuard, nextTimer->first, nextTimer->second);
+      }
+    });
+  }
+
+  template <typename TItem>
+  std::size_t AsyncDelayQueue<TItem>::popMany(std::vector<TItem>& items, std::size_t maxItems)
+  {
+    std::lock_guard lock{_itemsMutex};
+    std::size_t takenCount = 0;
+    while (takenCount < maxItems && !_dueItems.empty())
+    {
+      items.push_back(std::move(_dueItems.front()));
+      _dueItems.pop_front();
+      takenCount++;
+    }
+
+    return takenCount;
+  }
+}
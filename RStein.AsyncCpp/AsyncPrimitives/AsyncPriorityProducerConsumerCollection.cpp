@@ -0,0 +1 @@
+﻿#include "AsyncPriorityProducerConsumerCollection.h"
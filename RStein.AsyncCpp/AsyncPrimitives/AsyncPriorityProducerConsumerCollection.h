@@ -0,0 +1,184 @@
+﻿#pragma once
+#include "../Detail/AsyncPrimitives/SemaphoreGuardedCollection.h"
+#include "../Tasks/TaskCombinators.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Unbounded collection which returns the item with the highest priority first.
+  //The item A has higher priority than the item B when TCompare(B, A) is true (std::less - the greatest item is taken first).
+  //Items with the same priority are taken in the FIFO order.
+  //Starvation avoidance - when maxBypassedTakes > 0, the oldest item is taken after maxBypassedTakes takes of items with higher priority.
+  //TryTakeAll returns the items in the order in which they would be taken by TakeAsync.
+  template <typename TItem, typename TCompare = std::less<TItem>>
+  class AsyncPriorityProducerConsumerCollection : public Detail::SemaphoreGuardedCollection<TItem, AsyncPriorityProducerConsumerCollection<TItem, TCompare>>
+  {
+  public:
+    explicit AsyncPriorityProducerConsumerCollection(TCompare compare = TCompare{}, std::size_t maxBypassedTakes = 0);
+    AsyncPriorityProducerConsumerCollection(const AsyncPriorityProducerConsumerCollection& other) = delete;
+    AsyncPriorityProducerConsumerCollection(AsyncPriorityProducerConsumerCollection&& other) noexcept = delete;
+    AsyncPriorityProducerConsumerCollection& operator=(const AsyncPriorityProducerConsumerCollection& other) = delete;
+    AsyncPriorityProducerConsumerCollection& operator=(AsyncPriorityProducerConsumerCollection&& other) noexcept = delete;
+    virtual ~AsyncPriorityProducerConsumerCollection() = default;
+
+    void Add(const TItem& item) override;
+    void Add(TItem&& item) override;
+    Tasks::Task<void> AddAsync(const TItem& item) override;
+    Tasks::Task<void> AddAsync(TItem&& item) override;
+    [[nodiscard]] std::size_t Count() const;
+
+  private:
+    friend class Detail::SemaphoreGuardedCollection<TItem, AsyncPriorityProducerConsumerCollection>;
+
+    struct Entry
+    {
+      TItem Item;
+      std::uint64_t Sequence;
+    };
+
+    //The first entry in the ordered set has the highest priority.
+    struct EntryOrder
+    {
+      TCompare Compare;
+
+      bool operator()(const Entry& first, const Entry& second) const
+      {
+        if (Compare(second.Item, first.Item))
+        {
+          return true;
+        }
+
+        if (Compare(first.Item, second.Item))
+        {
+          return false;
+        }
+
+        return first.Sequence < second.Sequence;
+      }
+    };
+
+    using PriorityIndex = std::set<Entry, EntryOrder>;
+    //Maintained only when the starvation avoidance is enabled.
+    using AgeIndex = std::map<std::uint64_t, typename PriorityIndex::iterator>;
+
+    const std::size_t _maxBypassedTakes;
+    mutable std::mutex _itemsMutex;
+    PriorityIndex _items;
+    AgeIndex _itemsByAge;
+    std::uint64_t _nextSequence;
+    std::size_t _bypassedTakes;
+
+    template <typename TUItem>
+    void addItem(TUItem&& item);
+    std::size_t popMany(std::vector<TItem>& items, std::size_t maxItems);
+    typename PriorityIndex::iterator selectNextEntry();
+  };
+
+  template <typename TItem, typename TCompare>
+  AsyncPriorityProducerConsumerCollection<TItem, TCompare>::AsyncPriorityProducerConsumerCollection(TCompare compare, std::size_t maxBypassedTakes) :
+    Detail::SemaphoreGuardedCollection<TItem, AsyncPriorityProducerConsumerCollection>(),
+    _maxBypassedTakes{maxBypassedTakes},
+    _itemsMutex{},
+    _items{EntryOrder{std::move(compare)}},
+    _itemsByAge{},
+    _nextSequence{0},
+    _bypassedTakes{0}
+  {
+  }
+
+  template <typename TItem, typename TCompare>
+  void AsyncPriorityProducerConsumerCollection<TItem, TCompare>::Add(const TItem& item)
+  {
+    addItem(item);
+  }
+
+  template <typename TItem, typename TCompare>
+  void AsyncPriorityProducerConsumerCollection<TItem, TCompare>::Add(TItem&& item)
+  {
+    addItem(std::move(item));
+  }
+
+  template <typename TItem, typename TCompare>
+  Tasks::Task<void> AsyncPriorityProducerConsumerCollection<TItem, TCompare>::AddAsync(const TItem& item)
+  {
+    addItem(item);
+    return Tasks::GetCompletedTask();
+  }
+
+  template <typename TItem, typename TCompare>
+  Tasks::Task<void> AsyncPriorityProducerConsumerCollection<TItem, TCompare>::AddAsync(TItem&& item)
+  {
+    addItem(std::move(item));
+    return Tasks::GetCompletedTask();
+  }
+
+  template <typename TItem, typename TCompare>
+  std::size_t AsyncPriorityProducerConsumerCollection<TItem, TCompare>::Count() const
+  {
+    std::lock_guard lock{_itemsMutex};
+    return _items.size();
+  }
+
+  template <typename TItem, typename TCompare>
+  template <typename TUItem>
+  void AsyncPriorityProducerConsumerCollection<TItem, TCompare>::addItem(TUItem&& item)
+  {
+    {
+      std::lock_guard lock{_itemsMutex};
+      const auto sequence = _nextSequence++;
+      auto [entryIt, _] = _items.insert(Entry{std::forward<TUItem>(item), sequence});
+      if (_maxBypassedTakes > 0)
+      {
+        _itemsByAge.emplace_hint(_itemsByAge.end(), sequence, entryIt);
+      }
+    }
+
+    this->publishItems(1);
+  }
+
+  template <typename TItem, typename TCompare>
+  std::size_t AsyncPriorityProducerConsumerCollection<TItem, TCompare>::popMany(std::vector<TItem>& items, std::size_t maxItems)
+  {
+    std::lock_guard lock{_itemsMutex};
+    std::size_t takenCount = 0;
+    while (takenCount < maxItems && !_items.empty())
+    {
+      auto entryNode = _items.extract(selectNextEntry());
+      items.push_back(std::move(entryNode.value().Item));
+      takenCount++;
+    }
+
+    return takenCount;
+  }
+
+  template <typename TItem, typename TCompare>
+  typename AsyncPriorityProducerConsumerCollection<TItem, TCompare>::PriorityIndex::iterator AsyncPriorityProducerConsumerCollection<TItem, TCompare>::selectNextEntry()
+  {
+    auto entryIt = _items.begin();
+    if (_maxBypassedTakes == 0)
+    {
+      return entryIt;
+    }
+
+    auto oldestEntryIt = _itemsByAge.begin();
+    if (oldestEntryIt->second == entryIt || _bypassedTakes == _maxBypassedTakes)
+    {
+      entryIt = oldestEntryIt->second;
+      _itemsByAge.erase(oldestEntryIt);
+      _bypassedTakes = 0;
+      return entryIt;
+    }
+
+    _bypassedTakes++;
+    _itemsByAge.erase(entryIt->Sequence);
+    return entryIt;
+  }
+}
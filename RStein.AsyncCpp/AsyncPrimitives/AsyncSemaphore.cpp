@@ -8,6 +8,7 @@
 
 
 
+#include <algorithm>
 #include <iostream>
 
 
@@ -72,6 +73,19 @@ namespace RStein::AsyncCpp::AsyncPrimitives
     return waiterTsk;
   }
 
+  int AsyncSemaphore::TryWaitMany(int maxCount)
+  {
+    if (maxCount < 0)
+    {
+      throw std::invalid_argument("maxCount");
+    }
+
+    lock_guard lock{ _waitersLock };
+    const auto acquiredCount = min(_currentCount, maxCount);
+    _currentCount -= acquiredCount;
+    return acquiredCount;
+  }
+
   void AsyncSemaphore::Release()
   {
     lock_guard lock{ _waitersLock };
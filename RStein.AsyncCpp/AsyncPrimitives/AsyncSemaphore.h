@@ -23,6 +23,8 @@ namespace RStein::AsyncCpp::AsyncPrimitives
 
     [[nodiscard]] Tasks::Task<void> WaitAsync();
     [[nodiscard]] Tasks::Task<void> WaitAsync(CancellationToken cancellationToken);
+    //Acquires up to maxCount available permits without waiting. Returns the number of acquired permits.
+    [[nodiscard]] int TryWaitMany(int maxCount);
     void Release();
         
   private:
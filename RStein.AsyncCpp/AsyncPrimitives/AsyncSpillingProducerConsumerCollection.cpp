@@ -0,0 +1 @@
+﻿#include "AsyncSpillingProducerConsumerCollection.h"
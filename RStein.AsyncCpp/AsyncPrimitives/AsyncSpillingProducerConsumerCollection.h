@@ -0,0 +1,547 @@
+﻿#pragma once
+#include "AsyncTimer.h"
+#include "../Detail/AsyncPrimitives/SemaphoreGuardedCollection.h"
+#include "../Schedulers/Scheduler.h"
+#include "../Tasks/TaskCombinators.h"
+#include "../Tasks/TaskCompletionSource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Unbounded FIFO collection which keeps at most inMemoryCapacity items in memory and spills the overflow to segment files.
+  //Every segment file contains segmentCapacity items serialized by the serializer. Segments are read back in order when the consumers catch up.
+  //Files are written and read only in the ioScheduler, producers never wait for the I/O. The ioScheduler must run until the collection is destroyed.
+  //The segmentDirectory must not be shared with another collection. Segment files are removed when they are read and when the collection is destroyed.
+  //When a segment cannot be written (I/O error, serializer exception), its items stay in memory. A segment which cannot be read is read again after READ_RETRY_DELAY.
+  //AddAsync completes after the items waiting for the write fit to MAX_UNWRITTEN_SEGMENTS segments, Add does not wait.
+  template <typename TItem>
+  class AsyncSpillingProducerConsumerCollection : public Detail::SemaphoreGuardedCollection<TItem, AsyncSpillingProducerConsumerCollection<TItem>>
+  {
+  public:
+    static constexpr std::size_t MAX_UNWRITTEN_SEGMENTS = 2;
+    static constexpr std::chrono::milliseconds READ_RETRY_DELAY{100};
+    using SerializeFuncType = std::function<std::string(const TItem&)>;
+    using DeserializeFuncType = std::function<TItem(const std::string&)>;
+
+    AsyncSpillingProducerConsumerCollection(std::size_t inMemoryCapacity,
+                                            std::size_t segmentCapacity,
+                                            std::filesystem::path segmentDirectory,
+                                            SerializeFuncType serializer,
+                                            DeserializeFuncType deserializer,
+                                            Schedulers::Scheduler::SchedulerPtr ioScheduler);
+    AsyncSpillingProducerConsumerCollection(const AsyncSpillingProducerConsumerCollection& other) = delete;
+    AsyncSpillingProducerConsumerCollection(AsyncSpillingProducerConsumerCollection&& other) noexcept = delete;
+    AsyncSpillingProducerConsumerCollection& operator=(const AsyncSpillingProducerConsumerCollection& other) = delete;
+    AsyncSpillingProducerConsumerCollection& operator=(AsyncSpillingProducerConsumerCollection&& other) noexcept = delete;
+    //Waits for the running I/O.
+    virtual ~AsyncSpillingProducerConsumerCollection();
+
+    void Add(const TItem& item) override;
+    void Add(TItem&& item) override;
+    Tasks::Task<void> AddAsync(const TItem& item) override;
+    Tasks::Task<void> AddAsync(TItem&& item) override;
+    //Blocks until all spilled items have been read by the ioScheduler. Must not be called in the ioScheduler or in the item added listener,
+    //the collection notifies the listeners in the ioScheduler. Items of the segment which could not be read are returned after the successful retry.
+    //TryTakeMany does not wait for the I/O, it returns only the items in memory and starts the read of the next segment.
+    std::vector<TItem> TryTakeAll() override;
+    //Number of all items including the spilled items.
+    [[nodiscard]] std::size_t Count() const;
+    //Number of items in the segments (written or being written).
+    [[nodiscard]] std::size_t SpilledItemsCount() const;
+
+  private:
+    friend class Detail::SemaphoreGuardedCollection<TItem, AsyncSpillingProducerConsumerCollection>;
+
+    struct Segment
+    {
+      std::filesystem::path Path;
+      std::size_t ItemsCount;
+      bool IsWritten;
+      //Items of the segment being written or of the segment which could not be written.
+      std::vector<TItem> Items;
+    };
+
+    using SegmentPtr = std::shared_ptr<Segment>;
+
+    //Collected under the lock, run outside of the lock.
+    struct PendingWork
+    {
+      std::size_t ReadableItemsCount;
+      std::vector<std::function<void()>> IoActions;
+      std::vector<Tasks::TaskCompletionSource<void>> ReleasedProducers;
+    };
+
+    const std::size_t _inMemoryCapacity;
+    const std::size_t _segmentCapacity;
+    const std::filesystem::path _segmentDirectory;
+    SerializeFuncType _serializer;
+    DeserializeFuncType _deserializer;
+    Schedulers::Scheduler::SchedulerPtr _ioScheduler;
+    mutable std::mutex _itemsMutex;
+    std::condition_variable _ioCompletedCv;
+    //Items which can be taken. The semaphore has one permit for every item.
+    std::deque<TItem> _items;
+    //Older than the items in _spillItems.
+    std::deque<SegmentPtr> _segments;
+    //Items added after the overflow, not assigned to a segment yet.
+    std::deque<TItem> _spillItems;
+    //Producers waiting until the _spillItems fit to MAX_UNWRITTEN_SEGMENTS segments.
+    std::deque<Tasks::TaskCompletionSource<void>> _waitingProducers;
+    std::uint64_t _nextSegmentId;
+    bool _isWriting;
+    bool _isReading;
+    //The last read of the first segment failed, the read is retried.
+    bool _isReadFailed;
+    bool _isDisposing;
+    int _runningIoActionsCount;
+
+    template <typename TUItem>
+    Tasks::Task<void> addItem(TUItem&& item);
+    bool waitForSpilledItems();
+    std::size_t popMany(std::vector<TItem>& items, std::size_t maxItems);
+    PendingWork collectWork();
+    void runWork(PendingWork&& work);
+    void writeSegment(const SegmentPtr& segment);
+    void readSegment(const SegmentPtr& segment);
+    void completeIoAction(PendingWork&& work);
+  };
+
+  template <typename TItem>
+  AsyncSpillingProducerConsumerCollection<TItem>::AsyncSpillingProducerConsumerCollection(std::size_t inMemoryCapacity,
+                                                                                          std::size_t segmentCapacity,
+                                                                                          std::filesystem::path segmentDirectory,
+                                                                                          SerializeFuncType serializer,
+                                                                                          DeserializeFuncType deserializer,
+                                                                                          Schedulers::Scheduler::SchedulerPtr ioScheduler) :
+    Detail::SemaphoreGuardedCollection<TItem, AsyncSpillingProducerConsumerCollection>(),
+    _inMemoryCapacity{inMemoryCapacity},
+    _segmentCapacity{segmentCapacity},
+    _segmentDirectory{std::move(segmentDirectory)},
+    _serializer{std::move(serializer)},
+    _deserializer{std::move(deserializer)},
+    _ioScheduler{std::move(ioScheduler)},
+    _itemsMutex{},
+    _ioCompletedCv{},
+    _items{},
+    _segments{},
+    _spillItems{},
+    _waitingProducers{},
+    _nextSegmentId{0},
+    _isWriting{false},
+    _isReading{false},
+    _isReadFailed{false},
+    _isDisposing{false},
+    _runningIoActionsCount{0}
+  {
+    if (_inMemoryCapacity == 0)
+    {
+      throw std::invalid_argument("inMemoryCapacity");
+    }
+
+    if (_segmentCapacity == 0)
+    {
+      throw std::invalid_argument("segmentCapacity");
+    }
+
+    if (!_serializer)
+    {
+      throw std::invalid_argument("serializer");
+    }
+
+    if (!_deserializer)
+    {
+      throw std::invalid_argument("deserializer");
+    }
+
+    if (!_ioScheduler)
+    {
+      throw std::invalid_argument("ioScheduler");
+    }
+
+    std::filesystem::create_directories(_segmentDirectory);
+  }
+
+  template <typename TItem>
+  AsyncSpillingProducerConsumerCollection<TItem>::~AsyncSpillingProducerConsumerCollection()
+  {
+    std::unique_lock lock{_itemsMutex};
+    _isDisposing = true;
+    _ioCompletedCv.wait(lock, [this] { return _runningIoActionsCount == 0; });
+    for (auto& segment : _segments)
+    {
+      std::error_code errorCode;
+      std::filesystem::remove(segment->Path, errorCode);
+    }
+
+    for (auto& waitingProducer : _waitingProducers)
+    {
+      waitingProducer.SetResult();
+    }
+  }
+
+  template <typename TItem>
+  void AsyncSpillingProducerConsumerCollection<TItem>::Add(const TItem& item)
+  {
+    addItem(item);
+  }
+
+  template <typename TItem>
+  void AsyncSpillingProducerConsumerCollection<TItem>::Add(TItem&& item)
+  {
+    addItem(std::move(item));
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> AsyncSpillingProducerConsumerCollection<TItem>::AddAsync(const TItem& item)
+  {
+    return addItem(item);
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> AsyncSpillingProducerConsumerCollection<TItem>::AddAsync(TItem&& item)
+  {
+    return addItem(std::move(item));
+  }
+
+  template <typename TItem>
+  std::vector<TItem> AsyncSpillingProducerConsumerCollection<TItem>::TryTakeAll()
+  {
+    std::vector<TItem> items;
+    //Every round takes the items in memory, the take starts the read of the next segment.
+    while (true)
+    {
+      this->TryTakeMany(items, std::numeric_limits<std::size_t>::max());
+      if (!waitForSpilledItems())
+      {
+        return items;
+      }
+    }
+  }
+
+  template <typename TItem>
+  bool AsyncSpillingProducerConsumerCollection<TItem>::waitForSpilledItems()
+  {
+    //collectWork starts the read when the consumers have taken at least half of the in-memory items.
+    std::unique_lock lock{_itemsMutex};
+    _ioCompletedCv.wait(lock, [this]
+    {
+      const auto hasSpilledItems = !_segments.empty() || !_spillItems.empty();
+      return !_items.empty() || !hasSpilledItems || _isReadFailed;
+    });
+
+    return !_items.empty();
+  }
+
+  template <typename TItem>
+  std::size_t AsyncSpillingProducerConsumerCollection<TItem>::Count() const
+  {
+    std::lock_guard lock{_itemsMutex};
+    auto count = _items.size() + _spillItems.size();
+    for (auto& segment : _segments)
+    {
+      count += segment->ItemsCount;
+    }
+
+    return count;
+  }
+
+  template <typename TItem>
+  std::size_t AsyncSpillingProducerConsumerCollection<TItem>::SpilledItemsCount() const
+  {
+    std::lock_guard lock{_itemsMutex};
+    std::size_t count = 0;
+    for (auto& segment : _segments)
+    {
+      count += segment->ItemsCount;
+    }
+
+    return count;
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  Tasks::Task<void> AsyncSpillingProducerConsumerCollection<TItem>::addItem(TUItem&& item)
+  {
+    PendingWork work{};
+    std::optional<Tasks::TaskCompletionSource<void>> waitingProducer{};
+    {
+      std::lock_guard lock{_itemsMutex};
+      //The item may bypass the spill only when no older item is spilled.
+      if (_segments.empty() && _spillItems.empty() && _items.size() < _inMemoryCapacity)
+      {
+        _items.push_back(std::forward<TUItem>(item));
+        work = collectWork();
+        work.ReadableItemsCount++;
+      }
+      else
+      {
+        _spillItems.push_back(std::forward<TUItem>(item));
+        work = collectWork();
+        //The item is accepted, the producer waits until the items are written.
+        if (_spillItems.size() > MAX_UNWRITTEN_SEGMENTS * _segmentCapacity)
+        {
+          waitingProducer.emplace();
+          _waitingProducers.push_back(*waitingProducer);
+        }
+      }
+    }
+
+    runWork(std::move(work));
+    return waitingProducer
+             ? waitingProducer->GetTask()
+             : Tasks::GetCompletedTask();
+  }
+
+  template <typename TItem>
+  std::size_t AsyncSpillingProducerConsumerCollection<TItem>::popMany(std::vector<TItem>& items, std::size_t maxItems)
+  {
+    PendingWork work{};
+    std::size_t takenCount = 0;
+    {
+      std::lock_guard lock{_itemsMutex};
+      while (takenCount < maxItems && !_items.empty())
+      {
+        items.push_back(std::move(_items.front()));
+        _items.pop_front();
+        takenCount++;
+      }
+
+      work = collectWork();
+    }
+
+    runWork(std::move(work));
+    return takenCount;
+  }
+
+  template <typename TItem>
+  typename AsyncSpillingProducerConsumerCollection<TItem>::PendingWork AsyncSpillingProducerConsumerCollection<TItem>::collectWork()
+  {
+    PendingWork work{0, {}, {}};
+    if (_isDisposing)
+    {
+      return work;
+    }
+
+    //Only one segment is written at a time, so the segments are written in order.
+    if (!_isWriting && _spillItems.size() >= _segmentCapacity)
+    {
+      auto segmentPath = _segmentDirectory / ("segment_" + std::to_string(_nextSegmentId++) + ".bin");
+      auto segment = std::make_shared<Segment>(Segment{std::move(segmentPath), _segmentCapacity, false, {}});
+      segment->Items.reserve(_segmentCapacity);
+      std::move(_spillItems.begin(), _spillItems.begin() + _segmentCapacity, std::back_inserter(segment->Items));
+      _spillItems.erase(_spillItems.begin(), _spillItems.begin() + _segmentCapacity);
+      _segments.push_back(segment);
+      _isWriting = true;
+      _runningIoActionsCount++;
+      work.IoActions.push_back([this, segment] { writeSegment(segment); });
+    }
+
+    //Refill when the consumers have taken at least half of the in-memory items.
+    while (!_isReading && _items.size() <= _inMemoryCapacity / 2)
+    {
+      if (_segments.empty())
+      {
+        const auto movedCount = std::min(_spillItems.size(), _inMemoryCapacity - _items.size());
+        std::move(_spillItems.begin(), _spillItems.begin() + movedCount, std::back_inserter(_items));
+        _spillItems.erase(_spillItems.begin(), _spillItems.begin() + movedCount);
+        work.ReadableItemsCount += movedCount;
+        break;
+      }
+
+      auto segment = _segments.front();
+      if (!segment->IsWritten)
+      {
+        //The write completion collects the work again.
+        break;
+      }
+
+      if (!segment->Items.empty())
+      {
+        std::move(segment->Items.begin(), segment->Items.end(), std::back_inserter(_items));
+        work.ReadableItemsCount += segment->Items.size();
+        _segments.pop_front();
+        continue;
+      }
+
+      _isReading = true;
+      _runningIoActionsCount++;
+      work.IoActions.push_back([this, segment] { readSegment(segment); });
+    }
+
+    if (_spillItems.size() <= MAX_UNWRITTEN_SEGMENTS * _segmentCapacity)
+    {
+      std::move(_waitingProducers.begin(), _waitingProducers.end(), std::back_inserter(work.ReleasedProducers));
+      _waitingProducers.clear();
+    }
+
+    return work;
+  }
+
+  template <typename TItem>
+  void AsyncSpillingProducerConsumerCollection<TItem>::runWork(PendingWork&& work)
+  {
+    //The I/O is enqueued before the listeners are notified, the listener runs in the ioScheduler when the I/O completes.
+    for (auto& ioAction : work.IoActions)
+    {
+      _ioScheduler->EnqueueItem(std::move(ioAction));
+    }
+
+    this->publishItems(work.ReadableItemsCount);
+    if (work.ReadableItemsCount > 0)
+    {
+      //Wakes up TryTakeAll waiting for the spilled items.
+      _ioCompletedCv.notify_all();
+    }
+
+    for (auto& releasedProducer : work.ReleasedProducers)
+    {
+      releasedProducer.SetResult();
+    }
+  }
+
+  template <typename TItem>
+  void AsyncSpillingProducerConsumerCollection<TItem>::writeSegment(const SegmentPtr& segment)
+  {
+    auto isWritten = false;
+    try
+    {
+      std::ofstream segmentStream{segment->Path, std::ios::binary | std::ios::trunc};
+      for (auto& item : segment->Items)
+      {
+        const auto itemBytes = _serializer(item);
+        const std::uint64_t itemSize = itemBytes.size();
+        segmentStream.write(reinterpret_cast<const char*>(&itemSize), sizeof(itemSize));
+        segmentStream.write(itemBytes.data(), static_cast<std::streamsize>(itemBytes.size()));
+      }
+
+      segmentStream.close();
+      isWritten = static_cast<bool>(segmentStream);
+    }
+    catch (...)
+    {
+      isWritten = false;
+    }
+
+    if (!isWritten)
+    {
+      std::error_code errorCode;
+      std::filesystem::remove(segment->Path, errorCode);
+    }
+
+    PendingWork work{};
+    {
+      std::lock_guard lock{_itemsMutex};
+      if (isWritten)
+      {
+        segment->Items = std::vector<TItem>{};
+      }
+
+      segment->IsWritten = true;
+      _isWriting = false;
+      work = collectWork();
+    }
+
+    completeIoAction(std::move(work));
+  }
+
+  template <typename TItem>
+  void AsyncSpillingProducerConsumerCollection<TItem>::readSegment(const SegmentPtr& segment)
+  {
+    std::vector<TItem> items;
+    try
+    {
+      items.reserve(segment->ItemsCount);
+      std::ifstream segmentStream{segment->Path, std::ios::binary};
+      std::string itemBytes;
+      while (items.size() < segment->ItemsCount)
+      {
+        std::uint64_t itemSize = 0;
+        segmentStream.read(reinterpret_cast<char*>(&itemSize), sizeof(itemSize));
+        itemBytes.resize(static_cast<std::size_t>(itemSize));
+        segmentStream.read(itemBytes.data(), static_cast<std::streamsize>(itemSize));
+        if (!segmentStream)
+        {
+          break;
+        }
+
+        items.push_back(_deserializer(itemBytes));
+      }
+    }
+    catch (...)
+    {
+      items.clear();
+    }
+
+    const auto isRead = items.size() == segment->ItemsCount;
+    if (isRead)
+    {
+      std::error_code errorCode;
+      std::filesystem::remove(segment->Path, errorCode);
+    }
+
+    PendingWork work{0, {}, {}};
+    auto isRetryScheduled = false;
+    {
+      std::lock_guard lock{_itemsMutex};
+      _isReadFailed = !isRead;
+      if (isRead)
+      {
+        _isReading = false;
+        assert(_segments.front() == segment);
+        _segments.pop_front();
+        std::move(items.begin(), items.end(), std::back_inserter(_items));
+        work = collectWork();
+        work.ReadableItemsCount += items.size();
+      }
+      else if (_isDisposing)
+      {
+        _isReading = false;
+      }
+      else
+      {
+        //The segment stays the first one and _isReading stays set, the retry is the next running I/O action.
+        _runningIoActionsCount++;
+        isRetryScheduled = true;
+      }
+    }
+
+    if (isRetryScheduled)
+    {
+      AsyncTimer::DefaultTimer()->DelayAsync(READ_RETRY_DELAY).ContinueWith([this, segment](const auto& _)
+      {
+        readSegment(segment);
+      }, _ioScheduler);
+    }
+
+    completeIoAction(std::move(work));
+  }
+
+  template <typename TItem>
+  void AsyncSpillingProducerConsumerCollection<TItem>::completeIoAction(PendingWork&& work)
+  {
+    runWork(std::move(work));
+    //The destructor waits for the running I/O actions, do not touch the collection after the counter is decremented.
+    std::lock_guard lock{_itemsMutex};
+    _runningIoActionsCount--;
+    _ioCompletedCv.notify_all();
+  }
+}
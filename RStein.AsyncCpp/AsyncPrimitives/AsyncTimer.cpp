@@ -0,0 +1,208 @@
+﻿#include "AsyncTimer.h"
+
+#include "../Tasks/TaskCombinators.h"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  AsyncTimer::AsyncTimer(Schedulers::Scheduler::SchedulerPtr scheduler) : _scheduler{std::move(scheduler)},
+                                                                          _timerItems{},
+                                                                          _nextId{},
+                                                                          _stopped{false},
+                                                                          _timerMutex{},
+                                                                          _timerCv{},
+                                                                          _timerThread{}
+  {
+    if (!_scheduler)
+    {
+      throw invalid_argument("scheduler");
+    }
+
+    _timerThread = thread{[this]{runTimer();}};
+  }
+
+  AsyncTimer::~AsyncTimer()
+  {
+    Dispose();
+  }
+
+  AsyncTimer::AsyncTimerPtr AsyncTimer::DefaultTimer()
+  {
+    static AsyncTimerPtr defaultTimer = make_shared<AsyncTimer>(Schedulers::Scheduler::DefaultScheduler());
+    return defaultTimer;
+  }
+
+  Tasks::Task<void> AsyncTimer::DelayAsync(Clock::duration delay)
+  {
+    return DelayUntilAsync(Clock::now() + delay);
+  }
+
+  Tasks::Task<void> AsyncTimer::DelayUntilAsync(Clock::time_point deadline)
+  {
+    return DelayUntilAsync(deadline, CancellationToken::None());
+  }
+
+  Tasks::Task<void> AsyncTimer::DelayUntilAsync(Clock::time_point deadline, CancellationToken cancellationToken)
+  {
+    if (deadline <= Clock::now())
+    {
+      return Tasks::GetCompletedTask();
+    }
+
+    Tasks::TaskCompletionSource<void> delayTcs{};
+    auto delayTask = delayTcs.GetTask();
+    if (cancellationToken.IsCancellationRequested())
+    {
+      delayTcs.TrySetCanceled();
+      return delayTask;
+    }
+
+    auto isNearestDeadline = false;
+    TimerKey timerKey{};
+    {
+      lock_guard lock{_timerMutex};
+      if (_stopped)
+      {
+        throw logic_error("Timer is disposed.");
+      }
+
+      timerKey = TimerKey{deadline, _nextId++};
+      isNearestDeadline = _timerItems.empty() || deadline < _timerItems.begin()->first.first;
+      _timerItems.emplace(timerKey, TimerItem{std::move(delayTcs), std::nullopt});
+    }
+
+    if (isNearestDeadline)
+    {
+      _timerCv.notify_one();
+    }
+
+    if (!cancellationToken.CanBeCanceled())
+    {
+      return delayTask;
+    }
+
+    //Registration runs the action immediately when the cancellation has already been requested, do not hold the lock.
+    auto registration = cancellationToken.Register([this, timerKey]
+    {
+      cancelDelay(timerKey);
+    });
+
+    {
+      lock_guard lock{_timerMutex};
+      if (auto timerItemIt = _timerItems.find(timerKey); timerItemIt != _timerItems.end())
+      {
+        timerItemIt->second.Registration.emplace(std::move(registration));
+        return delayTask;
+      }
+    }
+
+    //The delay has already completed or has been canceled.
+    registration.Dispose();
+    return delayTask;
+  }
+
+  size_t AsyncTimer::PendingDelaysCount()
+  {
+    lock_guard lock{_timerMutex};
+    return _timerItems.size();
+  }
+
+  void AsyncTimer::Dispose()
+  {
+    {
+      lock_guard lock{_timerMutex};
+      if (_stopped)
+      {
+        return;
+      }
+
+      _stopped = true;
+    }
+
+    _timerCv.notify_one();
+    if (_timerThread.joinable() && _timerThread.get_id() != this_thread::get_id())
+    {
+      _timerThread.join();
+    }
+
+    vector<TimerItem> canceledTimerItems{};
+    {
+      lock_guard lock{_timerMutex};
+      for (auto& [_, timerItem] : _timerItems)
+      {
+        canceledTimerItems.push_back(std::move(timerItem));
+      }
+
+      _timerItems.clear();
+    }
+
+    for (auto& canceledTimerItem : canceledTimerItems)
+    {
+      if (canceledTimerItem.Registration)
+      {
+        canceledTimerItem.Registration->Dispose();
+      }
+
+      canceledTimerItem.DelayTcs.TrySetCanceled();
+    }
+  }
+
+  void AsyncTimer::cancelDelay(const TimerKey& timerKey)
+  {
+    optional<Tasks::TaskCompletionSource<void>> canceledDelayTcs{};
+    {
+      lock_guard lock{_timerMutex};
+      auto timerItemIt = _timerItems.find(timerKey);
+      if (timerItemIt == _timerItems.end())
+      {
+        return;
+      }
+
+      //The registration which runs this action is not disposed.
+      canceledDelayTcs.emplace(std::move(timerItemIt->second.DelayTcs));
+      _timerItems.erase(timerItemIt);
+    }
+
+    //The timer thread waiting for the removed deadline finds the next deadline after the wakeup.
+    canceledDelayTcs->TrySetCanceled();
+  }
+
+  void AsyncTimer::runTimer()
+  {
+    unique_lock lock{_timerMutex};
+    while (!_stopped)
+    {
+      if (_timerItems.empty())
+      {
+        _timerCv.wait(lock);
+        continue;
+      }
+
+      const auto deadline = _timerItems.begin()->first.first;
+      if (Clock::now() < deadline)
+      {
+        _timerCv.wait_until(lock, deadline);
+        continue;
+      }
+
+      auto timerItem = std::move(_timerItems.begin()->second);
+      _timerItems.erase(_timerItems.begin());
+      lock.unlock();
+      if (timerItem.Registration)
+      {
+        timerItem.Registration->Dispose();
+      }
+
+      _scheduler->EnqueueItem([delayTcs = timerItem.DelayTcs]
+      {
+        auto completedDelayTcs = delayTcs;
+        completedDelayTcs.TrySetResult();
+      });
+      lock.lock();
+    }
+  }
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include "CancellationToken.h"
+#include "../Schedulers/Scheduler.h"
+#include "../Tasks/Task.h"
+#include "../Tasks/TaskCompletionSource.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Completes delay tasks at their deadlines. One timer thread waits for the nearest deadline,
+  //continuations of the delay tasks run in the scheduler, so the timer thread is never blocked by them.
+  class AsyncTimer final
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using AsyncTimerPtr = std::shared_ptr<AsyncTimer>;
+
+    explicit AsyncTimer(Schedulers::Scheduler::SchedulerPtr scheduler);
+    AsyncTimer(const AsyncTimer& other) = delete;
+    AsyncTimer(AsyncTimer&& other) noexcept = delete;
+    AsyncTimer& operator=(const AsyncTimer& other) = delete;
+    AsyncTimer& operator=(AsyncTimer&& other) noexcept = delete;
+    ~AsyncTimer();
+
+    //Timer which completes delay tasks in the default scheduler.
+    static AsyncTimerPtr DefaultTimer();
+
+    [[nodiscard]] Tasks::Task<void> DelayAsync(Clock::duration delay);
+    [[nodiscard]] Tasks::Task<void> DelayUntilAsync(Clock::time_point deadline);
+    //Canceled delay is removed from the timer and the returned task is canceled.
+    [[nodiscard]] Tasks::Task<void> DelayUntilAsync(Clock::time_point deadline, CancellationToken cancellationToken);
+    //Number of delays waiting for their deadline.
+    [[nodiscard]] std::size_t PendingDelaysCount();
+    //Cancels pending delay tasks and stops the timer thread.
+    void Dispose();
+
+  private:
+    //Delays with the same deadline complete in the FIFO order.
+    using TimerKey = std::pair<Clock::time_point, unsigned long long>;
+
+    struct TimerItem
+    {
+      Tasks::TaskCompletionSource<void> DelayTcs;
+      std::optional<CancellationRegistration> Registration;
+    };
+
+    Schedulers::Scheduler::SchedulerPtr _scheduler;
+    //Ordered by the deadline, the canceled delay is removed without waiting for its deadline.
+    std::map<TimerKey, TimerItem> _timerItems;
+    unsigned long long _nextId;
+    bool _stopped;
+    std::mutex _timerMutex;
+    std::condition_variable _timerCv;
+    std::thread _timerThread;
+
+    void runTimer();
+    void cancelDelay(const TimerKey& timerKey);
+  };
+}
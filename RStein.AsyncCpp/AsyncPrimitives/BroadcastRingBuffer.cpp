@@ -0,0 +1 @@
+﻿#include "BroadcastRingBuffer.h"
@@ -0,0 +1,457 @@
+﻿#pragma once
+#include "CancellationToken.h"
+#include "OperationCanceledException.h"
+#include "../Tasks/TaskCombinators.h"
+#include "../Tasks/TaskCompletionSource.h"
+#include "../Utils/FinallyBlock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Preallocated broadcast ring buffer (LMAX Disruptor). Every item is stored once and every consumer reads the item in place.
+  //Producers claim the next sequence number when all consumers have released the slot, consumers advance their own cursors.
+  //A consumer with dependencies (barrier) reads the item only after all its dependencies have released the item.
+  //Consumers must be added before the first item is published. The capacity is rounded up to the power of two.
+  //TItem must be default constructible, the slots are preallocated and published items are assigned to the slots.
+  template <typename TItem>
+  class BroadcastRingBuffer
+  {
+  public:
+    using Sequence = std::int64_t;
+
+    enum class WaitStrategy
+    {
+      //Waiting thread checks the sequences in the loop. Lowest latency, burns the CPU core.
+      BusySpin,
+      //Waiting thread yields between the checks.
+      Yield,
+      //Waiter spins for a while, then awaits the task completed by the next publish or release. Does not block the thread.
+      Park
+    };
+
+    class Consumer
+    {
+      friend class BroadcastRingBuffer;
+    public:
+      explicit Consumer(std::vector<std::shared_ptr<Consumer>> dependencies) : _cursor{-1},
+                                                                                _dependencies{std::move(dependencies)}
+      {
+      }
+
+      Consumer(const Consumer& other) = delete;
+      Consumer(Consumer&& other) noexcept = delete;
+      Consumer& operator=(const Consumer& other) = delete;
+      Consumer& operator=(Consumer&& other) noexcept = delete;
+      ~Consumer() = default;
+
+      //The last released sequence.
+      [[nodiscard]] Sequence Cursor() const
+      {
+        return _cursor.load(std::memory_order_acquire);
+      }
+
+    private:
+      alignas(64) std::atomic<Sequence> _cursor;
+      const std::vector<std::shared_ptr<Consumer>> _dependencies;
+    };
+
+    using ConsumerPtr = std::shared_ptr<Consumer>;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+    explicit BroadcastRingBuffer(std::size_t capacity = DEFAULT_CAPACITY, WaitStrategy waitStrategy = WaitStrategy::Park);
+    BroadcastRingBuffer(const BroadcastRingBuffer& other) = delete;
+    BroadcastRingBuffer(BroadcastRingBuffer&& other) noexcept = delete;
+    BroadcastRingBuffer& operator=(const BroadcastRingBuffer& other) = delete;
+    BroadcastRingBuffer& operator=(BroadcastRingBuffer&& other) noexcept = delete;
+    ~BroadcastRingBuffer();
+
+    //Consumer reads items after all dependencies have released them.
+    ConsumerPtr AddConsumer(std::vector<ConsumerPtr> dependencies = {});
+    //Publishes the item only if the slot is free.
+    bool TryPublish(const TItem& item);
+    bool TryPublish(TItem&& item);
+    //Waits (wait strategy) until all consumers release the slot, then publishes the item.
+    Tasks::Task<void> PublishAsync(TItem item);
+    Tasks::Task<void> PublishAsync(TItem item, CancellationToken cancellationToken);
+    //Waits for the next sequence of the consumer (Cursor() + 1). Returns the highest sequence available to the consumer,
+    //so the consumer can process all items up to the returned sequence before the next wait.
+    Tasks::Task<Sequence> WaitForAsync(const ConsumerPtr& consumer);
+    Tasks::Task<Sequence> WaitForAsync(const ConsumerPtr& consumer, CancellationToken cancellationToken);
+    //The item is valid until the consumer releases the sequence.
+    [[nodiscard]] const TItem& Get(Sequence sequence) const;
+    //Releases all items up to the sequence (inclusive) for producers and dependent consumers.
+    void Release(const ConsumerPtr& consumer, Sequence sequence);
+    [[nodiscard]] std::size_t Capacity() const;
+
+  private:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+    static constexpr int PARK_SPIN_COUNT = 100;
+
+    struct Slot
+    {
+      std::atomic<Sequence> PublishedSequence{-1};
+      TItem Item{};
+    };
+
+    const std::size_t _capacity;
+    const std::size_t _mask;
+    const WaitStrategy _waitStrategy;
+    std::unique_ptr<Slot[]> _slots;
+    std::vector<ConsumerPtr> _consumers;
+    alignas(CACHE_LINE_SIZE) std::atomic<Sequence> _nextSequence;
+    alignas(CACHE_LINE_SIZE) std::atomic<Sequence> _cachedGatingSequence;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _parkedWaitersCount;
+    std::mutex _parkedWaitersMutex;
+    Tasks::TaskCompletionSource<void> _parkedWaitersTcs;
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t capacity);
+    [[nodiscard]] Sequence getGatingSequence() const;
+    [[nodiscard]] Sequence getAvailableSequence(const Consumer& consumer) const;
+    bool tryClaim(Sequence& sequence);
+    template <typename TUItem>
+    void publish(Sequence sequence, TUItem&& item);
+    template <typename TCondition>
+    Tasks::Task<void> waitUntil(TCondition condition, CancellationToken cancellationToken);
+    Tasks::Task<void> publishAsync(TItem item, CancellationToken cancellationToken);
+    Tasks::Task<Sequence> waitForAsync(ConsumerPtr consumer, CancellationToken cancellationToken);
+    Tasks::Task<void> getParkedWaitersTask();
+    void signalParkedWaiters();
+  };
+
+  template <typename TItem>
+  BroadcastRingBuffer<TItem>::BroadcastRingBuffer(std::size_t capacity, WaitStrategy waitStrategy) : _capacity{roundUpToPowerOfTwo(capacity)},
+                                                                                                    _mask{_capacity - 1},
+                                                                                                    _waitStrategy{waitStrategy},
+                                                                                                    _slots{std::make_unique<Slot[]>(_capacity)},
+                                                                                                    _consumers{},
+                                                                                                    _nextSequence{0},
+                                                                                                    _cachedGatingSequence{-1},
+                                                                                                    _parkedWaitersCount{0},
+                                                                                                    _parkedWaitersMutex{},
+                                                                                                    _parkedWaitersTcs{}
+  {
+  }
+
+  template <typename TItem>
+  BroadcastRingBuffer<TItem>::~BroadcastRingBuffer()
+  {
+    //Do not lock in the destructor.
+    _parkedWaitersTcs.TrySetException(std::make_exception_ptr(OperationCanceledException{}));
+  }
+
+  template <typename TItem>
+  typename BroadcastRingBuffer<TItem>::ConsumerPtr BroadcastRingBuffer<TItem>::AddConsumer(std::vector<ConsumerPtr> dependencies)
+  {
+    if (_nextSequence.load() != 0)
+    {
+      throw std::logic_error("Consumer must be added before the first item is published.");
+    }
+
+    for (auto& dependency : dependencies)
+    {
+      if (std::find(_consumers.begin(), _consumers.end(), dependency) == _consumers.end())
+      {
+        throw std::invalid_argument("dependencies");
+      }
+    }
+
+    auto consumer = std::make_shared<Consumer>(std::move(dependencies));
+    _consumers.push_back(consumer);
+    return consumer;
+  }
+
+  template <typename TItem>
+  bool BroadcastRingBuffer<TItem>::TryPublish(const TItem& item)
+  {
+    Sequence sequence;
+    if (!tryClaim(sequence))
+    {
+      return false;
+    }
+
+    publish(sequence, item);
+    return true;
+  }
+
+  template <typename TItem>
+  bool BroadcastRingBuffer<TItem>::TryPublish(TItem&& item)
+  {
+    Sequence sequence;
+    if (!tryClaim(sequence))
+    {
+      return false;
+    }
+
+    publish(sequence, std::move(item));
+    return true;
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> BroadcastRingBuffer<TItem>::PublishAsync(TItem item)
+  {
+    return PublishAsync(std::move(item), CancellationToken::None());
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> BroadcastRingBuffer<TItem>::PublishAsync(TItem item, CancellationToken cancellationToken)
+  {
+    if (TryPublish(std::move(item)))
+    {
+      return Tasks::GetCompletedTask();
+    }
+
+    //The item has not been moved by the failed TryPublish.
+    return publishAsync(std::move(item), std::move(cancellationToken));
+  }
+
+  template <typename TItem>
+  Tasks::Task<typename BroadcastRingBuffer<TItem>::Sequence> BroadcastRingBuffer<TItem>::WaitForAsync(const ConsumerPtr& consumer)
+  {
+    return WaitForAsync(consumer, CancellationToken::None());
+  }
+
+  template <typename TItem>
+  Tasks::Task<typename BroadcastRingBuffer<TItem>::Sequence> BroadcastRingBuffer<TItem>::WaitForAsync(const ConsumerPtr& consumer, CancellationToken cancellationToken)
+  {
+    if (!consumer)
+    {
+      throw std::invalid_argument("consumer");
+    }
+
+    const auto availableSequence = getAvailableSequence(*consumer);
+    if (availableSequence > consumer->Cursor())
+    {
+      return Tasks::TaskFromResult(availableSequence);
+    }
+
+    return waitForAsync(consumer, std::move(cancellationToken));
+  }
+
+  template <typename TItem>
+  const TItem& BroadcastRingBuffer<TItem>::Get(Sequence sequence) const
+  {
+    return _slots[static_cast<std::size_t>(sequence) & _mask].Item;
+  }
+
+  template <typename TItem>
+  void BroadcastRingBuffer<TItem>::Release(const ConsumerPtr& consumer, Sequence sequence)
+  {
+    consumer->_cursor.store(sequence, std::memory_order_release);
+    signalParkedWaiters();
+  }
+
+  template <typename TItem>
+  std::size_t BroadcastRingBuffer<TItem>::Capacity() const
+  {
+    return _capacity;
+  }
+
+  template <typename TItem>
+  std::size_t BroadcastRingBuffer<TItem>::roundUpToPowerOfTwo(std::size_t capacity)
+  {
+    if (capacity == 0 || capacity > (std::numeric_limits<std::size_t>::max() >> 1) + 1)
+    {
+      throw std::invalid_argument("capacity");
+    }
+
+    std::size_t roundedCapacity = 1;
+    while (roundedCapacity < capacity)
+    {
+      roundedCapacity <<= 1;
+    }
+
+    return roundedCapacity;
+  }
+
+  template <typename TItem>
+  typename BroadcastRingBuffer<TItem>::Sequence BroadcastRingBuffer<TItem>::getGatingSequence() const
+  {
+    //Dependent consumers never pass their dependencies, but the minimum of all cursors is cheap for the usual number of consumers.
+    auto gatingSequence = std::numeric_limits<Sequence>::max();
+    for (auto& consumer : _consumers)
+    {
+      gatingSequence = std::min(gatingSequence, consumer->Cursor());
+    }
+
+    return gatingSequence;
+  }
+
+  template <typename TItem>
+  typename BroadcastRingBuffer<TItem>::Sequence BroadcastRingBuffer<TItem>::getAvailableSequence(const Consumer& consumer) const
+  {
+    if (!consumer._dependencies.empty())
+    {
+      //Dependencies have released only the published items.
+      auto availableSequence = std::numeric_limits<Sequence>::max();
+      for (auto& dependency : consumer._dependencies)
+      {
+        availableSequence = std::min(availableSequence, dependency->Cursor());
+      }
+
+      return availableSequence;
+    }
+
+    //Producers publish the claimed sequences in any order, the consumer reads only the contiguous published sequences.
+    auto availableSequence = consumer.Cursor();
+    const auto maxSequence = availableSequence + static_cast<Sequence>(_capacity);
+    while (availableSequence < maxSequence)
+    {
+      const auto nextSequence = availableSequence + 1;
+      if (_slots[static_cast<std::size_t>(nextSequence) & _mask].PublishedSequence.load(std::memory_order_acquire) != nextSequence)
+      {
+        break;
+      }
+
+      availableSequence = nextSequence;
+    }
+
+    return availableSequence;
+  }
+
+  template <typename TItem>
+  bool BroadcastRingBuffer<TItem>::tryClaim(Sequence& sequence)
+  {
+    sequence = _nextSequence.load(std::memory_order_relaxed);
+    do
+    {
+      const auto wrapSequence = sequence - static_cast<Sequence>(_capacity);
+      if (wrapSequence > _cachedGatingSequence.load(std::memory_order_acquire))
+      {
+        const auto gatingSequence = getGatingSequence();
+        _cachedGatingSequence.store(gatingSequence, std::memory_order_release);
+        if (wrapSequence > gatingSequence)
+        {
+          return false;
+        }
+      }
+    } while (!_nextSequence.compare_exchange_weak(sequence, sequence + 1));
+
+    return true;
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  void BroadcastRingBuffer<TItem>::publish(Sequence sequence, TUItem&& item)
+  {
+    auto& slot = _slots[static_cast<std::size_t>(sequence) & _mask];
+    slot.Item = std::forward<TUItem>(item);
+    slot.PublishedSequence.store(sequence, std::memory_order_release);
+    signalParkedWaiters();
+  }
+
+  template <typename TItem>
+  template <typename TCondition>
+  Tasks::Task<void> BroadcastRingBuffer<TItem>::waitUntil(TCondition condition, CancellationToken cancellationToken)
+  {
+    auto spinCount = 0;
+    std::optional<CancellationRegistration> cancellationRegistration{};
+    Utils::FinallyBlock finally{[&cancellationRegistration]
+    {
+      if (cancellationRegistration)
+      {
+        cancellationRegistration->Dispose();
+      }
+    }};
+
+    while (!condition())
+    {
+      cancellationToken.ThrowIfCancellationRequested();
+      if (_waitStrategy == WaitStrategy::BusySpin)
+      {
+        continue;
+      }
+
+      if (_waitStrategy == WaitStrategy::Yield || spinCount < PARK_SPIN_COUNT)
+      {
+        spinCount++;
+        std::this_thread::yield();
+        continue;
+      }
+
+      if (!cancellationRegistration && cancellationToken.CanBeCanceled())
+      {
+        //Cancellation wakes all parked waiters, the canceled waiter throws in the next iteration.
+        cancellationRegistration = cancellationToken.Register([this]
+        {
+          signalParkedWaiters();
+        });
+      }
+
+      auto parkedTask = getParkedWaitersTask();
+      //The publish or release that changes the condition after this check sees the parked waiter (getParkedWaitersTask) and completes the task.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (condition())
+      {
+        break;
+      }
+
+      co_await parkedTask;
+    }
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> BroadcastRingBuffer<TItem>::publishAsync(TItem item, CancellationToken cancellationToken)
+  {
+    Sequence sequence{};
+    co_await waitUntil([this, &sequence]
+    {
+      return tryClaim(sequence);
+    }, cancellationToken);
+
+    publish(sequence, std::move(item));
+  }
+
+  template <typename TItem>
+  Tasks::Task<typename BroadcastRingBuffer<TItem>::Sequence> BroadcastRingBuffer<TItem>::waitForAsync(ConsumerPtr consumer, CancellationToken cancellationToken)
+  {
+    auto availableSequence = consumer->Cursor();
+    co_await waitUntil([this, &consumer, &availableSequence]
+    {
+      availableSequence = getAvailableSequence(*consumer);
+      return availableSequence > consumer->Cursor();
+    }, cancellationToken);
+
+    co_return availableSequence;
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> BroadcastRingBuffer<TItem>::getParkedWaitersTask()
+  {
+    std::lock_guard lock{_parkedWaitersMutex};
+    _parkedWaitersCount.fetch_add(1);
+    return _parkedWaitersTcs.GetTask();
+  }
+
+  template <typename TItem>
+  void BroadcastRingBuffer<TItem>::signalParkedWaiters()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_parkedWaitersCount.load() == 0)
+    {
+      return;
+    }
+
+    Tasks::TaskCompletionSource<void> parkedWaitersTcs{};
+    {
+      std::lock_guard lock{_parkedWaitersMutex};
+      std::swap(parkedWaitersTcs, _parkedWaitersTcs);
+      _parkedWaitersCount.store(0);
+    }
+
+    //Woken waiters check their conditions again.
+    parkedWaitersTcs.TrySetResult();
+  }
+}
@@ -0,0 +1 @@
+﻿#include "Channel.h"
@@ -0,0 +1,559 @@
+﻿#pragma once
+#include "CancellationToken.h"
+#include "IAsyncProducerConsumerCollection.h"
+#include "../Detail/AsyncPrimitives/ItemAddedListeners.h"
+#include "OperationCanceledException.h"
+#include "../Tasks/TaskCombinators.h"
+#include "../Tasks/TaskCompletionSource.h"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Bounded multi-producer multi-consumer collection (ring buffer with per-cell sequence numbers, D. Vyukov).
+  //Add and take do not lock when the ring has an item/a free cell. Waiters are parked only when the ring is empty (TakeAsync) or full (AddAsync),
+  //the parked waiters are served by the thread which changes the state of the ring.
+  //The capacity is rounded up to the power of two (at least 2).
+  template <typename TItem>
+  class Channel : public IAsyncProducerConsumerCollection<TItem>
+  {
+  public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+    explicit Channel(std::size_t capacity = DEFAULT_CAPACITY);
+    Channel(const Channel& other) = delete;
+    Channel(Channel&& other) noexcept = delete;
+    Channel& operator=(const Channel& other) = delete;
+    Channel& operator=(Channel&& other) noexcept = delete;
+    virtual ~Channel();
+
+    //Blocks the calling thread while the channel is full. Prefer AddAsync.
+    void Add(const TItem& item) override;
+    void Add(TItem&& item) override;
+    Tasks::Task<void> AddAsync(const TItem& item) override;
+    Tasks::Task<void> AddAsync(TItem&& item) override;
+    Tasks::Task<TItem> TakeAsync() override;
+    Tasks::Task<TItem> TakeAsync(CancellationToken cancellationToken) override;
+    Tasks::Task<std::size_t> TakeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken) override;
+    std::vector<TItem> TryTakeAll() override;
+    std::size_t TryTakeMany(std::vector<TItem>& items, std::size_t maxItems) override;
+    void AddItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) override;
+    void RemoveItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) override;
+    [[nodiscard]] std::size_t Capacity() const;
+
+  private:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    struct Cell
+    {
+      std::atomic<std::size_t> Sequence{};
+      std::optional<TItem> Item{};
+    };
+
+    struct TakeWaiter
+    {
+      Tasks::TaskCompletionSource<TItem> WaiterTcs{};
+      std::optional<CancellationRegistration> Registration{};
+      bool IsParked{true};
+    };
+
+    struct AddWaiter
+    {
+      explicit AddWaiter(TItem item) : Item{std::move(item)}
+      {
+      }
+
+      TItem Item;
+      Tasks::TaskCompletionSource<void> WaiterTcs{};
+      bool IsParked{true};
+    };
+
+    using TakeWaiterPtr = std::shared_ptr<TakeWaiter>;
+    using AddWaiterPtr = std::shared_ptr<AddWaiter>;
+
+    const std::size_t _capacity;
+    const std::size_t _mask;
+    std::unique_ptr<Cell[]> _cells;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _enqueuePosition;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _dequeuePosition;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _takeWaitersCount;
+    std::atomic<std::size_t> _addWaitersCount;
+    std::mutex _waitersMutex;
+    std::deque<TakeWaiterPtr> _takeWaiters;
+    std::deque<AddWaiterPtr> _addWaiters;
+    Detail::ItemAddedListeners<TItem> _itemAddedListeners;
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t capacity);
+    template <typename TUItem>
+    bool tryEnqueue(TUItem&& item);
+    std::optional<TItem> tryDequeue();
+    template <typename TUItem>
+    Tasks::Task<void> addAsync(TUItem&& item);
+    Tasks::Task<std::size_t> takeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken);
+    void onItemAdded();
+    void onItemTaken();
+    void serveWaiters();
+    void cancelTakeWaiter(const TakeWaiterPtr& waiter);
+  };
+
+  template <typename TItem>
+  Channel<TItem>::Channel(std::size_t capacity) : IAsyncProducerConsumerCollection<TItem>{},
+                                                  _capacity{roundUpToPowerOfTwo(capacity)},
+                                                  _mask{_capacity - 1},
+                                                  _cells{std::make_unique<Cell[]>(_capacity)},
+                                                  _enqueuePosition{0},
+                                                  _dequeuePosition{0},
+                                                  _takeWaitersCount{0},
+                                                  _addWaitersCount{0},
+                                                  _waitersMutex{},
+                                                  _takeWaiters{},
+                                                  _addWaiters{},
+                                                  _itemAddedListeners{}
+  {
+    for (std::size_t i = 0; i < _capacity; ++i)
+    {
+      _cells[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  template <typename TItem>
+  Channel<TItem>::~Channel()
+  {
+    //Do not lock in the destructor.
+    for (auto& waiter : _takeWaiters)
+    {
+      if (waiter->Registration)
+      {
+        waiter->Registration->Dispose();
+      }
+
+      waiter->WaiterTcs.TrySetException(std::make_exception_ptr(OperationCanceledException{}));
+    }
+
+    for (auto& waiter : _addWaiters)
+    {
+      waiter->WaiterTcs.TrySetException(std::make_exception_ptr(OperationCanceledException{}));
+    }
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::Add(const TItem& item)
+  {
+    if (tryEnqueue(item))
+    {
+      onItemAdded();
+      return;
+    }
+
+    addAsync(item).Wait();
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::Add(TItem&& item)
+  {
+    if (tryEnqueue(std::move(item)))
+    {
+      onItemAdded();
+      return;
+    }
+
+    addAsync(std::move(item)).Wait();
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> Channel<TItem>::AddAsync(const TItem& item)
+  {
+    return addAsync(item);
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> Channel<TItem>::AddAsync(TItem&& item)
+  {
+    return addAsync(std::move(item));
+  }
+
+  template <typename TItem>
+  Tasks::Task<TItem> Channel<TItem>::TakeAsync()
+  {
+    return TakeAsync(CancellationToken::None());
+  }
+
+  template <typename TItem>
+  Tasks::Task<TItem> Channel<TItem>::TakeAsync(CancellationToken cancellationToken)
+  {
+    if (auto item = tryDequeue())
+    {
+      onItemTaken();
+      return Tasks::TaskFromResult(std::move(*item));
+    }
+
+    auto waiter = std::make_shared<TakeWaiter>();
+    auto isParked = true;
+    {
+      std::lock_guard lock{_waitersMutex};
+      //Publish the waiter before the last attempt, the producers check the counter after the item is added.
+      _takeWaitersCount.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (auto item = tryDequeue())
+      {
+        _takeWaitersCount.fetch_sub(1, std::memory_order_relaxed);
+        waiter->WaiterTcs.SetResult(std::move(*item));
+        waiter->IsParked = false;
+        isParked = false;
+      }
+      else
+      {
+        _takeWaiters.push_back(waiter);
+      }
+    }
+
+    if (!isParked)
+    {
+      onItemTaken();
+      return waiter->WaiterTcs.GetTask();
+    }
+
+    //The cancellation action runs inline when the token is already canceled, so register it outside of the lock.
+    if (cancellationToken.CanBeCanceled())
+    {
+      auto registration = cancellationToken.Register([this, waiter]{cancelTakeWaiter(waiter);});
+      std::unique_lock lock{_waitersMutex};
+      if (waiter->IsParked)
+      {
+        waiter->Registration.emplace(std::move(registration));
+      }
+      else
+      {
+        lock.unlock();
+        registration.Dispose();
+      }
+    }
+
+    return waiter->WaiterTcs.GetTask();
+  }
+
+  template <typename TItem>
+  Tasks::Task<std::size_t> Channel<TItem>::TakeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken)
+  {
+    if (maxItems == 0)
+    {
+      throw std::invalid_argument("maxItems");
+    }
+
+    //Available items are taken without the coroutine frame.
+    const auto takenCount = TryTakeMany(items, maxItems);
+    if (takenCount > 0)
+    {
+      return Tasks::TaskFromResult(takenCount);
+    }
+
+    return takeManyAsync(items, maxItems, std::move(cancellationToken));
+  }
+
+  template <typename TItem>
+  std::vector<TItem> Channel<TItem>::TryTakeAll()
+  {
+    std::vector<TItem> items{};
+    while (auto item = tryDequeue())
+    {
+      items.push_back(std::move(*item));
+    }
+
+    if (!items.empty())
+    {
+      onItemTaken();
+    }
+
+    return items;
+  }
+
+  template <typename TItem>
+  std::size_t Channel<TItem>::TryTakeMany(std::vector<TItem>& items, std::size_t maxItems)
+  {
+    std::size_t takenCount = 0;
+    while (takenCount < maxItems)
+    {
+      auto item = tryDequeue();
+      if (!item)
+      {
+        break;
+      }
+
+      items.push_back(std::move(*item));
+      ++takenCount;
+    }
+
+    if (takenCount > 0)
+    {
+      onItemTaken();
+    }
+
+    return takenCount;
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::AddItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener)
+  {
+    _itemAddedListeners.Add(listener);
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::RemoveItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener)
+  {
+    _itemAddedListeners.Remove(listener);
+  }
+
+  template <typename TItem>
+  std::size_t Channel<TItem>::Capacity() const
+  {
+    return _capacity;
+  }
+
+  template <typename TItem>
+  std::size_t Channel<TItem>::roundUpToPowerOfTwo(std::size_t capacity)
+  {
+    if (capacity == 0)
+    {
+      throw std::invalid_argument("capacity");
+    }
+
+    //The sequence numbers of the cells cannot distinguish a full ring from an empty ring with only one cell.
+    std::size_t roundedCapacity = 2;
+    while (roundedCapacity < capacity)
+    {
+      roundedCapacity <<= 1;
+    }
+
+    return roundedCapacity;
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  bool Channel<TItem>::tryEnqueue(TUItem&& item)
+  {
+    auto position = _enqueuePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+      auto& cell = _cells[position & _mask];
+      const auto sequence = cell.Sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+      if (difference == 0)
+      {
+        if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          cell.Item.emplace(std::forward<TUItem>(item));
+          cell.Sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0)
+      {
+        //Full.
+        return false;
+      }
+      else
+      {
+        position = _enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  template <typename TItem>
+  std::optional<TItem> Channel<TItem>::tryDequeue()
+  {
+    auto position = _dequeuePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+      auto& cell = _cells[position & _mask];
+      const auto sequence = cell.Sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+      if (difference == 0)
+      {
+        if (_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          std::optional<TItem> item{std::move(cell.Item)};
+          cell.Item.reset();
+          cell.Sequence.store(position + _mask + 1, std::memory_order_release);
+          return item;
+        }
+      }
+      else if (difference < 0)
+      {
+        //Empty.
+        return std::nullopt;
+      }
+      else
+      {
+        position = _dequeuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  Tasks::Task<void> Channel<TItem>::addAsync(TUItem&& item)
+  {
+    if (tryEnqueue(std::forward<TUItem>(item)))
+    {
+      onItemAdded();
+      return Tasks::GetCompletedTask();
+    }
+
+    //tryEnqueue does not consume the item when the channel is full.
+    auto waiter = std::make_shared<AddWaiter>(TItem{std::forward<TUItem>(item)});
+    auto isParked = true;
+    {
+      std::lock_guard lock{_waitersMutex};
+      _addWaitersCount.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (tryEnqueue(std::move(waiter->Item)))
+      {
+        _addWaitersCount.fetch_sub(1, std::memory_order_relaxed);
+        waiter->WaiterTcs.SetResult();
+        waiter->IsParked = false;
+        isParked = false;
+      }
+      else
+      {
+        _addWaiters.push_back(waiter);
+      }
+    }
+
+    if (!isParked)
+    {
+      onItemAdded();
+    }
+
+    return waiter->WaiterTcs.GetTask();
+  }
+
+  template <typename TItem>
+  Tasks::Task<std::size_t> Channel<TItem>::takeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken)
+  {
+    //Only the first item is awaited, the items added in the meantime are taken in one operation.
+    items.push_back(co_await TakeAsync(std::move(cancellationToken)));
+    co_return 1 + TryTakeMany(items, maxItems - 1);
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::onItemAdded()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_takeWaitersCount.load(std::memory_order_relaxed) > 0)
+    {
+      serveWaiters();
+    }
+
+    _itemAddedListeners.Notify(*this);
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::onItemTaken()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_addWaitersCount.load(std::memory_order_relaxed) > 0)
+    {
+      serveWaiters();
+    }
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::serveWaiters()
+  {
+    std::vector<std::pair<TakeWaiterPtr, TItem>> servedTakeWaiters{};
+    std::vector<CancellationRegistration> servedRegistrations{};
+    std::vector<AddWaiterPtr> servedAddWaiters{};
+    {
+      std::lock_guard lock{_waitersMutex};
+      auto hasProgress = false;
+      do
+      {
+        hasProgress = false;
+        while (!_takeWaiters.empty())
+        {
+          auto item = tryDequeue();
+          if (!item)
+          {
+            break;
+          }
+
+          auto waiter = std::move(_takeWaiters.front());
+          _takeWaiters.pop_front();
+          waiter->IsParked = false;
+          if (waiter->Registration)
+          {
+            servedRegistrations.push_back(std::move(*waiter->Registration));
+            waiter->Registration.reset();
+          }
+
+          servedTakeWaiters.emplace_back(std::move(waiter), std::move(*item));
+        }
+
+        while (!_addWaiters.empty())
+        {
+          auto& waiter = _addWaiters.front();
+          if (!tryEnqueue(std::move(waiter->Item)))
+          {
+            break;
+          }
+
+          waiter->IsParked = false;
+          servedAddWaiters.push_back(std::move(waiter));
+          _addWaiters.pop_front();
+          hasProgress = true;
+        }
+      } while (hasProgress && !_takeWaiters.empty());
+
+      _takeWaitersCount.store(_takeWaiters.size(), std::memory_order_seq_cst);
+      _addWaitersCount.store(_addWaiters.size(), std::memory_order_seq_cst);
+    }
+
+    //Continuations of the waiters may run inline, do not hold the lock.
+    for (auto& [waiter, item] : servedTakeWaiters)
+    {
+      waiter->WaiterTcs.TrySetResult(std::move(item));
+    }
+
+    for (auto& registration : servedRegistrations)
+    {
+      registration.Dispose();
+    }
+
+    for (auto& waiter : servedAddWaiters)
+    {
+      waiter->WaiterTcs.TrySetResult();
+    }
+
+    //Items of the served producers have been added to the ring.
+    if (!servedAddWaiters.empty())
+    {
+      _itemAddedListeners.Notify(*this);
+    }
+  }
+
+  template <typename TItem>
+  void Channel<TItem>::cancelTakeWaiter(const TakeWaiterPtr& waiter)
+  {
+    {
+      std::lock_guard lock{_waitersMutex};
+      if (!waiter->IsParked)
+      {
+        return;
+      }
+
+      waiter->IsParked = false;
+      std::erase(_takeWaiters, waiter);
+      _takeWaitersCount.store(_takeWaiters.size(), std::memory_order_seq_cst);
+    }
+
+    waiter->WaiterTcs.TrySetException(std::make_exception_ptr(OperationCanceledException{}));
+  }
+}
@@ -0,0 +1 @@
+﻿#include "ConflatingChannel.h"
@@ -0,0 +1,167 @@
+﻿#pragma once
+#include "../Detail/AsyncPrimitives/SemaphoreGuardedCollection.h"
+#include "../Tasks/TaskCombinators.h"
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Unbounded collection which keeps only the latest item for every key (market data, configuration).
+  //The item added for the key with an unconsumed item replaces the unconsumed item and keeps its position,
+  //so the collection contains at most one item for every distinct key and consumers take the changed keys in the order of the first change.
+  template <typename TItem, typename TKey = TItem, typename THash = std::hash<TKey>, typename TKeyEqual = std::equal_to<TKey>>
+  class ConflatingChannel : public Detail::SemaphoreGuardedCollection<TItem, ConflatingChannel<TItem, TKey, THash, TKeyEqual>>
+  {
+  public:
+    using KeySelectorFuncType = std::function<TKey(const TItem& item)>;
+
+    explicit ConflatingChannel(KeySelectorFuncType keySelector = [](const TItem& item) { return TKey{item}; });
+    ConflatingChannel(const ConflatingChannel& other) = delete;
+    ConflatingChannel(ConflatingChannel&& other) noexcept = delete;
+    ConflatingChannel& operator=(const ConflatingChannel& other) = delete;
+    ConflatingChannel& operator=(ConflatingChannel&& other) noexcept = delete;
+    virtual ~ConflatingChannel() = default;
+
+    void Add(const TItem& item) override;
+    void Add(TItem&& item) override;
+    Tasks::Task<void> AddAsync(const TItem& item) override;
+    Tasks::Task<void> AddAsync(TItem&& item) override;
+    //Number of keys with an unconsumed item.
+    [[nodiscard]] std::size_t Count() const;
+    //Number of unconsumed items replaced by a newer item for the same key.
+    [[nodiscard]] std::size_t ConflatedItemsCount() const;
+
+  private:
+    friend class Detail::SemaphoreGuardedCollection<TItem, ConflatingChannel>;
+
+    struct Entry
+    {
+      TKey Key;
+      TItem Item;
+    };
+
+    using Entries = std::list<Entry>;
+
+    KeySelectorFuncType _keySelector;
+    mutable std::mutex _entriesMutex;
+    //Changed keys in the order of the first change.
+    Entries _entries;
+    std::unordered_map<TKey, typename Entries::iterator, THash, TKeyEqual> _entriesByKey;
+    std::size_t _conflatedItemsCount;
+
+    template <typename TUItem>
+    void addItem(TUItem&& item);
+    std::size_t popMany(std::vector<TItem>& items, std::size_t maxItems);
+  };
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  ConflatingChannel<TItem, TKey, THash, TKeyEqual>::ConflatingChannel(KeySelectorFuncType keySelector) :
+    Detail::SemaphoreGuardedCollection<TItem, ConflatingChannel>(),
+    _keySelector{std::move(keySelector)},
+    _entriesMutex{},
+    _entries{},
+    _entriesByKey{},
+    _conflatedItemsCount{0}
+  {
+    if (!_keySelector)
+    {
+      throw std::invalid_argument("keySelector");
+    }
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  void ConflatingChannel<TItem, TKey, THash, TKeyEqual>::Add(const TItem& item)
+  {
+    addItem(item);
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  void ConflatingChannel<TItem, TKey, THash, TKeyEqual>::Add(TItem&& item)
+  {
+    addItem(std::move(item));
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  Tasks::Task<void> ConflatingChannel<TItem, TKey, THash, TKeyEqual>::AddAsync(const TItem& item)
+  {
+    addItem(item);
+    return Tasks::GetCompletedTask();
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  Tasks::Task<void> ConflatingChannel<TItem, TKey, THash, TKeyEqual>::AddAsync(TItem&& item)
+  {
+    addItem(std::move(item));
+    return Tasks::GetCompletedTask();
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  std::size_t ConflatingChannel<TItem, TKey, THash, TKeyEqual>::Count() const
+  {
+    std::lock_guard lock{_entriesMutex};
+    return _entries.size();
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  std::size_t ConflatingChannel<TItem, TKey, THash, TKeyEqual>::ConflatedItemsCount() const
+  {
+    std::lock_guard lock{_entriesMutex};
+    return _conflatedItemsCount;
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  template <typename TUItem>
+  void ConflatingChannel<TItem, TKey, THash, TKeyEqual>::addItem(TUItem&& item)
+  {
+    auto key = _keySelector(item);
+    {
+      std::lock_guard lock{_entriesMutex};
+      auto entryIt = _entriesByKey.find(key);
+      if (entryIt != _entriesByKey.end())
+      {
+        //The unconsumed item already owns a permit.
+        entryIt->second->Item = std::forward<TUItem>(item);
+        _conflatedItemsCount++;
+        return;
+      }
+
+      _entries.push_back(Entry{key, std::forward<TUItem>(item)});
+      try
+      {
+        _entriesByKey.emplace(std::move(key), std::prev(_entries.end()));
+      }
+      catch (...)
+      {
+        _entries.pop_back();
+        throw;
+      }
+    }
+
+    //One permit for every key with an unconsumed item.
+    this->publishItems(1);
+  }
+
+  template <typename TItem, typename TKey, typename THash, typename TKeyEqual>
+  std::size_t ConflatingChannel<TItem, TKey, THash, TKeyEqual>::popMany(std::vector<TItem>& items, std::size_t maxItems)
+  {
+    std::lock_guard lock{_entriesMutex};
+    std::size_t takenCount = 0;
+    while (takenCount < maxItems && !_entries.empty())
+    {
+      auto& entry = _entries.front();
+      _entriesByKey.erase(entry.Key);
+      items.push_back(std::move(entry.Item));
+      _entries.pop_front();
+      takenCount++;
+    }
+
+    return takenCount;
+  }
+}
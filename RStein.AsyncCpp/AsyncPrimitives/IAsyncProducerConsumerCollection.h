@@ -3,10 +3,30 @@
 #include "../Tasks/Task.h"
 
 
+#include <cstddef>
+#include <memory>
 #include <vector>
 
 namespace RStein::AsyncCpp::AsyncPrimitives
 {
+  template<typename TItem>
+  class IAsyncProducerConsumerCollection;
+
+  template<typename TItem>
+  class IItemAddedListener
+  {
+  public:
+    IItemAddedListener() = default;
+    IItemAddedListener(const IItemAddedListener& other) = delete;
+    IItemAddedListener(IItemAddedListener&& other) noexcept = delete;
+    IItemAddedListener& operator=(const IItemAddedListener& other) = delete;
+    IItemAddedListener& operator=(IItemAddedListener&& other) noexcept = delete;
+    virtual ~IItemAddedListener() = default;
+
+    //Called outside of the collection locks after an item has been added to the collection. The item may already have been taken by another consumer.
+    virtual void OnItemAdded(IAsyncProducerConsumerCollection<TItem>& collection) = 0;
+  };
+
   template<typename TItem>
   class IAsyncProducerConsumerCollection
   {
@@ -25,7 +45,16 @@ namespace RStein::AsyncCpp::AsyncPrimitives
     virtual Tasks::Task<void> AddAsync(TItem&& item) = 0;
     virtual Tasks::Task<TItem> TakeAsync()  = 0;
     virtual Tasks::Task<TItem> TakeAsync(CancellationToken cancellationToken) = 0;
+    //Waits for at least one item, then appends at most maxItems available items to the items vector. Returns the number of appended items.
+    //The items vector must live until the returned task completes.
+    virtual Tasks::Task<std::size_t> TakeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken) = 0;
     virtual std::vector<TItem> TryTakeAll() = 0;
+    //Appends at most maxItems available items to the items vector without waiting. Returns the number of appended items.
+    virtual std::size_t TryTakeMany(std::vector<TItem>& items, std::size_t maxItems) = 0;
+    //Used by the Select. The collection only notifies the listener (OnItemAdded), it never takes an item on behalf of the listener.
+    //The notified listener may take at most one item itself (TryTakeMany), so no item is lost when the listener is not interested in the item anymore.
+    virtual void AddItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) = 0;
+    virtual void RemoveItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) = 0;
 
   };
 
@@ -0,0 +1 @@
+﻿#include "Select.h"
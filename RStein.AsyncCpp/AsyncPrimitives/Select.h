@@ -0,0 +1,265 @@
+﻿#pragma once
+#include "CancellationToken.h"
+#include "IAsyncProducerConsumerCollection.h"
+#include "OperationCanceledException.h"
+#include "../Tasks/TaskCombinators.h"
+#include "../Tasks/TaskCompletionSource.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  template <typename TItem>
+  struct SelectResult
+  {
+    //Index of the collection which provided the item.
+    std::size_t Index;
+    TItem Item;
+  };
+}
+
+namespace RStein::AsyncCpp::Detail
+{
+  //One listener registered with all collections of the Select. Only one thread at a time takes items (_isTaking),
+  //so exactly one item is taken. Notifications received while taking are handled by the taking thread (_isRetryRequested).
+  template <typename TItem>
+  class SelectState : public RStein::AsyncCpp::AsyncPrimitives::IItemAddedListener<TItem>,
+                      public std::enable_shared_from_this<SelectState<TItem>>
+  {
+  public:
+    using CollectionPtr = RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TItem>*;
+    using SelectResultType = RStein::AsyncCpp::AsyncPrimitives::SelectResult<TItem>;
+
+    explicit SelectState(std::vector<CollectionPtr> collections) : _collections{std::move(collections)},
+                                                                   _stateMutex{},
+                                                                   _isTaking{false},
+                                                                   _isRetryRequested{false},
+                                                                   _isCancellationRequested{false},
+                                                                   _isCompleted{false},
+                                                                   _takenItems{},
+                                                                   _cancellationRegistration{},
+                                                                   _resultTcs{}
+    {
+    }
+
+    SelectState(const SelectState& other) = delete;
+    SelectState(SelectState&& other) noexcept = delete;
+    SelectState& operator=(const SelectState& other) = delete;
+    SelectState& operator=(SelectState&& other) noexcept = delete;
+    ~SelectState() override = default;
+
+    Tasks::Task<SelectResultType> Start(const RStein::AsyncCpp::AsyncPrimitives::CancellationToken& cancellationToken)
+    {
+      auto resultTask = _resultTcs.GetTask();
+      for (auto collection : _collections)
+      {
+        collection->AddItemAddedListener(this->shared_from_this());
+      }
+
+      //Items added before the registration.
+      trySelect();
+
+      if (cancellationToken.CanBeCanceled())
+      {
+        //Register runs the action inline when the token has already been canceled, do not hold the lock.
+        auto cancellationRegistration = cancellationToken.Register([weakThis = this->weak_from_this()]
+        {
+          if (auto sharedThis = weakThis.lock())
+          {
+            sharedThis->cancel();
+          }
+        });
+
+        auto isCompleted = false;
+        {
+          std::lock_guard lock{_stateMutex};
+          isCompleted = _isCompleted;
+          if (!isCompleted)
+          {
+            _cancellationRegistration = std::move(cancellationRegistration);
+          }
+        }
+
+        if (isCompleted)
+        {
+          cancellationRegistration.Dispose();
+        }
+      }
+
+      return resultTask;
+    }
+
+    void OnItemAdded(RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TItem>& collection) override
+    {
+      trySelect();
+    }
+
+  private:
+    const std::vector<CollectionPtr> _collections;
+    std::mutex _stateMutex;
+    bool _isTaking;
+    bool _isRetryRequested;
+    bool _isCancellationRequested;
+    bool _isCompleted;
+    //Used only by the taking thread.
+    std::vector<TItem> _takenItems;
+    std::optional<RStein::AsyncCpp::AsyncPrimitives::CancellationRegistration> _cancellationRegistration;
+    Tasks::TaskCompletionSource<SelectResultType> _resultTcs;
+
+    void trySelect()
+    {
+      {
+        std::lock_guard lock{_stateMutex};
+        if (_isCompleted)
+        {
+          return;
+        }
+
+        if (_isTaking)
+        {
+          _isRetryRequested = true;
+          return;
+        }
+
+        _isTaking = true;
+      }
+
+      while (true)
+      {
+        //Take from the collection notifies the listeners (served producers), do not hold the lock.
+        auto result = tryTakeFirstItem();
+        {
+          std::lock_guard lock{_stateMutex};
+          if (!result && !_isCancellationRequested && _isRetryRequested)
+          {
+            _isRetryRequested = false;
+            continue;
+          }
+
+          _isTaking = false;
+          if (!result && !_isCancellationRequested)
+          {
+            return;
+          }
+
+          _isCompleted = true;
+        }
+
+        complete(std::move(result));
+        return;
+      }
+    }
+
+    std::optional<SelectResultType> tryTakeFirstItem()
+    {
+      for (std::size_t i = 0; i < _collections.size(); i++)
+      {
+        _takenItems.clear();
+        if (_collections[i]->TryTakeMany(_takenItems, 1) == 1)
+        {
+          return SelectResultType{i, std::move(_takenItems.front())};
+        }
+      }
+
+      return std::nullopt;
+    }
+
+    void cancel()
+    {
+      {
+        std::lock_guard lock{_stateMutex};
+        if (_isCompleted)
+        {
+          return;
+        }
+
+        _isCancellationRequested = true;
+        if (_isTaking)
+        {
+          //The taking thread completes the select. The item taken in the meantime is not lost.
+          return;
+        }
+
+        _isCompleted = true;
+      }
+
+      complete(std::nullopt);
+    }
+
+    void complete(std::optional<SelectResultType> result)
+    {
+      std::optional<RStein::AsyncCpp::AsyncPrimitives::CancellationRegistration> cancellationRegistration{};
+      {
+        std::lock_guard lock{_stateMutex};
+        cancellationRegistration = std::move(_cancellationRegistration);
+        _cancellationRegistration.reset();
+      }
+
+      for (auto collection : _collections)
+      {
+        collection->RemoveItemAddedListener(this->shared_from_this());
+      }
+
+      if (cancellationRegistration)
+      {
+        cancellationRegistration->Dispose();
+      }
+
+      if (result)
+      {
+        _resultTcs.SetResult(std::move(*result));
+        return;
+      }
+
+      _resultTcs.SetException(std::make_exception_ptr(RStein::AsyncCpp::AsyncPrimitives::OperationCanceledException{}));
+    }
+  };
+}
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Waits for the first item available in any of the collections and takes exactly one item, no item is taken from the other collections.
+  //One listener is registered with every collection (no task per collection). When more collections have an item, the first collection wins.
+  //The collections must live until the returned task completes. Select is a consumer of a single-consumer (SpscChannel) collection.
+  template <typename TItem>
+  Tasks::Task<SelectResult<TItem>> Select(std::vector<IAsyncProducerConsumerCollection<TItem>*> collections, CancellationToken cancellationToken)
+  {
+    if (collections.empty())
+    {
+      throw std::invalid_argument("collections");
+    }
+
+    for (auto collection : collections)
+    {
+      if (collection == nullptr)
+      {
+        throw std::invalid_argument("collections");
+      }
+    }
+
+    //Available items are taken without the shared state.
+    std::vector<TItem> takenItems;
+    for (std::size_t i = 0; i < collections.size(); i++)
+    {
+      if (collections[i]->TryTakeMany(takenItems, 1) == 1)
+      {
+        return Tasks::TaskFromResult(SelectResult<TItem>{i, std::move(takenItems.front())});
+      }
+    }
+
+    auto selectState = std::make_shared<Detail::SelectState<TItem>>(std::move(collections));
+    return selectState->Start(cancellationToken);
+  }
+
+  template <typename TItem>
+  Tasks::Task<SelectResult<TItem>> Select(std::vector<IAsyncProducerConsumerCollection<TItem>*> collections)
+  {
+    return Select(std::move(collections), CancellationToken::None());
+  }
+}
@@ -1,11 +1,19 @@
 ﻿#pragma once
+#include "AddingCompletedException.h"
 #include "AsyncSemaphore.h"
 #include "FutureEx.h"
 #include "IAsyncProducerConsumerCollection.h"
 #include "../Collections/ThreadSafeMinimalisticQueue.h"
+#include "../Detail/AsyncPrimitives/ItemAddedListeners.h"
 #include "../Tasks/TaskCombinators.h"
+#include "../Utils/FinallyBlock.h"
 
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 
 namespace RStein::AsyncCpp::AsyncPrimitives
@@ -15,6 +23,8 @@ namespace RStein::AsyncCpp::AsyncPrimitives
   {
   public:
     SimpleAsyncProducerConsumerCollection();
+    //Bounded collection. AddAsync waits (FIFO) while the collection contains capacity items, Add blocks the calling thread.
+    explicit SimpleAsyncProducerConsumerCollection(int capacity);
     SimpleAsyncProducerConsumerCollection(const SimpleAsyncProducerConsumerCollection& other) = delete;
     SimpleAsyncProducerConsumerCollection(SimpleAsyncProducerConsumerCollection&& other) noexcept = delete;
     SimpleAsyncProducerConsumerCollection& operator=(const SimpleAsyncProducerConsumerCollection& other) = delete;
@@ -25,65 +35,198 @@ namespace RStein::AsyncCpp::AsyncPrimitives
     void Add(const TItem& item) override;
     Tasks::Task<void> AddAsync(const TItem& item) override;
     Tasks::Task<void> AddAsync(TItem&& item) override;
+    Tasks::Task<void> AddAsync(const TItem& item, CancellationToken cancellationToken);
+    Tasks::Task<void> AddAsync(TItem&& item, CancellationToken cancellationToken);
+    //Adds the item only if the collection is not full. Returns false when the collection is full or adding has been completed.
+    bool TryAdd(const TItem& item);
+    bool TryAdd(TItem&& item);
+    //Subsequent and waiting adds throw the AddingCompletedException.
+    //Takes throw the AddingCompletedException when all items added before the CompleteAdding call have been taken.
+    void CompleteAdding();
+    bool IsAddingCompleted() const;
     Tasks::Task<TItem> TakeAsync() override;
     Tasks::Task<TItem> TakeAsync(CancellationToken cancellationToken) override;
+    Tasks::Task<std::size_t> TakeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken) override;
     std::vector<TItem> TryTakeAll() override;
+    std::size_t TryTakeMany(std::vector<TItem>& items, std::size_t maxItems) override;
+    void AddItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) override;
+    void RemoveItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) override;
   private:
+    //The _addingState contains the ADDING_COMPLETED_FLAG and the number of running adds multiplied by the RUNNING_ADD_INCREMENT.
+    static constexpr std::size_t ADDING_COMPLETED_FLAG = 1;
+    static constexpr std::size_t RUNNING_ADD_INCREMENT = 2;
 
     Collections::ThreadSafeMinimalisticQueue<TItem> _innerCollection;
+    //Permits for the takers. After the CompleteAdding call, the last running add releases one additional permit for an item that will never be added.
+    //The taker that acquires this permit and does not find an item releases the permit again, so all waiting takers are resumed.
     AsyncSemaphore _asyncSemaphore;
+    //Free slots of the bounded collection (nullptr if the collection is unbounded). The CompleteAdding releases one additional slot
+    //passed from one waiting producer to another in the same way.
+    std::unique_ptr<AsyncSemaphore> _freeSlotsSemaphore;
+    std::atomic<std::size_t> _addingState;
+    Detail::ItemAddedListeners<TItem> _itemAddedListeners;
+
+    template <typename TUItem>
+    Tasks::Task<void> addAsync(TUItem&& item, CancellationToken cancellationToken);
+    Tasks::Task<void> waitForFreeSlotAndAddAsync(TItem item, CancellationToken cancellationToken);
+    template <typename TUItem>
+    void pushItem(TUItem&& item);
+    bool tryEnterAdd();
+    void exitAdd();
+    void releaseFreeSlots(std::size_t slotsCount);
+    std::size_t takeAcquiredItems(std::vector<TItem>& items, std::size_t acquiredCount);
+    Tasks::Task<std::size_t> takeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken);
   };
 }
 
-
 template <typename TItem>
 RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::
 SimpleAsyncProducerConsumerCollection() :
   IAsyncProducerConsumerCollection<TItem>(),
   _innerCollection(),
-  _asyncSemaphore(std::numeric_limits<int>::max(), 0)
+  _asyncSemaphore(std::numeric_limits<int>::max(), 0),
+  _freeSlotsSemaphore(),
+  _addingState(0),
+  _itemAddedListeners()
+{
+}
+
+template <typename TItem>
+RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::
+SimpleAsyncProducerConsumerCollection(int capacity) :
+  IAsyncProducerConsumerCollection<TItem>(),
+  _innerCollection(),
+  _asyncSemaphore(std::numeric_limits<int>::max(), 0),
+  _freeSlotsSemaphore(),
+  _addingState(0),
+  _itemAddedListeners()
 {
+  if (capacity <= 0 || capacity == std::numeric_limits<int>::max())
+  {
+    throw std::invalid_argument("capacity");
+  }
+
+  _freeSlotsSemaphore = std::make_unique<AsyncSemaphore>(capacity + 1, capacity);
 }
 
 template <typename TItem>
 void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::Add(const TItem& item)
 {
-  _innerCollection.Push(item);
-  _asyncSemaphore.Release();
+  if (!_freeSlotsSemaphore)
+  {
+    pushItem(item);
+    return;
+  }
+
+  addAsync(item, CancellationToken::None()).Wait();
 }
 
 template <typename TItem>
 void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::Add(TItem&& item)
 {
-  _innerCollection.Push(std::forward<TItem>(item));
-  _asyncSemaphore.Release();
+  if (!_freeSlotsSemaphore)
+  {
+    pushItem(std::move(item));
+    return;
+  }
+
+  addAsync(std::move(item), CancellationToken::None()).Wait();
 }
 
 template <typename TItem>
 RStein::AsyncCpp::Tasks::Task<void> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::AddAsync(const TItem& item)
 {
-   Add(item);
-  return Tasks::GetCompletedTask();
+  return addAsync(item, CancellationToken::None());
 }
 
 template <typename TItem>
 RStein::AsyncCpp::Tasks::Task<void> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::AddAsync(TItem&& item)
 {
-  Add(std::forward<TItem>(item));
-  return Tasks::GetCompletedTask();
+  return addAsync(std::move(item), CancellationToken::None());
 }
 
 template <typename TItem>
-RStein::AsyncCpp::Tasks::Task<TItem> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::TakeAsync()
+RStein::AsyncCpp::Tasks::Task<void> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::AddAsync(const TItem& item, CancellationToken cancellationToken)
 {
-  co_await _asyncSemaphore.WaitAsync();
-  auto retValue = _innerCollection.TryPop();
-  if (!retValue)
+  return addAsync(item, std::move(cancellationToken));
+}
+
+template <typename TItem>
+RStein::AsyncCpp::Tasks::Task<void> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::AddAsync(TItem&& item, CancellationToken cancellationToken)
+{
+  return addAsync(std::move(item), std::move(cancellationToken));
+}
+
+template <typename TItem>
+bool RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::TryAdd(const TItem& item)
+{
+  if (IsAddingCompleted() || (_freeSlotsSemaphore && _freeSlotsSemaphore->TryWaitMany(1) == 0))
+  {
+    return false;
+  }
+
+  try
+  {
+    pushItem(item);
+  }
+  catch (AddingCompletedException&)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+template <typename TItem>
+bool RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::TryAdd(TItem&& item)
+{
+  if (IsAddingCompleted() || (_freeSlotsSemaphore && _freeSlotsSemaphore->TryWaitMany(1) == 0))
+  {
+    return false;
+  }
+
+  try
   {
-    throw std::logic_error("Could not take item");
+    pushItem(std::move(item));
+  }
+  catch (AddingCompletedException&)
+  {
+    return false;
   }
 
-  co_return retValue.value();
+  return true;
+}
+
+template <typename TItem>
+void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::CompleteAdding()
+{
+  const auto previousState = _addingState.fetch_or(ADDING_COMPLETED_FLAG);
+  if ((previousState & ADDING_COMPLETED_FLAG) != 0)
+  {
+    return;
+  }
+
+  if (previousState == 0)
+  {
+    _asyncSemaphore.Release();
+  }
+
+  if (_freeSlotsSemaphore)
+  {
+    _freeSlotsSemaphore->Release();
+  }
+}
+
+template <typename TItem>
+bool RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::IsAddingCompleted() const
+{
+  return (_addingState.load() & ADDING_COMPLETED_FLAG) != 0;
+}
+
+template <typename TItem>
+RStein::AsyncCpp::Tasks::Task<TItem> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::TakeAsync()
+{
+  return TakeAsync(CancellationToken::None());
 }
 
 template <typename TItem>
@@ -93,14 +236,191 @@ RStein::AsyncCpp::Tasks::Task<TItem> RStein::AsyncCpp::AsyncPrimitives::SimpleAs
   auto retValue = _innerCollection.TryPop();
   if (!retValue)
   {
-    throw std::logic_error("Could not take item");
+    if (!IsAddingCompleted())
+    {
+      throw std::logic_error("Could not take item");
+    }
+
+    _asyncSemaphore.Release();
+    throw AddingCompletedException{};
   }
 
-  co_return retValue.value();
+  releaseFreeSlots(1);
+  co_return std::move(retValue.value());
+}
+
+template <typename TItem>
+RStein::AsyncCpp::Tasks::Task<std::size_t> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::TakeManyAsync(std::vector<TItem>& items,
+                                                                                                                                      std::size_t maxItems,
+                                                                                                                                      CancellationToken cancellationToken)
+{
+  if (maxItems == 0)
+  {
+    throw std::invalid_argument("maxItems");
+  }
+
+  //Available items are taken without the coroutine frame.
+  const auto takenCount = TryTakeMany(items, maxItems);
+  if (takenCount > 0)
+  {
+    return Tasks::TaskFromResult(takenCount);
+  }
+
+  return takeManyAsync(items, maxItems, cancellationToken);
+}
+
+template <typename TItem>
+RStein::AsyncCpp::Tasks::Task<std::size_t> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::takeManyAsync(std::vector<TItem>& items,
+                                                                                                                                      std::size_t maxItems,
+                                                                                                                                      CancellationToken cancellationToken)
+{
+  co_await _asyncSemaphore.WaitAsync(cancellationToken);
+  const auto maxCount = static_cast<int>(std::min<std::size_t>(maxItems - 1, std::numeric_limits<int>::max()));
+  const auto acquiredCount = 1 + static_cast<std::size_t>(_asyncSemaphore.TryWaitMany(maxCount));
+  const auto takenCount = takeAcquiredItems(items, acquiredCount);
+  if (takenCount == 0)
+  {
+    throw AddingCompletedException{};
+  }
+
+  co_return takenCount;
 }
 
 template <typename TItem>
 std::vector<TItem> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::TryTakeAll()
 {
-  return _innerCollection.PopAll();
+  std::vector<TItem> items;
+  TryTakeMany(items, std::numeric_limits<std::size_t>::max());
+  return items;
+}
+
+template <typename TItem>
+std::size_t RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::TryTakeMany(std::vector<TItem>& items, std::size_t maxItems)
+{
+  const auto maxCount = static_cast<int>(std::min<std::size_t>(maxItems, std::numeric_limits<int>::max()));
+  const auto acquiredCount = static_cast<std::size_t>(_asyncSemaphore.TryWaitMany(maxCount));
+  return takeAcquiredItems(items, acquiredCount);
+}
+
+template <typename TItem>
+void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::AddItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener)
+{
+  _itemAddedListeners.Add(listener);
+}
+
+template <typename TItem>
+void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::RemoveItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener)
+{
+  _itemAddedListeners.Remove(listener);
+}
+
+template <typename TItem>
+template <typename TUItem>
+RStein::AsyncCpp::Tasks::Task<void> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::addAsync(TUItem&& item, CancellationToken cancellationToken)
+{
+  if (!_freeSlotsSemaphore)
+  {
+    pushItem(std::forward<TUItem>(item));
+    return Tasks::GetCompletedTask();
+  }
+
+  if (IsAddingCompleted())
+  {
+    throw AddingCompletedException{};
+  }
+
+  //A free slot is available only when no producer waits for the slot, so the producers are still resumed in the FIFO order.
+  if (_freeSlotsSemaphore->TryWaitMany(1) == 1)
+  {
+    pushItem(std::forward<TUItem>(item));
+    return Tasks::GetCompletedTask();
+  }
+
+  return waitForFreeSlotAndAddAsync(TItem{std::forward<TUItem>(item)}, std::move(cancellationToken));
+}
+
+template <typename TItem>
+RStein::AsyncCpp::Tasks::Task<void> RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::waitForFreeSlotAndAddAsync(TItem item, CancellationToken cancellationToken)
+{
+  co_await _freeSlotsSemaphore->WaitAsync(cancellationToken);
+  pushItem(std::move(item));
+}
+
+template <typename TItem>
+template <typename TUItem>
+void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::pushItem(TUItem&& item)
+{
+  if (!tryEnterAdd())
+  {
+    //Pass the acquired slot to the next waiting producer.
+    releaseFreeSlots(1);
+    throw AddingCompletedException{};
+  }
+
+  Utils::FinallyBlock finally{[this]
+  {
+    exitAdd();
+  }};
+
+  //Every added item is pushed to the queue before the semaphore is released, so the queue contains all acquired items.
+  _innerCollection.Push(std::forward<TUItem>(item));
+  _asyncSemaphore.Release();
+  _itemAddedListeners.Notify(*this);
+}
+
+template <typename TItem>
+bool RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::tryEnterAdd()
+{
+  //The add is not counted when adding has been completed, otherwise the permit released by the CompleteAdding could be released twice.
+  auto state = _addingState.load();
+  do
+  {
+    if ((state & ADDING_COMPLETED_FLAG) != 0)
+    {
+      return false;
+    }
+  } while (!_addingState.compare_exchange_weak(state, state + RUNNING_ADD_INCREMENT));
+
+  return true;
+}
+
+template <typename TItem>
+void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::exitAdd()
+{
+  const auto previousState = _addingState.fetch_sub(RUNNING_ADD_INCREMENT);
+  if (previousState == (RUNNING_ADD_INCREMENT | ADDING_COMPLETED_FLAG))
+  {
+    //The last running add after the CompleteAdding call.
+    _asyncSemaphore.Release();
+  }
+}
+
+template <typename TItem>
+void RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::releaseFreeSlots(std::size_t slotsCount)
+{
+  if (!_freeSlotsSemaphore)
+  {
+    return;
+  }
+
+  for (std::size_t i = 0; i < slotsCount; i++)
+  {
+    _freeSlotsSemaphore->Release();
+  }
+}
+
+template <typename TItem>
+std::size_t RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TItem>::takeAcquiredItems(std::vector<TItem>& items, std::size_t acquiredCount)
+{
+  const auto takenCount = _innerCollection.PopMany(items, acquiredCount);
+  //Only the permit released after the CompleteAdding call is not backed by an item.
+  assert(acquiredCount - takenCount <= 1);
+  if (takenCount < acquiredCount)
+  {
+    assert(IsAddingCompleted());
+    _asyncSemaphore.Release();
+  }
+
+  releaseFreeSlots(takenCount);
+  return takenCount;
 }
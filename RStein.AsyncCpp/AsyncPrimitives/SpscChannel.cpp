@@ -0,0 +1 @@
+﻿#include "SpscChannel.h"
@@ -0,0 +1,501 @@
+﻿#pragma once
+#include "CancellationToken.h"
+#include "IAsyncProducerConsumerCollection.h"
+#include "../Detail/AsyncPrimitives/ItemAddedListeners.h"
+#include "OperationCanceledException.h"
+#include "../Tasks/TaskCombinators.h"
+#include "../Tasks/TaskCompletionSource.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::AsyncPrimitives
+{
+  //Bounded single-producer single-consumer collection (ring buffer).
+  //Only one thread may add items at the same time and only one thread may take items at the same time (at most one pending AddAsync/TakeAsync).
+  //The producer owns the tail index and the consumer owns the head index, each side reads the index of the other side only when its cached copy
+  //says that the ring is full/empty. TryTakeMany and TryTakeAll publish the new head index once for the whole batch.
+  //The consumer is parked only when the ring is empty and the producer only when the ring is full.
+  //The capacity is rounded up to the power of two.
+  template <typename TItem>
+  class SpscChannel : public IAsyncProducerConsumerCollection<TItem>
+  {
+  public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+    explicit SpscChannel(std::size_t capacity = DEFAULT_CAPACITY);
+    SpscChannel(const SpscChannel& other) = delete;
+    SpscChannel(SpscChannel&& other) noexcept = delete;
+    SpscChannel& operator=(const SpscChannel& other) = delete;
+    SpscChannel& operator=(SpscChannel&& other) noexcept = delete;
+    virtual ~SpscChannel();
+
+    //Blocks the calling thread while the channel is full. Prefer AddAsync.
+    void Add(const TItem& item) override;
+    void Add(TItem&& item) override;
+    Tasks::Task<void> AddAsync(const TItem& item) override;
+    Tasks::Task<void> AddAsync(TItem&& item) override;
+    Tasks::Task<TItem> TakeAsync() override;
+    Tasks::Task<TItem> TakeAsync(CancellationToken cancellationToken) override;
+    Tasks::Task<std::size_t> TakeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken) override;
+    std::vector<TItem> TryTakeAll() override;
+    std::size_t TryTakeMany(std::vector<TItem>& items, std::size_t maxItems) override;
+    void AddItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) override;
+    void RemoveItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener) override;
+    [[nodiscard]] std::size_t Capacity() const;
+
+  private:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    struct ProducerWaiter
+    {
+      explicit ProducerWaiter(TItem item) : Item{std::move(item)}
+      {
+      }
+
+      TItem Item;
+      Tasks::TaskCompletionSource<void> WaiterTcs{};
+    };
+
+    struct ConsumerWaiter
+    {
+      Tasks::TaskCompletionSource<TItem> WaiterTcs{};
+      std::optional<CancellationRegistration> Registration{};
+    };
+
+    using ProducerWaiterPtr = std::shared_ptr<ProducerWaiter>;
+    using ConsumerWaiterPtr = std::shared_ptr<ConsumerWaiter>;
+
+    const std::size_t _capacity;
+    const std::size_t _mask;
+    std::unique_ptr<std::optional<TItem>[]> _items;
+    //Written by the consumer.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head;
+    std::size_t _cachedTail;
+    //Written by the producer.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail;
+    std::size_t _cachedHead;
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> _isConsumerWaiting;
+    std::atomic<bool> _isProducerWaiting;
+    std::mutex _waitersMutex;
+    ConsumerWaiterPtr _consumerWaiter;
+    ProducerWaiterPtr _producerWaiter;
+    Detail::ItemAddedListeners<TItem> _itemAddedListeners;
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t capacity);
+    template <typename TUItem>
+    bool tryPush(TUItem&& item);
+    std::optional<TItem> tryPop();
+    std::size_t tryPopMany(std::vector<TItem>& items, std::size_t maxItems);
+    template <typename TUItem>
+    Tasks::Task<void> addAsync(TUItem&& item);
+    Tasks::Task<std::size_t> takeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken);
+    void onItemAdded();
+    void serveConsumerWaiter();
+    void onItemsTaken();
+    void cancelConsumerWaiter(const ConsumerWaiterPtr& waiter);
+  };
+
+  template <typename TItem>
+  SpscChannel<TItem>::SpscChannel(std::size_t capacity) : IAsyncProducerConsumerCollection<TItem>{},
+                                                          _capacity{roundUpToPowerOfTwo(capacity)},
+                                                          _mask{_capacity - 1},
+                                                          _items{std::make_unique<std::optional<TItem>[]>(_capacity)},
+                                                          _head{0},
+                                                          _cachedTail{0},
+                                                          _tail{0},
+                                                          _cachedHead{0},
+                                                          _isConsumerWaiting{false},
+                                                          _isProducerWaiting{false},
+                                                          _waitersMutex{},
+                                                          _consumerWaiter{},
+                                                          _producerWaiter{},
+                                                          _itemAddedListeners{}
+  {
+  }
+
+  template <typename TItem>
+  SpscChannel<TItem>::~SpscChannel()
+  {
+    //Do not lock in the destructor.
+    if (_consumerWaiter)
+    {
+      if (_consumerWaiter->Registration)
+      {
+        _consumerWaiter->Registration->Dispose();
+      }
+
+      _consumerWaiter->WaiterTcs.TrySetException(std::make_exception_ptr(OperationCanceledException{}));
+    }
+
+    if (_producerWaiter)
+    {
+      _producerWaiter->WaiterTcs.TrySetException(std::make_exception_ptr(OperationCanceledException{}));
+    }
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::Add(const TItem& item)
+  {
+    addAsync(item).Wait();
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::Add(TItem&& item)
+  {
+    addAsync(std::move(item)).Wait();
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> SpscChannel<TItem>::AddAsync(const TItem& item)
+  {
+    return addAsync(item);
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> SpscChannel<TItem>::AddAsync(TItem&& item)
+  {
+    return addAsync(std::move(item));
+  }
+
+  template <typename TItem>
+  Tasks::Task<TItem> SpscChannel<TItem>::TakeAsync()
+  {
+    return TakeAsync(CancellationToken::None());
+  }
+
+  template <typename TItem>
+  Tasks::Task<TItem> SpscChannel<TItem>::TakeAsync(CancellationToken cancellationToken)
+  {
+    if (auto item = tryPop())
+    {
+      onItemsTaken();
+      return Tasks::TaskFromResult(std::move(*item));
+    }
+
+    auto waiter = std::make_shared<ConsumerWaiter>();
+    auto isParked = true;
+    {
+      std::lock_guard lock{_waitersMutex};
+      //Publish the waiter before the last attempt, the producer checks the flag after the item is added.
+      _isConsumerWaiting.store(true, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (auto item = tryPop())
+      {
+        _isConsumerWaiting.store(false, std::memory_order_relaxed);
+        waiter->WaiterTcs.SetResult(std::move(*item));
+        isParked = false;
+      }
+      else
+      {
+        _consumerWaiter = waiter;
+      }
+    }
+
+    if (!isParked)
+    {
+      onItemsTaken();
+      return waiter->WaiterTcs.GetTask();
+    }
+
+    //The cancellation action runs inline when the token is already canceled, so register it outside of the lock.
+    if (cancellationToken.CanBeCanceled())
+    {
+      auto registration = cancellationToken.Register([this, waiter]{cancelConsumerWaiter(waiter);});
+      std::unique_lock lock{_waitersMutex};
+      if (_consumerWaiter == waiter)
+      {
+        waiter->Registration.emplace(std::move(registration));
+      }
+      else
+      {
+        lock.unlock();
+        registration.Dispose();
+      }
+    }
+
+    return waiter->WaiterTcs.GetTask();
+  }
+
+  template <typename TItem>
+  Tasks::Task<std::size_t> SpscChannel<TItem>::TakeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken)
+  {
+    if (maxItems == 0)
+    {
+      throw std::invalid_argument("maxItems");
+    }
+
+    //Available items are taken without the coroutine frame.
+    const auto takenCount = TryTakeMany(items, maxItems);
+    if (takenCount > 0)
+    {
+      return Tasks::TaskFromResult(takenCount);
+    }
+
+    return takeManyAsync(items, maxItems, std::move(cancellationToken));
+  }
+
+  template <typename TItem>
+  std::vector<TItem> SpscChannel<TItem>::TryTakeAll()
+  {
+    std::vector<TItem> items{};
+    if (tryPopMany(items, _capacity) > 0)
+    {
+      onItemsTaken();
+    }
+
+    return items;
+  }
+
+  template <typename TItem>
+  std::size_t SpscChannel<TItem>::TryTakeMany(std::vector<TItem>& items, std::size_t maxItems)
+  {
+    const auto takenCount = tryPopMany(items, maxItems);
+    if (takenCount > 0)
+    {
+      onItemsTaken();
+    }
+
+    return takenCount;
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::AddItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener)
+  {
+    _itemAddedListeners.Add(listener);
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::RemoveItemAddedListener(const std::shared_ptr<IItemAddedListener<TItem>>& listener)
+  {
+    _itemAddedListeners.Remove(listener);
+  }
+
+  template <typename TItem>
+  std::size_t SpscChannel<TItem>::Capacity() const
+  {
+    return _capacity;
+  }
+
+  template <typename TItem>
+  std::size_t SpscChannel<TItem>::roundUpToPowerOfTwo(std::size_t capacity)
+  {
+    if (capacity == 0)
+    {
+      throw std::invalid_argument("capacity");
+    }
+
+    std::size_t roundedCapacity = 1;
+    while (roundedCapacity < capacity)
+    {
+      roundedCapacity <<= 1;
+    }
+
+    return roundedCapacity;
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  bool SpscChannel<TItem>::tryPush(TUItem&& item)
+  {
+    const auto tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _cachedHead == _capacity)
+    {
+      _cachedHead = _head.load(std::memory_order_acquire);
+      if (tail - _cachedHead == _capacity)
+      {
+        return false;
+      }
+    }
+
+    _items[tail & _mask].emplace(std::forward<TUItem>(item));
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <typename TItem>
+  std::optional<TItem> SpscChannel<TItem>::tryPop()
+  {
+    const auto head = _head.load(std::memory_order_relaxed);
+    if (head == _cachedTail)
+    {
+      _cachedTail = _tail.load(std::memory_order_acquire);
+      if (head == _cachedTail)
+      {
+        return std::nullopt;
+      }
+    }
+
+    auto& slot = _items[head & _mask];
+    std::optional<TItem> item{std::move(slot)};
+    slot.reset();
+    _head.store(head + 1, std::memory_order_release);
+    return item;
+  }
+
+  template <typename TItem>
+  std::size_t SpscChannel<TItem>::tryPopMany(std::vector<TItem>& items, std::size_t maxItems)
+  {
+    const auto head = _head.load(std::memory_order_relaxed);
+    _cachedTail = _tail.load(std::memory_order_acquire);
+    const auto takenCount = std::min(_cachedTail - head, maxItems);
+    for (std::size_t i = 0; i < takenCount; ++i)
+    {
+      auto& slot = _items[(head + i) & _mask];
+      items.push_back(std::move(*slot));
+      slot.reset();
+    }
+
+    if (takenCount > 0)
+    {
+      _head.store(head + takenCount, std::memory_order_release);
+    }
+
+    return takenCount;
+  }
+
+  template <typename TItem>
+  template <typename TUItem>
+  Tasks::Task<void> SpscChannel<TItem>::addAsync(TUItem&& item)
+  {
+    if (tryPush(std::forward<TUItem>(item)))
+    {
+      onItemAdded();
+      return Tasks::GetCompletedTask();
+    }
+
+    //tryPush does not consume the item when the channel is full.
+    auto waiter = std::make_shared<ProducerWaiter>(TItem{std::forward<TUItem>(item)});
+    auto isParked = true;
+    {
+      std::lock_guard lock{_waitersMutex};
+      _isProducerWaiting.store(true, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (tryPush(std::move(waiter->Item)))
+      {
+        _isProducerWaiting.store(false, std::memory_order_relaxed);
+        waiter->WaiterTcs.SetResult();
+        isParked = false;
+      }
+      else
+      {
+        _producerWaiter = waiter;
+      }
+    }
+
+    if (!isParked)
+    {
+      onItemAdded();
+    }
+
+    return waiter->WaiterTcs.GetTask();
+  }
+
+  template <typename TItem>
+  Tasks::Task<std::size_t> SpscChannel<TItem>::takeManyAsync(std::vector<TItem>& items, std::size_t maxItems, CancellationToken cancellationToken)
+  {
+    //Only the first item is awaited, the items added in the meantime are taken in one operation.
+    items.push_back(co_await TakeAsync(std::move(cancellationToken)));
+    co_return 1 + TryTakeMany(items, maxItems - 1);
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::onItemAdded()
+  {
+    serveConsumerWaiter();
+    _itemAddedListeners.Notify(*this);
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::serveConsumerWaiter()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!_isConsumerWaiting.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+
+    //The consumer is parked, so the producer takes the item on behalf of the consumer.
+    ConsumerWaiterPtr waiter{};
+    std::optional<TItem> item{};
+    std::optional<CancellationRegistration> registration{};
+    {
+      std::lock_guard lock{_waitersMutex};
+      if (!_consumerWaiter)
+      {
+        return;
+      }
+
+      item = tryPop();
+      if (!item)
+      {
+        return;
+      }
+
+      waiter = std::move(_consumerWaiter);
+      _consumerWaiter.reset();
+      _isConsumerWaiting.store(false, std::memory_order_seq_cst);
+      registration = std::move(waiter->Registration);
+    }
+
+    //Continuation of the waiter may run inline, do not hold the lock.
+    waiter->WaiterTcs.TrySetResult(std::move(*item));
+    if (registration)
+    {
+      registration->Dispose();
+    }
+
+    onItemsTaken();
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::onItemsTaken()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!_isProducerWaiting.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+
+    //The producer is parked, so the consumer adds the item on behalf of the producer.
+    ProducerWaiterPtr waiter{};
+    {
+      std::lock_guard lock{_waitersMutex};
+      if (!_producerWaiter || !tryPush(std::move(_producerWaiter->Item)))
+      {
+        return;
+      }
+
+      waiter = std::move(_producerWaiter);
+      _producerWaiter.reset();
+      _isProducerWaiting.store(false, std::memory_order_seq_cst);
+    }
+
+    waiter->WaiterTcs.TrySetResult();
+    //The item of the producer has been added to the channel.
+    _itemAddedListeners.Notify(*this);
+  }
+
+  template <typename TItem>
+  void SpscChannel<TItem>::cancelConsumerWaiter(const ConsumerWaiterPtr& waiter)
+  {
+    {
+      std::lock_guard lock{_waitersMutex};
+      if (_consumerWaiter != waiter)
+      {
+        return;
+      }
+
+      _consumerWaiter.reset();
+      _isConsumerWaiting.store(false, std::memory_order_seq_cst);
+    }
+
+    waiter->WaiterTcs.TrySetException(std::make_exception_ptr(OperationCanceledException{}));
+  }
+}
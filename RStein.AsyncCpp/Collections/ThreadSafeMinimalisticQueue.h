@@ -29,6 +29,7 @@ namespace RStein::AsyncCpp::Collections
     std::optional<T> tryPopInner();
     std::optional<T> TryPop();
     std::vector<T> PopAll();
+    std::size_t PopMany(std::vector<T>& items, std::size_t maxItems);
 
   private:
     std::queue<T> _innerQueue;
@@ -91,7 +92,21 @@ namespace RStein::AsyncCpp::Collections
     return retVector;
   }
 
-  
+  //Appends at most maxItems items to the items vector. Returns the number of appended items.
+  template <typename T>
+  std::size_t ThreadSafeMinimalisticQueue<T>::PopMany(std::vector<T>& items, std::size_t maxItems)
+  {
+    std::lock_guard lock{_mutex};
+    const auto itemsCount = std::min(_innerQueue.size(), maxItems);
+    for (size_t i = 0; i < itemsCount; ++i)
+    {
+      items.push_back(std::move(_innerQueue.front()));
+      _innerQueue.pop();
+    }
+
+    return itemsCount;
+  }
+
   template <typename T>
   std::optional<T> ThreadSafeMinimalisticQueue<T>::tryPopInner()
   {
@@ -7,6 +7,7 @@ namespace RStein::AsyncCpp::DataFlow
 
   template<typename TInputItem, typename TState = Detail::NoState>
   class ActionBlock : public IInputBlock<TInputItem>,
+                      public Detail::IFusibleInputBlock<TInputItem>,
                       public std::enable_shared_from_this<ActionBlock<TInputItem, TState>>
           
   {
@@ -19,7 +20,8 @@ namespace RStein::AsyncCpp::DataFlow
   public:
 
      ActionBlock(typename InnerDataFlowBlock::AsyncActionFuncType actionFunc,
-                  typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [](const auto& _){ return true;}) :
+                  typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [](const auto& _){ return true;},
+                  DataFlowBlockOptions options = DataFlowBlockOptions{}) :
                                                                                   IInputBlock<TInputItem>{},
                                                                                   std::enable_shared_from_this<ActionBlock<TInputItem, TState>>{},
                                                                                   _innerBlock{std::make_shared<InnerDataFlowBlock>([actionFunc](const TInputItem& inputItem, TState*& state) ->Tasks::Task<Detail::NoOutput>
@@ -27,7 +29,8 @@ namespace RStein::AsyncCpp::DataFlow
                                                                                                 co_await actionFunc(inputItem, state);
                                                                                                 co_return Detail::NoOutput::Default();
                                                                                               },
-                                                                                              canAcceptFunc)}
+                                                                                              canAcceptFunc,
+                                                                                              std::move(options))}
                                                                              
       {
         
@@ -36,7 +39,8 @@ namespace RStein::AsyncCpp::DataFlow
      ActionBlock(//TODO: Avoid unused variable, ambiguous ctor
                
                   typename InnerDataFlowBlock::ActionFuncType actionFunc,
-                  typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [](const auto& _){ return true;}) :
+                  typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [](const auto& _){ return true;},
+                  DataFlowBlockOptions options = DataFlowBlockOptions{}) :
                                                                                   IInputBlock<TInputItem>{},
                                                                                   std::enable_shared_from_this<ActionBlock<TInputItem, TState>>{},
                                                                                   _innerBlock{std::make_shared<InnerDataFlowBlock>([actionFunc](const TInputItem& inputItem, TState*& state)
@@ -44,7 +48,8 @@ namespace RStein::AsyncCpp::DataFlow
                                                                                                 actionFunc(inputItem, state);
                                                                                                 return Detail::NoOutput::Default();
                                                                                               },
-                                                                                              canAcceptFunc)}
+                                                                                              canAcceptFunc,
+                                                                                              std::move(options))}
                                                                              
       {
         
@@ -61,10 +66,19 @@ namespace RStein::AsyncCpp::DataFlow
       [[nodiscard]] typename IDataFlowBlock::TaskVoidType Completion() const override;
       void Start() override;
       void Complete() override;
+      typename IDataFlowBlock::TaskVoidType CompleteAsync() override;
       void SetFaulted(std::exception_ptr exception) override;
       bool CanAcceptInput(const TInputItem& item) override;
       typename IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
       typename IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+      [[nodiscard]] std::size_t PendingInputCount() const override;
+      //Replaces the input queue of the block (for example with the AsyncPriorityProducerConsumerCollection). Must be called before the block starts.
+      void InputItems(std::unique_ptr<AsyncPrimitives::IAsyncProducerConsumerCollection<TInputItem>> inputItems);
+      void AddPredecessor() override;
+      bool TryFuseWithPredecessor() override;
+      void UnfuseFromPredecessor() override;
+      [[nodiscard]] bool IsFusedWithPredecessor() const override;
+      std::optional<IDataFlowBlock::TaskVoidType> AcceptFusedInput(const TInputItem& item) override;
       
 
      private:
@@ -104,6 +118,12 @@ namespace RStein::AsyncCpp::DataFlow
     return _innerBlock->Complete();
   }
 
+  template <typename TInputItem, typename TState>
+  typename IDataFlowBlock::TaskVoidType ActionBlock<TInputItem, TState>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
   template <typename TInputItem, typename TState>
   void ActionBlock<TInputItem, TState>::SetFaulted(std::exception_ptr exception)
   {
@@ -127,4 +147,46 @@ namespace RStein::AsyncCpp::DataFlow
   {
     return _innerBlock->AcceptInputAsync(item);
   }
+
+  template <typename TInputItem, typename TState>
+  std::size_t ActionBlock<TInputItem, TState>::PendingInputCount() const
+  {
+    return _innerBlock->PendingInputCount();
+  }
+
+  template <typename TInputItem, typename TState>
+  void ActionBlock<TInputItem, TState>::InputItems(std::unique_ptr<AsyncPrimitives::IAsyncProducerConsumerCollection<TInputItem>> inputItems)
+  {
+    _innerBlock->InputItems(std::move(inputItems));
+  }
+
+  template <typename TInputItem, typename TState>
+  void ActionBlock<TInputItem, TState>::AddPredecessor()
+  {
+    _innerBlock->AddPredecessor();
+  }
+
+  template <typename TInputItem, typename TState>
+  bool ActionBlock<TInputItem, TState>::TryFuseWithPredecessor()
+  {
+    return _innerBlock->TryFuseWithPredecessor();
+  }
+
+  template <typename TInputItem, typename TState>
+  void ActionBlock<TInputItem, TState>::UnfuseFromPredecessor()
+  {
+    _innerBlock->UnfuseFromPredecessor();
+  }
+
+  template <typename TInputItem, typename TState>
+  bool ActionBlock<TInputItem, TState>::IsFusedWithPredecessor() const
+  {
+    return _innerBlock->IsFusedWithPredecessor();
+  }
+
+  template <typename TInputItem, typename TState>
+  std::optional<IDataFlowBlock::TaskVoidType> ActionBlock<TInputItem, TState>::AcceptFusedInput(const TInputItem& item)
+  {
+    return _innerBlock->AcceptFusedInput(item);
+  }
 }
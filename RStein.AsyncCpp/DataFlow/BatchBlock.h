@@ -0,0 +1,280 @@
+﻿#pragma once
+#include "IInputOutputBlock.h"
+#include "../AsyncPrimitives/AsyncTimer.h"
+#include "../AsyncPrimitives/CancellationTokenSource.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Groups input items to batches. The batch is sent to the linked blocks when it contains batchSize items
+  //or when maxLatency elapsed since the first item of the batch was processed, whichever comes first.
+  //maxLatency equal to zero disables the time window. The partial batch is sent when the block is completed.
+  //The time window uses the shared AsyncTimer, the timeout signals the block outside of its input queue.
+  template<typename TInputItem>
+  class BatchBlock : public IInputOutputBlock<TInputItem, std::vector<TInputItem>>
+  {
+  private:
+    using Clock = AsyncPrimitives::AsyncTimer::Clock;
+    using BatchType = std::vector<TInputItem>;
+
+    struct BatchState
+    {
+      //Buffer keeps its capacity between batches, items of the sent batch are moved to the batch with the exact size.
+      BatchType Items{};
+      //Deadline of the current batch, the timeout of the already sent batch is ignored.
+      std::optional<Clock::time_point> Deadline{};
+      //Cancels the timer delay of the current batch when the batch is sent before its deadline.
+      AsyncPrimitives::CancellationTokenSource TimeoutCts{};
+    };
+
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TInputItem, BatchType, BatchState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+
+  public:
+    using CanAcceptFuncType = std::function<bool(const TInputItem& item)>;
+
+    explicit BatchBlock(std::size_t batchSize,
+                        std::chrono::milliseconds maxLatency = std::chrono::milliseconds::zero(),
+                        CanAcceptFuncType canAcceptFunc = [](auto _){return true;},
+                        DataFlowBlockOptions options = DataFlowBlockOptions{});
+    BatchBlock(const BatchBlock& other) = delete;
+    BatchBlock(BatchBlock&& other) = delete;
+    BatchBlock& operator=(const BatchBlock& other) = delete;
+    BatchBlock& operator=(BatchBlock&& other) = delete;
+
+    [[nodiscard]] std::string Name() const override;
+    void Name(std::string name);
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+    void Start() override;
+    void Complete() override;
+    IDataFlowBlock::TaskVoidType CompleteAsync() override;
+    void SetFaulted(std::exception_ptr exception) override;
+    bool CanAcceptInput(const TInputItem& item) override;
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+    [[nodiscard]] std::size_t PendingInputCount() const override;
+
+    void ConnectTo(const typename IInputBlock<BatchType>::InputBlockPtr& nextBlock) override;
+    void ConnectTo(const typename IInputBlock<BatchType>::InputBlockPtr& nextBlock,
+                   const DataFlowLinkOptions<BatchType>& linkOptions) override;
+    virtual ~BatchBlock() = default;
+
+  private:
+    std::size_t _batchSize;
+    std::chrono::milliseconds _maxLatency;
+    InnerDataFlowBlockPtr _innerBlock;
+
+    Tasks::Task<void> batchItem(const TInputItem& item, BatchState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink);
+    static Tasks::Task<void> sendExpiredBatch(BatchState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink);
+    static Tasks::Task<void> sendBatch(BatchState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink);
+    void scheduleBatchTimeout(Clock::time_point deadline, const AsyncPrimitives::CancellationToken& cancellationToken);
+  };
+
+  template <typename TInputItem>
+  BatchBlock<TInputItem>::BatchBlock(std::size_t batchSize,
+                                     std::chrono::milliseconds maxLatency,
+                                     CanAcceptFuncType canAcceptFunc,
+                                     DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, BatchType>{},
+                                                                     _batchSize{batchSize},
+                                                                     _maxLatency{maxLatency},
+                                                                     _innerBlock{}
+  {
+    if (_batchSize == 0)
+    {
+      throw std::invalid_argument("batchSize");
+    }
+
+    if (_maxLatency < std::chrono::milliseconds::zero())
+    {
+      throw std::invalid_argument("maxLatency");
+    }
+
+    if (!canAcceptFunc)
+    {
+      canAcceptFunc = [](auto _) {return true; };
+    }
+
+    _innerBlock = std::make_shared<InnerDataFlowBlock>(typename InnerDataFlowBlock::AsyncTransformManyFuncType{[this](const TInputItem& item, BatchState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+                                                       {
+                                                         return batchItem(item, state, outputSink);
+                                                       }},
+                                                       typename InnerDataFlowBlock::AsyncFlushFuncType{[](BatchState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+                                                       {
+                                                         return sendBatch(state, outputSink);
+                                                       }},
+                                                       std::move(canAcceptFunc),
+                                                       std::move(options));
+
+    if (_maxLatency != std::chrono::milliseconds::zero())
+    {
+      //The timeout can signal the inner block after the BatchBlock is destroyed, the signal function does not capture this.
+      _innerBlock->SignalFunc([](BatchState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+      {
+        return sendExpiredBatch(state, outputSink);
+      });
+    }
+  }
+
+  template <typename TInputItem>
+  std::string BatchBlock<TInputItem>::Name() const
+  {
+    return _innerBlock->Name();
+  }
+
+  template <typename TInputItem>
+  void BatchBlock<TInputItem>::Name(std::string name)
+  {
+    _innerBlock->Name(name);
+  }
+
+  template <typename TInputItem>
+  IDataFlowBlock::TaskVoidType BatchBlock<TInputItem>::Completion() const
+  {
+    return _innerBlock->Completion();
+  }
+
+  template <typename TInputItem>
+  void BatchBlock<TInputItem>::Start()
+  {
+    _innerBlock->Start();
+  }
+
+  template <typename TInputItem>
+  void BatchBlock<TInputItem>::Complete()
+  {
+    _innerBlock->Complete();
+  }
+
+  template <typename TInputItem>
+  IDataFlowBlock::TaskVoidType BatchBlock<TInputItem>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
+  template <typename TInputItem>
+  void BatchBlock<TInputItem>::SetFaulted(std::exception_ptr exception)
+  {
+    _innerBlock->SetFaulted(exception);
+  }
+
+  template <typename TInputItem>
+  bool BatchBlock<TInputItem>::CanAcceptInput(const TInputItem& item)
+  {
+    return _innerBlock->CanAcceptInput(item);
+  }
+
+  template <typename TInputItem>
+  IDataFlowBlock::TaskVoidType BatchBlock<TInputItem>::AcceptInputAsync(const TInputItem& item)
+  {
+    return _innerBlock->AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem>
+  IDataFlowBlock::TaskVoidType BatchBlock<TInputItem>::AcceptInputAsync(TInputItem&& item)
+  {
+    return _innerBlock->AcceptInputAsync(std::move(item));
+  }
+
+  template <typename TInputItem>
+  std::size_t BatchBlock<TInputItem>::PendingInputCount() const
+  {
+    return _innerBlock->PendingInputCount();
+  }
+
+  template <typename TInputItem>
+  void BatchBlock<TInputItem>::ConnectTo(const typename IInputBlock<BatchType>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->Then(nextBlock);
+  }
+
+  template <typename TInputItem>
+  void BatchBlock<TInputItem>::ConnectTo(const typename IInputBlock<BatchType>::InputBlockPtr& nextBlock,
+                                         const DataFlowLinkOptions<BatchType>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+  template <typename TInputItem>
+  Tasks::Task<void> BatchBlock<TInputItem>::batchItem(const TInputItem& item,
+                                                      BatchState*& state,
+                                                      const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+  {
+    auto& items = state->Items;
+    if (items.empty())
+    {
+      items.reserve(_batchSize);
+      if (_maxLatency != std::chrono::milliseconds::zero())
+      {
+        state->Deadline = Clock::now() + _maxLatency;
+        state->TimeoutCts = AsyncPrimitives::CancellationTokenSource{};
+        scheduleBatchTimeout(*state->Deadline, state->TimeoutCts.Token());
+      }
+    }
+
+    items.push_back(item);
+    if (items.size() < _batchSize)
+    {
+      co_return;
+    }
+
+    co_await sendBatch(state, outputSink);
+  }
+
+  template <typename TInputItem>
+  Tasks::Task<void> BatchBlock<TInputItem>::sendExpiredBatch(BatchState*& state,
+                                                             const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+  {
+    //Timeout of the sent batch or of the batch with the later deadline.
+    if (!state->Deadline || Clock::now() < *state->Deadline)
+    {
+      co_return;
+    }
+
+    co_await sendBatch(state, outputSink);
+  }
+
+  template <typename TInputItem>
+  Tasks::Task<void> BatchBlock<TInputItem>::sendBatch(BatchState*& state,
+                                                      const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+  {
+    auto& items = state->Items;
+    if (state->Deadline)
+    {
+      state->TimeoutCts.Cancel();
+      state->Deadline.reset();
+    }
+
+    if (items.empty())
+    {
+      co_return;
+    }
+
+    BatchType batch{std::make_move_iterator(items.begin()), std::make_move_iterator(items.end())};
+    items.clear();
+    co_await outputSink(std::move(batch));
+  }
+
+  template <typename TInputItem>
+  void BatchBlock<TInputItem>::scheduleBatchTimeout(Clock::time_point deadline, const AsyncPrimitives::CancellationToken& cancellationToken)
+  {
+    //The pending timeout does not keep the block alive. The canceled delay of the sent batch is removed from the timer.
+    AsyncPrimitives::AsyncTimer::DefaultTimer()->DelayUntilAsync(deadline, cancellationToken).ContinueWith([weakInnerBlock = std::weak_ptr<InnerDataFlowBlock>{_innerBlock}](const auto& delayTask)
+    {
+      if (delayTask.IsCanceled())
+      {
+        return;
+      }
+
+      if (auto innerBlock = weakInnerBlock.lock())
+      {
+        innerBlock->Signal();
+      }
+    });
+  }
+}
@@ -0,0 +1,6 @@
+﻿#include "BatchTransformBlock.h"
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+﻿#pragma once
+#include "IInputOutputBlock.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Transforms all input items waiting in the input queue of the block (at most maxBatchSize items) at once.
+  //The waiting input items are taken from the queue in one bulk operation.
+  //Transformation receives the contiguous input items and writes one output item for every input item to the outputItems span,
+  //so it can use vectorized (SIMD) kernels. Output items are sent to the linked blocks in the order of the input items.
+  //The outputItems span contains default constructed items, so TOutputItem must be default constructible.
+  template<typename TInputItem, typename TOutputItem>
+  class BatchTransformBlock : public IInputOutputBlock<TInputItem, TOutputItem>,
+                              public std::enable_shared_from_this<BatchTransformBlock<TInputItem, TOutputItem>>
+  {
+    static_assert(std::is_default_constructible_v<TOutputItem>, "Output item of the BatchTransformBlock must be default constructible.");
+
+  private:
+    struct BatchTransformState
+    {
+      //Buffer keeps its capacity between batches.
+      std::vector<TOutputItem> OutputItems{};
+    };
+
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TInputItem, TOutputItem, BatchTransformState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+
+  public:
+    using BatchTransformFuncType = std::function<void(std::span<const TInputItem> inputItems, std::span<TOutputItem> outputItems)>;
+    using CanAcceptFuncType = typename InnerDataFlowBlock::CanAcceptFuncType;
+
+    static constexpr std::size_t DEFAULT_MAX_BATCH_SIZE = 1024;
+
+    explicit BatchTransformBlock(BatchTransformFuncType transformFunc,
+                                 std::size_t maxBatchSize = DEFAULT_MAX_BATCH_SIZE,
+                                 CanAcceptFuncType canAcceptFunc = [](auto _){return true;},
+                                 DataFlowBlockOptions options = DataFlowBlockOptions{});
+    BatchTransformBlock(const BatchTransformBlock& other) = delete;
+    BatchTransformBlock(BatchTransformBlock&& other) = delete;
+    BatchTransformBlock& operator=(const BatchTransformBlock& other) = delete;
+    BatchTransformBlock& operator=(BatchTransformBlock&& other) = delete;
+
+    [[nodiscard]] std::string Name() const override;
+    void Name(std::string name);
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+    void Start() override;
+    void Complete() override;
+    IDataFlowBlock::TaskVoidType CompleteAsync() override;
+    void SetFaulted(std::exception_ptr exception) override;
+    bool CanAcceptInput(const TInputItem& item) override;
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+    [[nodiscard]] std::size_t PendingInputCount() const override;
+
+    void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock) override;
+    void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                   const DataFlowLinkOptions<TOutputItem>& linkOptions) override;
+    virtual ~BatchTransformBlock() = default;
+
+  private:
+    BatchTransformFuncType _transformFunc;
+    InnerDataFlowBlockPtr _innerBlock;
+
+    Tasks::Task<void> transformBatch(const std::vector<TInputItem>& inputItems, BatchTransformState*& state, const typename InnerDataFlowBlock::OutputBatchSinkFuncType& outputBatchSink);
+  };
+
+  template <typename TInputItem, typename TOutputItem>
+  BatchTransformBlock<TInputItem, TOutputItem>::BatchTransformBlock(BatchTransformFuncType transformFunc,
+                                                                    std::size_t maxBatchSize,
+                                                                    CanAcceptFuncType canAcceptFunc,
+                                                                    DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, TOutputItem>{},
+                                                                                                    std::enable_shared_from_this<BatchTransformBlock<TInputItem, TOutputItem>>{},
+                                                                                                    _transformFunc{std::move(transformFunc)},
+                                                                                                    _innerBlock{}
+  {
+    if (!_transformFunc)
+    {
+      throw std::invalid_argument("transformFunc");
+    }
+
+    _innerBlock = std::make_shared<InnerDataFlowBlock>(typename InnerDataFlowBlock::AsyncTransformBatchFuncType{[this](const std::vector<TInputItem>& inputItems, BatchTransformState*& state, const typename InnerDataFlowBlock::OutputBatchSinkFuncType& outputBatchSink)
+                                                       {
+                                                         return transformBatch(inputItems, state, outputBatchSink);
+                                                       }},
+                                                       maxBatchSize,
+                                                       std::move(canAcceptFunc),
+                                                       std::move(options));
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  std::string BatchTransformBlock<TInputItem, TOutputItem>::Name() const
+  {
+    return _innerBlock->Name();
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  void BatchTransformBlock<TInputItem, TOutputItem>::Name(std::string name)
+  {
+    _innerBlock->Name(name);
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  IDataFlowBlock::TaskVoidType BatchTransformBlock<TInputItem, TOutputItem>::Completion() const
+  {
+    return _innerBlock->Completion();
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  void BatchTransformBlock<TInputItem, TOutputItem>::Start()
+  {
+    _innerBlock->Start();
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  void BatchTransformBlock<TInputItem, TOutputItem>::Complete()
+  {
+    _innerBlock->Complete();
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  IDataFlowBlock::TaskVoidType BatchTransformBlock<TInputItem, TOutputItem>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  void BatchTransformBlock<TInputItem, TOutputItem>::SetFaulted(std::exception_ptr exception)
+  {
+    _innerBlock->SetFaulted(exception);
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  bool BatchTransformBlock<TInputItem, TOutputItem>::CanAcceptInput(const TInputItem& item)
+  {
+    return _innerBlock->CanAcceptInput(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  IDataFlowBlock::TaskVoidType BatchTransformBlock<TInputItem, TOutputItem>::AcceptInputAsync(const TInputItem& item)
+  {
+    return _innerBlock->AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  IDataFlowBlock::TaskVoidType BatchTransformBlock<TInputItem, TOutputItem>::AcceptInputAsync(TInputItem&& item)
+  {
+    return _innerBlock->AcceptInputAsync(std::move(item));
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  std::size_t BatchTransformBlock<TInputItem, TOutputItem>::PendingInputCount() const
+  {
+    return _innerBlock->PendingInputCount();
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  void BatchTransformBlock<TInputItem, TOutputItem>::ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->Then(nextBlock);
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  void BatchTransformBlock<TInputItem, TOutputItem>::ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                                                               const DataFlowLinkOptions<TOutputItem>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+  template <typename TInputItem, typename TOutputItem>
+  Tasks::Task<void> BatchTransformBlock<TInputItem, TOutputItem>::transformBatch(const std::vector<TInputItem>& inputItems,
+                                                                                 BatchTransformState*& state,
+                                                                                 const typename InnerDataFlowBlock::OutputBatchSinkFuncType& outputBatchSink)
+  {
+    auto& outputItems = state->OutputItems;
+    outputItems.resize(inputItems.size());
+    _transformFunc(std::span<const TInputItem>{inputItems.data(), inputItems.size()},
+                   std::span<TOutputItem>{outputItems.data(), outputItems.size()});
+
+    //Output items are handed off in bulk, the buffer is reused by the next batch after the delivery.
+    co_await outputBatchSink(outputItems);
+  }
+}
@@ -0,0 +1,77 @@
+﻿#pragma once
+#include "TransformBlock.h"
+#include <memory>
+#include <mutex>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Sends the latest input item to all linked blocks. Every linked block receives the same immutable copy of the item.
+  //The block skips stale input items when a newer item is waiting. Linked blocks created with the
+  //DataFlowBlockOptions::ProcessLatestInputOnly option skip stale items too.
+  //The block is never fused with the linked blocks.
+  template<typename TItem>
+  class BroadcastBlock : public TransformBlock<TItem, std::shared_ptr<const TItem>>
+  {
+  private:
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TItem, std::shared_ptr<const TItem>, Detail::NoState>;
+
+  public:
+    using SharedItemType = std::shared_ptr<const TItem>;
+
+    explicit BroadcastBlock(typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [] (auto _){return true;},
+                            DataFlowBlockOptions options = DataFlowBlockOptions{});
+    BroadcastBlock(const BroadcastBlock& other) = delete;
+    BroadcastBlock(BroadcastBlock&& other) = delete;
+    BroadcastBlock& operator=(const BroadcastBlock& other) = delete;
+    BroadcastBlock& operator=(BroadcastBlock&& other) = delete;
+    virtual ~BroadcastBlock() = default;
+
+    //Returns the latest processed item or nullptr when the block has not processed any item.
+    [[nodiscard]] SharedItemType LatestItem() const;
+
+  private:
+    mutable std::mutex _latestItemMutex;
+    SharedItemType _latestItem;
+
+    static DataFlowBlockOptions broadcastOptions(DataFlowBlockOptions options);
+    SharedItemType shareItem(const TItem& item);
+  };
+
+  template <typename TItem>
+  BroadcastBlock<TItem>::BroadcastBlock(typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc,
+                                        DataFlowBlockOptions options) : TransformBlock<TItem, SharedItemType>{typename InnerDataFlowBlock::TransformFuncType{[this](const TItem& item, Detail::NoState*& _)
+                                                                                                           {
+                                                                                                             return shareItem(item);
+                                                                                                           }},
+                                                                                                           std::move(canAcceptFunc),
+                                                                                                           broadcastOptions(std::move(options))},
+                                                                        _latestItemMutex{},
+                                                                        _latestItem{}
+  {
+
+  }
+
+  template <typename TItem>
+  typename BroadcastBlock<TItem>::SharedItemType BroadcastBlock<TItem>::LatestItem() const
+  {
+    std::lock_guard lock{_latestItemMutex};
+    return _latestItem;
+  }
+
+  template <typename TItem>
+  DataFlowBlockOptions BroadcastBlock<TItem>::broadcastOptions(DataFlowBlockOptions options)
+  {
+    options.ProcessLatestInputOnly = true;
+    options.DisableFusion = true;
+    return options;
+  }
+
+  template <typename TItem>
+  typename BroadcastBlock<TItem>::SharedItemType BroadcastBlock<TItem>::shareItem(const TItem& item)
+  {
+    auto sharedItem = std::make_shared<const TItem>(item);
+    std::lock_guard lock{_latestItemMutex};
+    _latestItem = sharedItem;
+    return sharedItem;
+  }
+}
@@ -0,0 +1,46 @@
+﻿#pragma once
+#include "TransformBlock.h"
+#include <memory>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Queue of the items between two blocks. Sends the input items unchanged to the linked blocks.
+  //The block is never fused with the linked blocks, so the queue decouples the producer and the consumer.
+  template<typename TItem>
+  class BufferBlock : public TransformBlock<TItem, TItem>
+  {
+  private:
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TItem, TItem, Detail::NoState>;
+
+  public:
+    explicit BufferBlock(typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [] (auto _){return true;},
+                         DataFlowBlockOptions options = DataFlowBlockOptions{});
+    BufferBlock(const BufferBlock& other) = delete;
+    BufferBlock(BufferBlock&& other) = delete;
+    BufferBlock& operator=(const BufferBlock& other) = delete;
+    BufferBlock& operator=(BufferBlock&& other) = delete;
+    virtual ~BufferBlock() = default;
+
+  private:
+    static DataFlowBlockOptions bufferOptions(DataFlowBlockOptions options);
+  };
+
+  template <typename TItem>
+  BufferBlock<TItem>::BufferBlock(typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc,
+                                  DataFlowBlockOptions options) : TransformBlock<TItem, TItem>{typename InnerDataFlowBlock::TransformFuncType{[](const TItem& item, Detail::NoState*& _)
+                                                                                              {
+                                                                                                return item;
+                                                                                              }},
+                                                                                              std::move(canAcceptFunc),
+                                                                                              bufferOptions(std::move(options))}
+  {
+
+  }
+
+  template <typename TItem>
+  DataFlowBlockOptions BufferBlock<TItem>::bufferOptions(DataFlowBlockOptions options)
+  {
+    options.DisableFusion = true;
+    return options;
+  }
+}
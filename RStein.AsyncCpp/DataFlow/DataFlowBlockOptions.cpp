@@ -0,0 +1,6 @@
+﻿#include "DataFlowBlockOptions.h"
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+#include "../Schedulers/Scheduler.h"
+#include <cstddef>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  struct DataFlowBlockOptions
+  {
+    //Maximum number of output items that are delivered to the linked blocks concurrently.
+    //The block transforms the next input item while the previous outputs are still being delivered.
+    //When the window is full, the block awaits the oldest delivery before it propagates another output.
+    //A window of size 1 preserves the order of output items.
+    std::size_t MaxPropagationWindow = 1;
+    //When true, the block processes the input item only if no newer input item is waiting, stale input items are skipped.
+    //Use for consumers of the latest value (configuration, market data) which should not process outdated values.
+    bool ProcessLatestInputOnly = false;
+    //Scheduler which runs the processing loop of the block. The block transforms every input item in the scheduler.
+    //Use different schedulers to isolate blocking (I/O) blocks from the latency-critical (CPU) blocks.
+    //Empty scheduler - the block continues in the thread which completed the last awaited operation.
+    Schedulers::Scheduler::SchedulerPtr TaskScheduler{};
+    //When true and exactly one block is linked to the block when the block starts, the input queue of the block is a single-producer single-consumer channel.
+    //The linked predecessor must deliver one item at a time (MaxPropagationWindow == 1) and no other code may call AcceptInputAsync of the block.
+    //AcceptInputAsync called while the previous add is still pending throws std::logic_error. Links to the block must be created before the block starts.
+    //The block is not fused with its linked blocks.
+    bool UseSpscInputForSinglePredecessor = false;
+    //Capacity of the single-producer single-consumer input channel. The delivery from the predecessor waits while the channel is full.
+    std::size_t SpscInputCapacity = 1024;
+    //When true, the block is never fused with its linked blocks. The block always uses its input queue and its own processing loop.
+    //Use for blocks which decouple the producer and the consumer (BufferBlock).
+    //Fused block is unfused when it receives the input item from another producer or when another predecessor is linked to the block.
+    bool DisableFusion = false;
+  };
+}
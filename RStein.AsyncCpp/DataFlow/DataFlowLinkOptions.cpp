@@ -0,0 +1,6 @@
+﻿#include "DataFlowLinkOptions.h"
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  
+}
@@ -0,0 +1,54 @@
+﻿#pragma once
+#include "../Schedulers/Scheduler.h"
+#include <cstddef>
+#include <functional>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  enum class DataFlowLinkMode
+  {
+    //Every output item is sent to the linked block.
+    Broadcast,
+    //Output items are distributed to the partitioned linked blocks in turn.
+    RoundRobin,
+    //Output item is sent to the partitioned linked block with the least pending input items.
+    LeastQueued,
+    //Output items with the same key are always sent to the same partitioned linked block.
+    //The item which the block does not accept (CanAcceptInput) is skipped, it is never sent to another block.
+    HashPartitioned
+  };
+
+  //All links of the block that do not use the DataFlowLinkMode::Broadcast mode form one group of partitioned links
+  //and every output item is sent to at most one block from this group (no block accepts the item). All partitioned links of the block must use the same mode.
+  template<typename TItem>
+  struct DataFlowLinkOptions
+  {
+    using KeySelectorFuncType = std::function<std::size_t(const TItem& item)>;
+
+    DataFlowLinkMode Mode = DataFlowLinkMode::Broadcast;
+    //Required for the DataFlowLinkMode::HashPartitioned mode. The key selector of the first partitioned link of the block is used.
+    KeySelectorFuncType KeySelector{};
+    //Scheduler which delivers the output items to the linked block. Empty scheduler - items are delivered in the scheduler of the source block.
+    Schedulers::Scheduler::SchedulerPtr TaskScheduler{};
+
+    static DataFlowLinkOptions Broadcast()
+    {
+      return DataFlowLinkOptions{DataFlowLinkMode::Broadcast, KeySelectorFuncType{}};
+    }
+
+    static DataFlowLinkOptions RoundRobin()
+    {
+      return DataFlowLinkOptions{DataFlowLinkMode::RoundRobin, KeySelectorFuncType{}};
+    }
+
+    static DataFlowLinkOptions LeastQueued()
+    {
+      return DataFlowLinkOptions{DataFlowLinkMode::LeastQueued, KeySelectorFuncType{}};
+    }
+
+    static DataFlowLinkOptions HashPartitioned(KeySelectorFuncType keySelector)
+    {
+      return DataFlowLinkOptions{DataFlowLinkMode::HashPartitioned, std::move(keySelector)};
+    }
+  };
+}
@@ -0,0 +1,120 @@
+﻿#pragma once
+#include "IInputBlock.h"
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Synchronous stages composed with the operator | are fused to one function object at compile time.
+  //Fused stages call each other directly (the calls can be inlined) and there is no queue between them.
+  //Use DataFlowSyncFactory::CreatePipelineBlock to run the fused pipeline in one dataflow block.
+  template<typename TFunc>
+  class PipelineTransformStage
+  {
+  public:
+    explicit PipelineTransformStage(TFunc func) : _func{std::move(func)}
+    {
+    }
+
+    template<typename TInput>
+    auto operator()(TInput&& input) const
+    {
+      return _func(std::forward<TInput>(input));
+    }
+
+  private:
+    TFunc _func;
+  };
+
+  template<typename TFunc>
+  class PipelineActionStage
+  {
+  public:
+    explicit PipelineActionStage(TFunc func) : _func{std::move(func)}
+    {
+    }
+
+    template<typename TInput>
+    void operator()(TInput&& input) const
+    {
+      _func(std::forward<TInput>(input));
+    }
+
+  private:
+    TFunc _func;
+  };
+
+  //Fused stages followed by the regular dataflow block.
+  template<typename TFunc, typename TTargetInput>
+  class PipelineTargetStage
+  {
+  public:
+    using TargetBlockPtr = typename IInputBlock<TTargetInput>::InputBlockPtr;
+
+    PipelineTargetStage(PipelineTransformStage<TFunc> transformStage, TargetBlockPtr targetBlock) : _transformStage{std::move(transformStage)},
+                                                                                                    _targetBlock{std::move(targetBlock)}
+    {
+    }
+
+    [[nodiscard]] const PipelineTransformStage<TFunc>& TransformStage() const
+    {
+      return _transformStage;
+    }
+
+    [[nodiscard]] const TargetBlockPtr& TargetBlock() const
+    {
+      return _targetBlock;
+    }
+
+  private:
+    PipelineTransformStage<TFunc> _transformStage;
+    TargetBlockPtr _targetBlock;
+  };
+
+  class DataFlowPipeline
+  {
+  public:
+    template<typename TFunc>
+    static PipelineTransformStage<std::decay_t<TFunc>> Transform(TFunc&& func)
+    {
+      return PipelineTransformStage<std::decay_t<TFunc>>{std::forward<TFunc>(func)};
+    }
+
+    template<typename TFunc>
+    static PipelineActionStage<std::decay_t<TFunc>> Action(TFunc&& func)
+    {
+      return PipelineActionStage<std::decay_t<TFunc>>{std::forward<TFunc>(func)};
+    }
+  };
+
+  template<typename TFirstFunc, typename TSecondFunc>
+  auto operator|(PipelineTransformStage<TFirstFunc> first, PipelineTransformStage<TSecondFunc> second)
+  {
+    return DataFlowPipeline::Transform([first = std::move(first), second = std::move(second)](auto&& input)
+    {
+      return second(first(std::forward<decltype(input)>(input)));
+    });
+  }
+
+  template<typename TFirstFunc, typename TSecondFunc>
+  auto operator|(PipelineTransformStage<TFirstFunc> first, PipelineActionStage<TSecondFunc> second)
+  {
+    return DataFlowPipeline::Action([first = std::move(first), second = std::move(second)](auto&& input)
+    {
+      second(first(std::forward<decltype(input)>(input)));
+    });
+  }
+
+  template<typename TFunc, typename TTargetBlock, typename = std::enable_if_t<std::is_base_of_v<IInputBlock<typename TTargetBlock::InputType>, TTargetBlock>>>
+  auto operator|(PipelineTransformStage<TFunc> transformStage, const std::shared_ptr<TTargetBlock>& targetBlock)
+  {
+    if (!targetBlock)
+    {
+      throw std::invalid_argument("targetBlock");
+    }
+
+    return PipelineTargetStage<TFunc, typename TTargetBlock::InputType>{std::move(transformStage), targetBlock};
+  }
+}
@@ -1,6 +1,13 @@
 ﻿#pragma once
 #include "ActionBlock.h"
+#include "BatchBlock.h"
+#include "BatchTransformBlock.h"
+#include "DataFlowPipeline.h"
+#include "KeyedTransformBlock.h"
+#include "SlidingWindowBlock.h"
+#include "ThrottleBlock.h"
 #include "TransformBlock.h"
+#include "TumblingWindowBlock.h"
 
 namespace RStein::AsyncCpp::DataFlow
 {
@@ -10,36 +17,137 @@ namespace RStein::AsyncCpp::DataFlow
 
     template<typename TInput, typename TState>
       static typename IInputBlock<TInput>::InputBlockPtr CreateActionBlock(typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::ActionFuncType actionFunc,
-                                                                           typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                           typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                           DataFlowBlockOptions options = DataFlowBlockOptions{})
       {
-        return std::make_shared<ActionBlock<TInput, TState>>(std::move(actionFunc), std::move(canAcceptFunc));
+        return std::make_shared<ActionBlock<TInput, TState>>(std::move(actionFunc), std::move(canAcceptFunc), std::move(options));
       }
       
       template<typename TInput>
       static typename IInputBlock<TInput>::InputBlockPtr CreateActionBlock(std::function<void(const TInput& input)> actionFunc,
-                                                                          typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                          typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                          DataFlowBlockOptions options = DataFlowBlockOptions{})
       {
         return CreateActionBlock<TInput, Detail::NoState>([actionFunc=std::move(actionFunc)] (const TInput& input, auto _){actionFunc(input);},
-                                                          std::move(canAcceptFunc));
+                                                          std::move(canAcceptFunc),
+                                                          std::move(options));
       }
 
     template<typename TInput, typename TOutput, typename TState>
         static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateTransformBlock(typename Detail::DataFlowBlockCommon<TInput, TOutput, TState>::TransformFuncType transformFunc,
-                                                                                                                                  typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                                                                                  typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                                                  DataFlowBlockOptions options = DataFlowBlockOptions{})
         {
-          return std:: make_shared<TransformBlock<TInput, TOutput, TState>>(std::move(transformFunc), std::move(canAcceptFunc));
+          return std:: make_shared<TransformBlock<TInput, TOutput, TState>>(std::move(transformFunc), std::move(canAcceptFunc), std::move(options));
         }
 
         template<typename TInput, typename TOutput>
         static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateTransformBlock(std::function<TOutput(const TInput& input)> transformFunc,
-                                                                                                                                  typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                                                                                  typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                                                  DataFlowBlockOptions options = DataFlowBlockOptions{})
         {
           return CreateTransformBlock<TInput, TOutput, Detail::NoState>([transformFunc=std::move(transformFunc)] (const TInput& input, auto _)
                                                                                                     {
                                                                                                       return transformFunc(input);
                                                                                                     },
-                                                                                                    std::move(canAcceptFunc));
+                                                                                                    std::move(canAcceptFunc),
+                                                                                                    std::move(options));
         }
 
+      template<typename TInput>
+      static typename IInputOutputBlock<TInput, std::vector<TInput>>::IInputOutputBlockPtr CreateBatchBlock(std::size_t batchSize,
+                                                                                                            std::chrono::milliseconds maxLatency = std::chrono::milliseconds::zero(),
+                                                                                                            typename BatchBlock<TInput>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                            DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<BatchBlock<TInput>>(batchSize, maxLatency, std::move(canAcceptFunc), std::move(options));
+      }
+
+      template<typename TInput, typename TOutput>
+      static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateBatchTransformBlock(typename BatchTransformBlock<TInput, TOutput>::BatchTransformFuncType transformFunc,
+                                                                                                        std::size_t maxBatchSize = BatchTransformBlock<TInput, TOutput>::DEFAULT_MAX_BATCH_SIZE,
+                                                                                                        typename BatchTransformBlock<TInput, TOutput>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                        DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<BatchTransformBlock<TInput, TOutput>>(std::move(transformFunc), maxBatchSize, std::move(canAcceptFunc), std::move(options));
+      }
+
+      template<typename TInput, typename TAccumulate>
+      static typename IInputOutputBlock<TInput, TAccumulate>::IInputOutputBlockPtr CreateTumblingWindowBlock(DataFlowWindowOptions<TInput> windowOptions,
+                                                                                                            typename TumblingWindowBlock<TInput, TAccumulate>::AddFuncType addFunc,
+                                                                                                            TAccumulate seed = TAccumulate{},
+                                                                                                            typename TumblingWindowBlock<TInput, TAccumulate>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                            DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<TumblingWindowBlock<TInput, TAccumulate>>(std::move(windowOptions), std::move(addFunc), std::move(seed), std::move(canAcceptFunc), std::move(options));
+      }
+
+      template<typename TInput, typename TAccumulate>
+      static typename IInputOutputBlock<TInput, TAccumulate>::IInputOutputBlockPtr CreateSlidingWindowBlock(DataFlowWindowOptions<TInput> windowOptions,
+                                                                                                           typename SlidingWindowBlock<TInput, TAccumulate>::AddFuncType addFunc,
+                                                                                                           typename SlidingWindowBlock<TInput, TAccumulate>::RemoveFuncType removeFunc,
+                                                                                                           TAccumulate seed = TAccumulate{},
+                                                                                                           typename SlidingWindowBlock<TInput, TAccumulate>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                           DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<SlidingWindowBlock<TInput, TAccumulate>>(std::move(windowOptions), std::move(addFunc), std::move(removeFunc), std::move(seed), std::move(canAcceptFunc), std::move(options));
+      }
+
+      template<typename TInput, typename TOutput, typename TKey, typename TKeyState>
+      static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateKeyedTransformBlock(std::size_t lanesCount,
+                                                                                                        typename KeyedTransformBlock<TInput, TOutput, TKey, TKeyState>::KeySelectorFuncType keySelector,
+                                                                                                        typename KeyedTransformBlock<TInput, TOutput, TKey, TKeyState>::TransformFuncType transformFunc,
+                                                                                                        typename KeyedTransformBlock<TInput, TOutput, TKey, TKeyState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                        DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<KeyedTransformBlock<TInput, TOutput, TKey, TKeyState>>(lanesCount, std::move(keySelector), std::move(transformFunc), std::move(canAcceptFunc), std::move(options));
+      }
+
+      template<typename TInput>
+      static typename IInputOutputBlock<TInput, TInput>::IInputOutputBlockPtr CreateThrottleBlock(std::size_t itemsPerPeriod,
+                                                                                                 std::chrono::milliseconds period,
+                                                                                                 std::size_t burstSize = 1,
+                                                                                                 std::size_t boundedCapacity = ThrottleBlock<TInput>::DEFAULT_BOUNDED_CAPACITY,
+                                                                                                 typename ThrottleBlock<TInput>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                 DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<ThrottleBlock<TInput>>(itemsPerPeriod, period, burstSize, boundedCapacity, std::move(canAcceptFunc), std::move(options));
+      }
+
+      //Runs the fused pipeline in one block. The block propagates the output of the pipeline to the linked blocks.
+      template<typename TInput, typename TFunc>
+      static typename IInputOutputBlock<TInput, std::invoke_result_t<const PipelineTransformStage<TFunc>&, const TInput&>>::IInputOutputBlockPtr CreatePipelineBlock(PipelineTransformStage<TFunc> pipeline,
+                                                                                                                                                                DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        using TOutput = std::invoke_result_t<const PipelineTransformStage<TFunc>&, const TInput&>;
+        return CreateTransformBlock<TInput, TOutput, Detail::NoState>([pipeline=std::move(pipeline)] (const TInput& input, auto _)
+                                                                      {
+                                                                        return pipeline(input);
+                                                                      },
+                                                                      [](auto& _){return true;},
+                                                                      std::move(options));
+      }
+
+      template<typename TInput, typename TFunc>
+      static typename IInputBlock<TInput>::InputBlockPtr CreatePipelineBlock(PipelineActionStage<TFunc> pipeline,
+                                                                           DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return CreateActionBlock<TInput, Detail::NoState>([pipeline=std::move(pipeline)] (const TInput& input, auto _)
+                                                          {
+                                                            pipeline(input);
+                                                          },
+                                                          [](auto& _){return true;},
+                                                          std::move(options));
+      }
+
+      //Runs the fused pipeline in one block linked to the target block of the pipeline.
+      template<typename TInput, typename TFunc, typename TTargetInput>
+      static typename IInputBlock<TInput>::InputBlockPtr CreatePipelineBlock(PipelineTargetStage<TFunc, TTargetInput> pipeline,
+                                                                           DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        auto pipelineBlock = CreatePipelineBlock<TInput>(pipeline.TransformStage(), std::move(options));
+        pipelineBlock->ConnectTo(pipeline.TargetBlock());
+        return pipelineBlock;
+      }
   };
 }
@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  enum class DataFlowWindowMode
+  {
+    //Window contains the specified number of items.
+    Count,
+    //Window contains the items with timestamps from the specified time span.
+    Time
+  };
+
+  template<typename TItem>
+  struct DataFlowWindowOptions
+  {
+    //Timestamp of the item (for example milliseconds since the epoch). Timestamps of the input items must not decrease.
+    using TimestampSelectorFuncType = std::function<std::chrono::milliseconds(const TItem& item)>;
+
+    DataFlowWindowMode Mode = DataFlowWindowMode::Count;
+    //Required for the DataFlowWindowMode::Count mode.
+    std::size_t Count = 0;
+    //Required for the DataFlowWindowMode::Time mode.
+    std::chrono::milliseconds Duration = std::chrono::milliseconds::zero();
+    //Required for the DataFlowWindowMode::Time mode.
+    TimestampSelectorFuncType TimestampSelector{};
+
+    static DataFlowWindowOptions ByCount(std::size_t count)
+    {
+      return DataFlowWindowOptions{DataFlowWindowMode::Count, count, std::chrono::milliseconds::zero(), TimestampSelectorFuncType{}};
+    }
+
+    static DataFlowWindowOptions ByTime(std::chrono::milliseconds duration, TimestampSelectorFuncType timestampSelector)
+    {
+      return DataFlowWindowOptions{DataFlowWindowMode::Time, 0, duration, std::move(timestampSelector)};
+    }
+
+    void Validate() const
+    {
+      if (Mode == DataFlowWindowMode::Count && Count == 0)
+      {
+        throw std::invalid_argument("windowOptions.Count");
+      }
+
+      if (Mode == DataFlowWindowMode::Time)
+      {
+        if (Duration <= std::chrono::milliseconds::zero())
+        {
+          throw std::invalid_argument("windowOptions.Duration");
+        }
+
+        if (!TimestampSelector)
+        {
+          throw std::invalid_argument("windowOptions.TimestampSelector");
+        }
+      }
+    }
+  };
+}
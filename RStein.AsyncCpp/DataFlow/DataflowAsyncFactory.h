@@ -1,8 +1,10 @@
 ﻿#pragma once
 #include "ActionBlock.h"
+#include "BatchBlock.h"
 #include "IInputBlock.h"
 #include "IInputOutputBlock.h"
 #include "TransformBlock.h"
+#include "TransformManyBlock.h"
 #include <future>
 namespace RStein::AsyncCpp::DataFlow
 {
@@ -11,36 +13,72 @@ class DataFlowAsyncFactory
   public:
     template<typename TInput, typename TState>
       static typename IInputBlock<TInput>::InputBlockPtr CreateActionBlock(typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::AsyncActionFuncType actionFunc,
-                                                                           typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                           typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                           DataFlowBlockOptions options = DataFlowBlockOptions{})
       {
-        return std:: make_shared<ActionBlock<TInput, TState>>(std::move(actionFunc), std::move(canAcceptFunc));
+        return std:: make_shared<ActionBlock<TInput, TState>>(std::move(actionFunc), std::move(canAcceptFunc), std::move(options));
       }
 
       template<typename TInput>
       static typename IInputBlock<TInput>::InputBlockPtr CreateActionBlock(std::function<Tasks::Task<void>(const TInput& input)> actionFunc,
-                                                                          typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                          typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                          DataFlowBlockOptions options = DataFlowBlockOptions{})
       {
         return CreateActionBlock<TInput, Detail::NoState>([actionFunc=std::move(actionFunc)] (const TInput& input, auto _)->Tasks::Task<void> {co_await actionFunc(input);},
-                                                          std::move(canAcceptFunc));
+                                                          std::move(canAcceptFunc),
+                                                          std::move(options));
       }
 
       template<typename TInput, typename TOutput, typename TState>
       static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateTransformBlock(typename Detail::DataFlowBlockCommon<TInput, TOutput, TState>::AsyncTransformFuncType transformFunc,
-                                                                                                    typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                                                    typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                    DataFlowBlockOptions options = DataFlowBlockOptions{})
       {
-        return std:: make_shared<TransformBlock<TInput, TOutput, TState>>(std::move(transformFunc), std::move(canAcceptFunc));
+        return std:: make_shared<TransformBlock<TInput, TOutput, TState>>(std::move(transformFunc), std::move(canAcceptFunc), std::move(options));
       }
 
       template<typename TInput, typename TOutput>
       static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateTransformBlock(std::function<Tasks::Task<TOutput>(const TInput& input)> transformFunc,
-                                                                                                    typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;})
+                                                                                                    typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                    DataFlowBlockOptions options = DataFlowBlockOptions{})
       {
         return CreateTransformBlock<TInput, TOutput, Detail::NoState>([transformFunc=std::move(transformFunc)] (const TInput& input, auto _)-> Tasks::Task<TOutput>
         {
           auto result  = co_await transformFunc(input);
           co_return result;
         },
-       std::move(canAcceptFunc));
+       std::move(canAcceptFunc),
+       std::move(options));
+      }
+
+      template<typename TInput, typename TOutput, typename TState>
+      static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateTransformManyBlock(typename Detail::DataFlowBlockCommon<TInput, TOutput, TState>::AsyncTransformManyFuncType transformFunc,
+                                                                                                        typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, TState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                        DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<TransformManyBlock<TInput, TOutput, TState>>(std::move(transformFunc), std::move(canAcceptFunc), std::move(options));
+      }
+
+      template<typename TInput, typename TOutput>
+      static typename IInputOutputBlock<TInput, TOutput>::IInputOutputBlockPtr CreateTransformManyBlock(std::function<Tasks::Task<void>(const TInput& input, const typename TransformManyBlock<TInput, TOutput>::OutputSinkFuncType& outputSink)> transformFunc,
+                                                                                                        typename Detail::DataFlowBlockCommon<TInput, Detail::NoOutput, Detail::NoState>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                        DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return CreateTransformManyBlock<TInput, TOutput, Detail::NoState>([transformFunc=std::move(transformFunc)] (const TInput& input, auto _, const auto& outputSink)-> Tasks::Task<void>
+        {
+          co_await transformFunc(input, outputSink);
+        },
+        std::move(canAcceptFunc),
+        std::move(options));
+      }
+
+      template<typename TInput>
+      static typename IInputOutputBlock<TInput, std::vector<TInput>>::IInputOutputBlockPtr CreateBatchBlock(std::size_t batchSize,
+                                                                                                            std::chrono::milliseconds maxLatency = std::chrono::milliseconds::zero(),
+                                                                                                            typename BatchBlock<TInput>::CanAcceptFuncType canAcceptFunc = [](auto& _){return true;},
+                                                                                                            DataFlowBlockOptions options = DataFlowBlockOptions{})
+      {
+        return std::make_shared<BatchBlock<TInput>>(batchSize, maxLatency, std::move(canAcceptFunc), std::move(options));
       }
   };
 }
@@ -20,6 +20,9 @@ namespace RStein::AsyncCpp::DataFlow
       [[nodiscard]] virtual TaskVoidType Completion() const = 0;
       virtual void Start() = 0;
       virtual void Complete() = 0;
+      //Closes the input of the block without blocking the caller. The block processes already accepted items, completes
+      //and then completes the linked blocks. Returns the Completion() task of the block.
+      virtual TaskVoidType CompleteAsync() = 0;
       virtual void SetFaulted(std::exception_ptr exception) = 0;
       virtual ~IDataFlowBlock() = default;
   };
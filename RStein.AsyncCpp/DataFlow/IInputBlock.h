@@ -1,6 +1,7 @@
 #pragma once
 #include "IDataFlowBlock.h"
 
+#include <cstddef>
 #include <future>
 #include <memory>
 
@@ -22,6 +23,8 @@ namespace RStein::AsyncCpp::DataFlow
         virtual bool CanAcceptInput(const InputType& item) = 0;
         virtual TaskVoidType AcceptInputAsync(const InputType& item) = 0;
         virtual TaskVoidType AcceptInputAsync(InputType&& item) = 0;
+        //Number of accepted input items which have not been processed yet.
+        [[nodiscard]] virtual std::size_t PendingInputCount() const = 0;
         
     };
 }
@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include "DataFlowLinkOptions.h"
 #include "IInputBlock.h"
 
 namespace RStein::AsyncCpp::DataFlow
@@ -18,6 +19,8 @@ namespace RStein::AsyncCpp::DataFlow
         virtual ~IInputOutputBlock() = default;
         
         virtual void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock) = 0;
+        virtual void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                               const DataFlowLinkOptions<TOutputItem>& linkOptions) = 0;
              
         template<typename TNextBlock>
         const std::shared_ptr<TNextBlock>& Then(const std::shared_ptr<TNextBlock>& nextBlock)
@@ -25,5 +28,13 @@ namespace RStein::AsyncCpp::DataFlow
           ConnectTo(nextBlock);
           return nextBlock;
         }
+
+        template<typename TNextBlock>
+        const std::shared_ptr<TNextBlock>& Then(const std::shared_ptr<TNextBlock>& nextBlock,
+                                                const DataFlowLinkOptions<TOutputItem>& linkOptions)
+        {
+          ConnectTo(nextBlock, linkOptions);
+          return nextBlock;
+        }
   };
 }
\ No newline at end of file
@@ -0,0 +1,482 @@
+﻿#pragma once
+#include "DataFlowBlockOptions.h"
+#include "DataFlowLinkOptions.h"
+#include "IInputBlock.h"
+#include "../AsyncPrimitives/AsyncSemaphore.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include "../Tasks/TaskCompletionSource.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  enum class JoinMode
+  {
+    //Port accepts every input item. When the buffer of the port is full, the returned task completes after the port has room for the item.
+    Greedy,
+    //Port postpones the input item until the item is joined to the tuple - the returned task completes after the other ports have their items.
+    //The linked predecessor waits for the join, so the predecessor does not produce items which the join cannot use yet.
+    //When the join block completes, the tasks of the items which could not be joined complete too (with the failure of the faulted block).
+    NonGreedy
+  };
+
+  //Joins input items from the ports to tuples. The tuple contains the oldest buffered item from every port.
+  //Use Port<Index>() as the linked block for the predecessor that produces the Index-th item of the tuple.
+  template<typename... TInputItems>
+  class JoinBlock : public IDataFlowBlock,
+                    public std::enable_shared_from_this<JoinBlock<TInputItems...>>
+  {
+  public:
+    using JoinBlockPtr = std::shared_ptr<JoinBlock<TInputItems...>>;
+    using OutputType = std::tuple<TInputItems...>;
+    template<std::size_t PortIndex>
+    using PortInputType = std::tuple_element_t<PortIndex, OutputType>;
+
+  private:
+    static constexpr std::size_t PORTS_COUNT = sizeof...(TInputItems);
+
+    struct JoinInput
+    {
+      //Inner block passes the input item by the const reference and does not use it after joinItem, so the join moves the item to the port buffer.
+      mutable std::variant<TInputItems...> Item;
+      //NonGreedy mode - identifies the producer waiting for the join of the item.
+      std::uint64_t JoinId;
+    };
+
+    struct JoinState
+    {
+      std::tuple<std::deque<TInputItems>...> Items;
+      //NonGreedy mode - join ids of the buffered items, in the order of the items.
+      std::array<std::deque<std::uint64_t>, sizeof...(TInputItems)> JoinIds;
+    };
+
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<JoinInput, OutputType, JoinState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+    using OutputSinkFuncType = typename InnerDataFlowBlock::OutputSinkFuncType;
+
+    struct PortState
+    {
+      explicit PortState(std::size_t maxBufferedItems) : FreeSlots{static_cast<int>(maxBufferedItems), static_cast<int>(maxBufferedItems)},
+                                                         BufferedItemsCount{}
+      {
+      }
+
+      AsyncPrimitives::AsyncSemaphore FreeSlots;
+      std::atomic<std::size_t> BufferedItemsCount;
+    };
+
+    template<std::size_t PortIndex>
+    class JoinPort : public IInputBlock<PortInputType<PortIndex>>
+    {
+    public:
+      explicit JoinPort(JoinBlockPtr joinBlock) : IInputBlock<PortInputType<PortIndex>>{},
+                                                  _joinBlock{std::move(joinBlock)}
+      {
+      }
+
+      [[nodiscard]] std::string Name() const override
+      {
+        return _joinBlock->Name() + ".Port" + std::to_string(PortIndex);
+      }
+
+      [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override
+      {
+        return _joinBlock->Completion();
+      }
+
+      void Start() override
+      {
+        _joinBlock->Start();
+      }
+
+      void Complete() override
+      {
+        _joinBlock->Complete();
+      }
+
+      IDataFlowBlock::TaskVoidType CompleteAsync() override
+      {
+        return _joinBlock->CompleteAsync();
+      }
+
+      void SetFaulted(std::exception_ptr exception) override
+      {
+        _joinBlock->SetFaulted(exception);
+      }
+
+      bool CanAcceptInput(const PortInputType<PortIndex>& item) override
+      {
+        return _joinBlock->template canAcceptPortInput<PortIndex>();
+      }
+
+      IDataFlowBlock::TaskVoidType AcceptInputAsync(const PortInputType<PortIndex>& item) override
+      {
+        return _joinBlock->template acceptPortInputAsync<PortIndex>(item);
+      }
+
+      IDataFlowBlock::TaskVoidType AcceptInputAsync(PortInputType<PortIndex>&& item) override
+      {
+        return _joinBlock->template acceptPortInputAsync<PortIndex>(std::move(item));
+      }
+
+      [[nodiscard]] std::size_t PendingInputCount() const override
+      {
+        return _joinBlock->_ports[PortIndex]->BufferedItemsCount.load();
+      }
+
+    private:
+      JoinBlockPtr _joinBlock;
+    };
+
+  public:
+    explicit JoinBlock(std::size_t maxBufferedItemsPerPort,
+                       JoinMode mode = JoinMode::Greedy,
+                       DataFlowBlockOptions options = DataFlowBlockOptions{});
+    JoinBlock(const JoinBlock& other) = delete;
+    JoinBlock(JoinBlock&& other) = delete;
+    JoinBlock& operator=(const JoinBlock& other) = delete;
+    JoinBlock& operator=(JoinBlock&& other) = delete;
+    virtual ~JoinBlock() = default;
+
+    [[nodiscard]] std::string Name() const override;
+    void Name(std::string name);
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+    void Start() override;
+    void Complete() override;
+    IDataFlowBlock::TaskVoidType CompleteAsync() override;
+    void SetFaulted(std::exception_ptr exception) override;
+
+    template<std::size_t PortIndex>
+    typename IInputBlock<PortInputType<PortIndex>>::InputBlockPtr Port();
+
+    void ConnectTo(const typename IInputBlock<OutputType>::InputBlockPtr& nextBlock);
+    void ConnectTo(const typename IInputBlock<OutputType>::InputBlockPtr& nextBlock,
+                   const DataFlowLinkOptions<OutputType>& linkOptions);
+
+    template<typename TNextBlock>
+    const std::shared_ptr<TNextBlock>& Then(const std::shared_ptr<TNextBlock>& nextBlock)
+    {
+      ConnectTo(nextBlock);
+      return nextBlock;
+    }
+
+    template<typename TNextBlock>
+    const std::shared_ptr<TNextBlock>& Then(const std::shared_ptr<TNextBlock>& nextBlock,
+                                            const DataFlowLinkOptions<OutputType>& linkOptions)
+    {
+      ConnectTo(nextBlock, linkOptions);
+      return nextBlock;
+    }
+
+  private:
+    JoinMode _mode;
+    std::vector<std::unique_ptr<PortState>> _ports;
+    InnerDataFlowBlockPtr _innerBlock;
+    //NonGreedy mode - producers waiting for the join of their items.
+    std::mutex _waitingProducersMutex;
+    std::unordered_map<std::uint64_t, Tasks::TaskCompletionSource<void>> _waitingProducers;
+    std::uint64_t _nextJoinId;
+    bool _isJoinCompleted;
+    std::atomic<bool> _isCompletionObserved;
+
+    template<std::size_t PortIndex>
+    bool canAcceptPortInput();
+    template<std::size_t PortIndex>
+    Tasks::Task<void> acceptPortInputAsync(PortInputType<PortIndex> item);
+    Tasks::Task<void> joinItem(const JoinInput& input, JoinState*& state, const OutputSinkFuncType& outputSink);
+    template<std::size_t... PortIndices>
+    void bufferItem(std::variant<TInputItems...>&& item, JoinState& state, std::index_sequence<PortIndices...>);
+    template<std::size_t... PortIndices>
+    bool hasAllItems(const JoinState& state, std::index_sequence<PortIndices...>) const;
+    template<std::size_t... PortIndices>
+    OutputType takeJoinedItems(JoinState& state, std::index_sequence<PortIndices...>);
+    std::optional<Tasks::Task<void>> addWaitingProducer(std::uint64_t& joinId);
+    void releaseJoinedProducers(JoinState& state);
+    void releaseWaitingProducers(const IDataFlowBlock::TaskVoidType& completion);
+  };
+
+  template <typename ... TInputItems>
+  JoinBlock<TInputItems...>::JoinBlock(std::size_t maxBufferedItemsPerPort,
+                                       JoinMode mode,
+                                       DataFlowBlockOptions options) : IDataFlowBlock{},
+                                                                       std::enable_shared_from_this<JoinBlock<TInputItems...>>{},
+                                                                       _mode{mode},
+                                                                       _ports{},
+                                                                       _innerBlock{},
+                                                                       _waitingProducersMutex{},
+                                                                       _waitingProducers{},
+                                                                       _nextJoinId{1},
+                                                                       _isJoinCompleted{false},
+                                                                       _isCompletionObserved{false}
+  {
+    if (maxBufferedItemsPerPort == 0)
+    {
+      throw std::invalid_argument("maxBufferedItemsPerPort");
+    }
+
+    for (std::size_t i = 0; i < PORTS_COUNT; ++i)
+    {
+      _ports.push_back(std::make_unique<PortState>(maxBufferedItemsPerPort));
+    }
+
+    _innerBlock = std::make_shared<InnerDataFlowBlock>(typename InnerDataFlowBlock::AsyncTransformManyFuncType{[this](const JoinInput& input, JoinState*& state, const OutputSinkFuncType& outputSink)
+                                                       {
+                                                         return joinItem(input, state, outputSink);
+                                                       }},
+                                                       typename InnerDataFlowBlock::AsyncFlushFuncType{},
+                                                       [](const JoinInput& _){return true;},
+                                                       std::move(options));
+  }
+
+  template <typename ... TInputItems>
+  std::string JoinBlock<TInputItems...>::Name() const
+  {
+    return _innerBlock->Name();
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::Name(std::string name)
+  {
+    _innerBlock->Name(name);
+  }
+
+  template <typename ... TInputItems>
+  IDataFlowBlock::TaskVoidType JoinBlock<TInputItems...>::Completion() const
+  {
+    return _innerBlock->Completion();
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::Start()
+  {
+    _innerBlock->Start();
+    //Producers of the items which could not be joined must not wait after the block has completed.
+    if (_mode == JoinMode::NonGreedy && !_isCompletionObserved.exchange(true))
+    {
+      _innerBlock->Completion().ContinueWith([weakThis = this->weak_from_this()](const auto& completion)
+      {
+        if (auto sharedThis = weakThis.lock())
+        {
+          sharedThis->releaseWaitingProducers(completion);
+        }
+      });
+    }
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::Complete()
+  {
+    _innerBlock->Complete();
+  }
+
+  template <typename ... TInputItems>
+  IDataFlowBlock::TaskVoidType JoinBlock<TInputItems...>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::SetFaulted(std::exception_ptr exception)
+  {
+    _innerBlock->SetFaulted(exception);
+  }
+
+  template <typename ... TInputItems>
+  template <std::size_t PortIndex>
+  typename IInputBlock<typename JoinBlock<TInputItems...>::template PortInputType<PortIndex>>::InputBlockPtr JoinBlock<TInputItems...>::Port()
+  {
+    static_assert(PortIndex < PORTS_COUNT, "Invalid port index.");
+    return std::make_shared<JoinPort<PortIndex>>(this->shared_from_this());
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::ConnectTo(const typename IInputBlock<OutputType>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->Then(nextBlock);
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::ConnectTo(const typename IInputBlock<OutputType>::InputBlockPtr& nextBlock,
+                                            const DataFlowLinkOptions<OutputType>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+  template <typename ... TInputItems>
+  template <std::size_t PortIndex>
+  bool JoinBlock<TInputItems...>::canAcceptPortInput()
+  {
+    return _innerBlock->IsAcceptingInput();
+  }
+
+  template <typename ... TInputItems>
+  template <std::size_t PortIndex>
+  Tasks::Task<void> JoinBlock<TInputItems...>::acceptPortInputAsync(PortInputType<PortIndex> item)
+  {
+    auto& port = *_ports[PortIndex];
+    co_await port.FreeSlots.WaitAsync();
+    ++port.BufferedItemsCount;
+    //The producer is registered before the item is added, so either the completion of the block releases the producer or the producer does not wait.
+    std::uint64_t joinId = 0;
+    std::optional<Tasks::Task<void>> joinedTask{};
+    if (_mode == JoinMode::NonGreedy)
+    {
+      joinedTask = addWaitingProducer(joinId);
+    }
+
+    try
+    {
+      JoinInput input{std::variant<TInputItems...>{std::in_place_index<PortIndex>, std::move(item)}, joinId};
+      co_await _innerBlock->AcceptInputAsync(std::move(input));
+    }
+    catch (...)
+    {
+      --port.BufferedItemsCount;
+      port.FreeSlots.Release();
+      if (joinedTask)
+      {
+        std::lock_guard lock{_waitingProducersMutex};
+        _waitingProducers.erase(joinId);
+      }
+
+      throw;
+    }
+
+    if (joinedTask)
+    {
+      co_await *joinedTask;
+    }
+  }
+
+  template <typename ... TInputItems>
+  std::optional<Tasks::Task<void>> JoinBlock<TInputItems...>::addWaitingProducer(std::uint64_t& joinId)
+  {
+    std::lock_guard lock{_waitingProducersMutex};
+    if (_isJoinCompleted)
+    {
+      return std::nullopt;
+    }
+
+    joinId = _nextJoinId++;
+    Tasks::TaskCompletionSource<void> joinedTcs{};
+    auto joinedTask = joinedTcs.GetTask();
+    _waitingProducers.emplace(joinId, std::move(joinedTcs));
+    return joinedTask;
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::releaseJoinedProducers(JoinState& state)
+  {
+    std::vector<Tasks::TaskCompletionSource<void>> joinedProducers{};
+    {
+      std::lock_guard lock{_waitingProducersMutex};
+      for (auto& joinIds : state.JoinIds)
+      {
+        if (joinIds.empty())
+        {
+          continue;
+        }
+
+        //The producer has not been registered when the item was added after the completion of the block.
+        if (auto waitingProducerIt = _waitingProducers.find(joinIds.front()); waitingProducerIt != _waitingProducers.end())
+        {
+          joinedProducers.push_back(std::move(waitingProducerIt->second));
+          _waitingProducers.erase(waitingProducerIt);
+        }
+
+        joinIds.pop_front();
+      }
+    }
+
+    for (auto& joinedProducer : joinedProducers)
+    {
+      joinedProducer.TrySetResult();
+    }
+  }
+
+  template <typename ... TInputItems>
+  void JoinBlock<TInputItems...>::releaseWaitingProducers(const IDataFlowBlock::TaskVoidType& completion)
+  {
+    std::unordered_map<std::uint64_t, Tasks::TaskCompletionSource<void>> waitingProducers{};
+    {
+      std::lock_guard lock{_waitingProducersMutex};
+      _isJoinCompleted = true;
+      waitingProducers.swap(_waitingProducers);
+    }
+
+    //Items which could not be joined are discarded together with the completed block.
+    for (auto& [_, waitingProducer] : waitingProducers)
+    {
+      if (completion.IsFaulted())
+      {
+        waitingProducer.TrySetException(completion.Exception());
+      }
+      else
+      {
+        waitingProducer.TrySetResult();
+      }
+    }
+  }
+
+  template <typename ... TInputItems>
+  Tasks::Task<void> JoinBlock<TInputItems...>::joinItem(const JoinInput& input,
+                                                        JoinState*& state,
+                                                        const OutputSinkFuncType& outputSink)
+  {
+    if (_mode == JoinMode::NonGreedy)
+    {
+      state->JoinIds[input.Item.index()].push_back(input.JoinId);
+    }
+
+    bufferItem(std::move(input.Item), *state, std::make_index_sequence<PORTS_COUNT>{});
+    if (!hasAllItems(*state, std::make_index_sequence<PORTS_COUNT>{}))
+    {
+      co_return;
+    }
+
+    auto joinedItems = takeJoinedItems(*state, std::make_index_sequence<PORTS_COUNT>{});
+    if (_mode == JoinMode::NonGreedy)
+    {
+      releaseJoinedProducers(*state);
+    }
+
+    auto delivery = outputSink(std::move(joinedItems));
+    co_await delivery;
+  }
+
+  template <typename ... TInputItems>
+  template <std::size_t ... PortIndices>
+  void JoinBlock<TInputItems...>::bufferItem(std::variant<TInputItems...>&& item, JoinState& state, std::index_sequence<PortIndices...>)
+  {
+    ((item.index() == PortIndices ? (std::get<PortIndices>(state.Items).push_back(std::get<PortIndices>(std::move(item))), 0) : 0), ...);
+  }
+
+  template <typename ... TInputItems>
+  template <std::size_t ... PortIndices>
+  bool JoinBlock<TInputItems...>::hasAllItems(const JoinState& state, std::index_sequence<PortIndices...>) const
+  {
+    return (!std::get<PortIndices>(state.Items).empty() && ...);
+  }
+
+  template <typename ... TInputItems>
+  template <std::size_t ... PortIndices>
+  typename JoinBlock<TInputItems...>::OutputType JoinBlock<TInputItems...>::takeJoinedItems(JoinState& state, std::index_sequence<PortIndices...>)
+  {
+    OutputType joinedItems{std::move(std::get<PortIndices>(state.Items).front())...};
+    (std::get<PortIndices>(state.Items).pop_front(), ...);
+    //Joined items leave the buffers of the ports.
+    ((--_ports[PortIndices]->BufferedItemsCount, _ports[PortIndices]->FreeSlots.Release()), ...);
+    return joinedItems;
+  }
+}
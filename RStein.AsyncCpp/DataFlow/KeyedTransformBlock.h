@@ -0,0 +1,267 @@
+﻿#pragma once
+#include "IInputOutputBlock.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include "../Schedulers/Scheduler.h"
+#include <exception>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Transforms input items in parallel lanes with the state of the key of the item. All items with the same key are processed by the same lane,
+  //so the items with the same key are processed in order and the state of the key is used only by one lane (without locks).
+  //Every lane has its own processing loop and the map of the key states. Lanes run in the options.TaskScheduler (default scheduler when the options do not specify a scheduler).
+  template<typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash = std::hash<TKey>>
+  class KeyedTransformBlock : public IInputOutputBlock<TInputItem, TOutputItem>,
+                              public std::enable_shared_from_this<KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>>
+  {
+  private:
+    using LaneState = std::unordered_map<TKey, TKeyState, THash>;
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TInputItem, TOutputItem, LaneState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+
+  public:
+    using KeySelectorFuncType = std::function<TKey(const TInputItem& item)>;
+    using TransformFuncType = std::function<TOutputItem(const TInputItem& item, TKeyState& keyState)>;
+    using CanAcceptFuncType = typename InnerDataFlowBlock::CanAcceptFuncType;
+
+    KeyedTransformBlock(std::size_t lanesCount,
+                        KeySelectorFuncType keySelector,
+                        TransformFuncType transformFunc,
+                        CanAcceptFuncType canAcceptFunc = [](auto _){return true;},
+                        DataFlowBlockOptions options = DataFlowBlockOptions{});
+    KeyedTransformBlock(const KeyedTransformBlock& other) = delete;
+    KeyedTransformBlock(KeyedTransformBlock&& other) = delete;
+    KeyedTransformBlock& operator=(const KeyedTransformBlock& other) = delete;
+    KeyedTransformBlock& operator=(KeyedTransformBlock&& other) = delete;
+
+    [[nodiscard]] std::string Name() const override;
+    void Name(std::string name);
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+    void Start() override;
+    void Complete() override;
+    IDataFlowBlock::TaskVoidType CompleteAsync() override;
+    void SetFaulted(std::exception_ptr exception) override;
+    bool CanAcceptInput(const TInputItem& item) override;
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+    [[nodiscard]] std::size_t PendingInputCount() const override;
+
+    void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock) override;
+    void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                   const DataFlowLinkOptions<TOutputItem>& linkOptions) override;
+    virtual ~KeyedTransformBlock() = default;
+
+  private:
+    std::string _name;
+    KeySelectorFuncType _keySelector;
+    TransformFuncType _transformFunc;
+    THash _hash;
+    std::vector<InnerDataFlowBlockPtr> _lanes;
+    IDataFlowBlock::TaskVoidType _completion;
+
+    std::vector<InnerDataFlowBlockPtr> createLanes(std::size_t lanesCount, CanAcceptFuncType canAcceptFunc, DataFlowBlockOptions options);
+    const InnerDataFlowBlockPtr& getLane(const TInputItem& item) const;
+    static IDataFlowBlock::TaskVoidType whenAllLanesCompleted(std::vector<InnerDataFlowBlockPtr> lanes);
+  };
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::KeyedTransformBlock(std::size_t lanesCount,
+                                                                                            KeySelectorFuncType keySelector,
+                                                                                            TransformFuncType transformFunc,
+                                                                                            CanAcceptFuncType canAcceptFunc,
+                                                                                            DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, TOutputItem>{},
+                                                                                                                            std::enable_shared_from_this<KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>>{},
+                                                                                                                            _name{},
+                                                                                                                            _keySelector{std::move(keySelector)},
+                                                                                                                            _transformFunc{std::move(transformFunc)},
+                                                                                                                            _hash{},
+                                                                                                                            _lanes{createLanes(lanesCount, std::move(canAcceptFunc), std::move(options))},
+                                                                                                                            _completion{whenAllLanesCompleted(_lanes)}
+  {
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  std::string KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::Name() const
+  {
+    return _name;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  void KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::Name(std::string name)
+  {
+    _name = name;
+    for (std::size_t i = 0; i < _lanes.size(); ++i)
+    {
+      _lanes[i]->Name(name + "-lane-" + std::to_string(i));
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  IDataFlowBlock::TaskVoidType KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::Completion() const
+  {
+    return _completion;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  void KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::Start()
+  {
+    for (auto& lane : _lanes)
+    {
+      lane->Start();
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  void KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::Complete()
+  {
+    for (auto& lane : _lanes)
+    {
+      lane->Complete();
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  IDataFlowBlock::TaskVoidType KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::CompleteAsync()
+  {
+    for (auto& lane : _lanes)
+    {
+      lane->CompleteAsync();
+    }
+
+    return _completion;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  void KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::SetFaulted(std::exception_ptr exception)
+  {
+    for (auto& lane : _lanes)
+    {
+      lane->SetFaulted(exception);
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  bool KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::CanAcceptInput(const TInputItem& item)
+  {
+    return getLane(item)->CanAcceptInput(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  IDataFlowBlock::TaskVoidType KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::AcceptInputAsync(const TInputItem& item)
+  {
+    return getLane(item)->AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  IDataFlowBlock::TaskVoidType KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::AcceptInputAsync(TInputItem&& item)
+  {
+    const auto& lane = getLane(item);
+    return lane->AcceptInputAsync(std::move(item));
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  std::size_t KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::PendingInputCount() const
+  {
+    std::size_t pendingInputCount = 0;
+    for (auto& lane : _lanes)
+    {
+      pendingInputCount += lane->PendingInputCount();
+    }
+
+    return pendingInputCount;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  void KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
+  {
+    for (auto& lane : _lanes)
+    {
+      lane->Then(nextBlock);
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  void KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                                                                                       const DataFlowLinkOptions<TOutputItem>& linkOptions)
+  {
+    for (auto& lane : _lanes)
+    {
+      lane->Then(nextBlock, linkOptions);
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  std::vector<typename KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::InnerDataFlowBlockPtr> KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::createLanes(std::size_t lanesCount,
+                                                                                                                                                                                                 CanAcceptFuncType canAcceptFunc,
+                                                                                                                                                                                                 DataFlowBlockOptions options)
+  {
+    if (lanesCount == 0)
+    {
+      throw std::invalid_argument("lanesCount");
+    }
+
+    if (!_keySelector)
+    {
+      throw std::invalid_argument("keySelector");
+    }
+
+    if (!_transformFunc)
+    {
+      throw std::invalid_argument("transformFunc");
+    }
+
+    if (!options.TaskScheduler)
+    {
+      options.TaskScheduler = Schedulers::Scheduler::DefaultScheduler();
+    }
+
+    std::vector<InnerDataFlowBlockPtr> lanes{};
+    lanes.reserve(lanesCount);
+    for (std::size_t i = 0; i < lanesCount; ++i)
+    {
+      lanes.push_back(std::make_shared<InnerDataFlowBlock>(typename InnerDataFlowBlock::TransformFuncType{[this](const TInputItem& item, LaneState*& laneState)
+                                                           {
+                                                             return _transformFunc(item, (*laneState)[_keySelector(item)]);
+                                                           }},
+                                                           canAcceptFunc,
+                                                           options));
+    }
+
+    return lanes;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  const typename KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::InnerDataFlowBlockPtr& KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::getLane(const TInputItem& item) const
+  {
+    return _lanes[_hash(_keySelector(item)) % _lanes.size()];
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TKey, typename TKeyState, typename THash>
+  IDataFlowBlock::TaskVoidType KeyedTransformBlock<TInputItem, TOutputItem, TKey, TKeyState, THash>::whenAllLanesCompleted(std::vector<InnerDataFlowBlockPtr> lanes)
+  {
+    //Block completes after all lanes, the first failure of the lane is rethrown.
+    std::exception_ptr laneException{};
+    for (auto& lane : lanes)
+    {
+      try
+      {
+        co_await lane->Completion();
+      }
+      catch (...)
+      {
+        if (!laneException)
+        {
+          laneException = std::current_exception();
+        }
+      }
+    }
+
+    if (laneException)
+    {
+      std::rethrow_exception(laneException);
+    }
+  }
+}
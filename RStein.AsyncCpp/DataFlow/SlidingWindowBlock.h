@@ -0,0 +1,221 @@
+﻿#pragma once
+#include "DataFlowWindowOptions.h"
+#include "IInputOutputBlock.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include <deque>
+#include <memory>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Aggregates input items in the window which slides with every input item. The addFunc adds the input item to the accumulator
+  //and the removeFunc removes the item which leaves the window, so the accumulator is never recomputed from all items of the window.
+  //Copy of the accumulator is sent to the linked blocks after every input item.
+  //Count window contains the last windowOptions.Count items. Time window contains the items with timestamps
+  //from the interval (timestamp of the last item - windowOptions.Duration, timestamp of the last item].
+  template<typename TInputItem, typename TAccumulate>
+  class SlidingWindowBlock : public IInputOutputBlock<TInputItem, TAccumulate>,
+                             public std::enable_shared_from_this<SlidingWindowBlock<TInputItem, TAccumulate>>
+  {
+  private:
+    struct WindowState
+    {
+      TAccumulate Accumulator{};
+      std::deque<TInputItem> Items{};
+    };
+
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TInputItem, TAccumulate, WindowState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+
+  public:
+    using AddFuncType = std::function<void(TAccumulate& accumulator, const TInputItem& item)>;
+    using RemoveFuncType = std::function<void(TAccumulate& accumulator, const TInputItem& item)>;
+    using CanAcceptFuncType = typename InnerDataFlowBlock::CanAcceptFuncType;
+
+    SlidingWindowBlock(DataFlowWindowOptions<TInputItem> windowOptions,
+                       AddFuncType addFunc,
+                       RemoveFuncType removeFunc,
+                       TAccumulate seed = TAccumulate{},
+                       CanAcceptFuncType canAcceptFunc = [](auto _){return true;},
+                       DataFlowBlockOptions options = DataFlowBlockOptions{});
+    SlidingWindowBlock(const SlidingWindowBlock& other) = delete;
+    SlidingWindowBlock(SlidingWindowBlock&& other) = delete;
+    SlidingWindowBlock& operator=(const SlidingWindowBlock& other) = delete;
+    SlidingWindowBlock& operator=(SlidingWindowBlock&& other) = delete;
+
+    [[nodiscard]] std::string Name() const override;
+    void Name(std::string name);
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+    void Start() override;
+    void Complete() override;
+    IDataFlowBlock::TaskVoidType CompleteAsync() override;
+    void SetFaulted(std::exception_ptr exception) override;
+    bool CanAcceptInput(const TInputItem& item) override;
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+    [[nodiscard]] std::size_t PendingInputCount() const override;
+
+    void ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock) override;
+    void ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock,
+                   const DataFlowLinkOptions<TAccumulate>& linkOptions) override;
+    virtual ~SlidingWindowBlock() = default;
+
+  private:
+    DataFlowWindowOptions<TInputItem> _windowOptions;
+    AddFuncType _addFunc;
+    RemoveFuncType _removeFunc;
+    TAccumulate _seed;
+    InnerDataFlowBlockPtr _innerBlock;
+
+    Tasks::Task<void> addItem(const TInputItem& item, WindowState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink);
+    bool isOutsideWindow(const TInputItem& windowItem, const TInputItem& lastItem, std::size_t windowItemsCount) const;
+  };
+
+  template <typename TInputItem, typename TAccumulate>
+  SlidingWindowBlock<TInputItem, TAccumulate>::SlidingWindowBlock(DataFlowWindowOptions<TInputItem> windowOptions,
+                                                                  AddFuncType addFunc,
+                                                                  RemoveFuncType removeFunc,
+                                                                  TAccumulate seed,
+                                                                  CanAcceptFuncType canAcceptFunc,
+                                                                  DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, TAccumulate>{},
+                                                                                                  std::enable_shared_from_this<SlidingWindowBlock<TInputItem, TAccumulate>>{},
+                                                                                                  _windowOptions{std::move(windowOptions)},
+                                                                                                  _addFunc{std::move(addFunc)},
+                                                                                                  _removeFunc{std::move(removeFunc)},
+                                                                                                  _seed{std::move(seed)},
+                                                                                                  _innerBlock{}
+  {
+    _windowOptions.Validate();
+    if (!_addFunc)
+    {
+      throw std::invalid_argument("addFunc");
+    }
+
+    if (!_removeFunc)
+    {
+      throw std::invalid_argument("removeFunc");
+    }
+
+    _innerBlock = std::make_shared<InnerDataFlowBlock>(typename InnerDataFlowBlock::AsyncTransformManyFuncType{[this](const TInputItem& item, WindowState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+                                                       {
+                                                         return addItem(item, state, outputSink);
+                                                       }},
+                                                       typename InnerDataFlowBlock::AsyncFlushFuncType{},
+                                                       std::move(canAcceptFunc),
+                                                       std::move(options));
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  std::string SlidingWindowBlock<TInputItem, TAccumulate>::Name() const
+  {
+    return _innerBlock->Name();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void SlidingWindowBlock<TInputItem, TAccumulate>::Name(std::string name)
+  {
+    _innerBlock->Name(name);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType SlidingWindowBlock<TInputItem, TAccumulate>::Completion() const
+  {
+    return _innerBlock->Completion();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void SlidingWindowBlock<TInputItem, TAccumulate>::Start()
+  {
+    _innerBlock->Start();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void SlidingWindowBlock<TInputItem, TAccumulate>::Complete()
+  {
+    _innerBlock->Complete();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType SlidingWindowBlock<TInputItem, TAccumulate>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void SlidingWindowBlock<TInputItem, TAccumulate>::SetFaulted(std::exception_ptr exception)
+  {
+    _innerBlock->SetFaulted(exception);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  bool SlidingWindowBlock<TInputItem, TAccumulate>::CanAcceptInput(const TInputItem& item)
+  {
+    return _innerBlock->CanAcceptInput(item);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType SlidingWindowBlock<TInputItem, TAccumulate>::AcceptInputAsync(const TInputItem& item)
+  {
+    return _innerBlock->AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType SlidingWindowBlock<TInputItem, TAccumulate>::AcceptInputAsync(TInputItem&& item)
+  {
+    return _innerBlock->AcceptInputAsync(std::move(item));
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  std::size_t SlidingWindowBlock<TInputItem, TAccumulate>::PendingInputCount() const
+  {
+    return _innerBlock->PendingInputCount();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void SlidingWindowBlock<TInputItem, TAccumulate>::ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->Then(nextBlock);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void SlidingWindowBlock<TInputItem, TAccumulate>::ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock,
+                                                              const DataFlowLinkOptions<TAccumulate>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  Tasks::Task<void> SlidingWindowBlock<TInputItem, TAccumulate>::addItem(const TInputItem& item,
+                                                                         WindowState*& state,
+                                                                         const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+  {
+    auto& items = state->Items;
+    if (items.empty())
+    {
+      state->Accumulator = _seed;
+    }
+
+    _addFunc(state->Accumulator, item);
+    items.push_back(item);
+    while (isOutsideWindow(items.front(), item, items.size()))
+    {
+      _removeFunc(state->Accumulator, items.front());
+      items.pop_front();
+    }
+
+    co_await outputSink(state->Accumulator);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  bool SlidingWindowBlock<TInputItem, TAccumulate>::isOutsideWindow(const TInputItem& windowItem,
+                                                                    const TInputItem& lastItem,
+                                                                    std::size_t windowItemsCount) const
+  {
+    if (_windowOptions.Mode == DataFlowWindowMode::Count)
+    {
+      return windowItemsCount > _windowOptions.Count;
+    }
+
+    return _windowOptions.TimestampSelector(windowItem) <= _windowOptions.TimestampSelector(lastItem) - _windowOptions.Duration;
+  }
+}
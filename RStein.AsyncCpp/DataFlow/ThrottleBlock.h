@@ -0,0 +1,316 @@
+﻿#pragma once
+#include "IInputOutputBlock.h"
+#include "../AsyncPrimitives/AsyncSemaphore.h"
+#include "../AsyncPrimitives/AsyncTimer.h"
+#include "../AsyncPrimitives/CancellationTokenSource.h"
+#include "../AsyncPrimitives/OperationCanceledException.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include "../Schedulers/Scheduler.h"
+#include "../Utils/FinallyBlock.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Passes input items to the linked blocks at most at the rate of itemsPerPeriod items per period (token bucket).
+  //Up to burstSize items pass without delay when the bucket is full. Items above the rate are delayed by the async timer, no thread waits for them.
+  //The block holds at most boundedCapacity items, AcceptInputAsync of the next item completes after the block has a free slot,
+  //so the linked predecessors are slowed down to the rate of the block.
+  //Producers waiting for a free slot are released when the block completes, their AcceptInputAsync call throws the exception of the faulted block.
+  template<typename TItem>
+  class ThrottleBlock : public IInputOutputBlock<TItem, TItem>,
+                        public std::enable_shared_from_this<ThrottleBlock<TItem>>
+  {
+  private:
+    using Clock = AsyncPrimitives::AsyncTimer::Clock;
+
+    struct BucketState
+    {
+      double Tokens{};
+      Clock::time_point LastRefill{};
+      bool IsInitialized{};
+    };
+
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TItem, TItem, BucketState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+
+  public:
+    using CanAcceptFuncType = typename InnerDataFlowBlock::CanAcceptFuncType;
+    static constexpr std::size_t DEFAULT_BOUNDED_CAPACITY = 1024;
+
+    ThrottleBlock(std::size_t itemsPerPeriod,
+                  std::chrono::milliseconds period,
+                  std::size_t burstSize = 1,
+                  std::size_t boundedCapacity = DEFAULT_BOUNDED_CAPACITY,
+                  CanAcceptFuncType canAcceptFunc = [](auto _){return true;},
+                  DataFlowBlockOptions options = DataFlowBlockOptions{});
+    ThrottleBlock(const ThrottleBlock& other) = delete;
+    ThrottleBlock(ThrottleBlock&& other) = delete;
+    ThrottleBlock& operator=(const ThrottleBlock& other) = delete;
+    ThrottleBlock& operator=(ThrottleBlock&& other) = delete;
+
+    [[nodiscard]] std::string Name() const override;
+    void Name(std::string name);
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+    void Start() override;
+    void Complete() override;
+    IDataFlowBlock::TaskVoidType CompleteAsync() override;
+    void SetFaulted(std::exception_ptr exception) override;
+    bool CanAcceptInput(const TItem& item) override;
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(const TItem& item) override;
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(TItem&& item) override;
+    [[nodiscard]] std::size_t PendingInputCount() const override;
+
+    void ConnectTo(const typename IInputBlock<TItem>::InputBlockPtr& nextBlock) override;
+    void ConnectTo(const typename IInputBlock<TItem>::InputBlockPtr& nextBlock,
+                   const DataFlowLinkOptions<TItem>& linkOptions) override;
+    virtual ~ThrottleBlock() = default;
+
+  private:
+    std::chrono::duration<double> _tokenInterval;
+    double _burstSize;
+    Schedulers::Scheduler::SchedulerPtr _scheduler;
+    AsyncPrimitives::AsyncTimer::AsyncTimerPtr _timer;
+    AsyncPrimitives::AsyncSemaphore _freeSlots;
+    AsyncPrimitives::CancellationTokenSource _completionCts;
+    std::atomic<std::size_t> _heldItemsCount;
+    InnerDataFlowBlockPtr _innerBlock;
+
+    Tasks::Task<void> acceptInputAsync(TItem item);
+    void throwCompletedBlockException() const;
+    Tasks::Task<void> throttleItem(const TItem& item, BucketState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink);
+    void refillBucket(BucketState& state, Clock::time_point now) const;
+  };
+
+  template <typename TItem>
+  ThrottleBlock<TItem>::ThrottleBlock(std::size_t itemsPerPeriod,
+                                      std::chrono::milliseconds period,
+                                      std::size_t burstSize,
+                                      std::size_t boundedCapacity,
+                                      CanAcceptFuncType canAcceptFunc,
+                                      DataFlowBlockOptions options) : IInputOutputBlock<TItem, TItem>{},
+                                                                      std::enable_shared_from_this<ThrottleBlock<TItem>>{},
+                                                                      _tokenInterval{itemsPerPeriod == 0
+                                                                                       ? std::chrono::duration<double>::zero()
+                                                                                       : std::chrono::duration<double>{period} / static_cast<double>(itemsPerPeriod)},
+                                                                      _burstSize{static_cast<double>(burstSize)},
+                                                                      _scheduler{options.TaskScheduler},
+                                                                      _timer{AsyncPrimitives::AsyncTimer::DefaultTimer()},
+                                                                      _freeSlots{static_cast<int>(boundedCapacity), static_cast<int>(boundedCapacity)},
+                                                                      _completionCts{},
+                                                                      _heldItemsCount{0},
+                                                                      _innerBlock{}
+  {
+    if (itemsPerPeriod == 0)
+    {
+      throw std::invalid_argument("itemsPerPeriod");
+    }
+
+    if (period <= std::chrono::milliseconds::zero())
+    {
+      throw std::invalid_argument("period");
+    }
+
+    if (burstSize == 0)
+    {
+      throw std::invalid_argument("burstSize");
+    }
+
+    if (boundedCapacity == 0)
+    {
+      throw std::invalid_argument("boundedCapacity");
+    }
+
+    //Skipped input items would never release their slots.
+    if (options.ProcessLatestInputOnly)
+    {
+      throw std::invalid_argument("options.ProcessLatestInputOnly");
+    }
+
+    _innerBlock = std::make_shared<InnerDataFlowBlock>(typename InnerDataFlowBlock::AsyncTransformManyFuncType{[this](const TItem& item, BucketState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+                                                       {
+                                                         return throttleItem(item, state, outputSink);
+                                                       }},
+                                                       typename InnerDataFlowBlock::AsyncFlushFuncType{},
+                                                       std::move(canAcceptFunc),
+                                                       std::move(options));
+
+    //Slots of the items which were not processed by the completed (faulted, canceled) block are never released.
+    _innerBlock->Completion().ContinueWith([completionCts = _completionCts](const auto& _)
+    {
+      completionCts.Cancel();
+    });
+  }
+
+  template <typename TItem>
+  std::string ThrottleBlock<TItem>::Name() const
+  {
+    return _innerBlock->Name();
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::Name(std::string name)
+  {
+    _innerBlock->Name(name);
+  }
+
+  template <typename TItem>
+  IDataFlowBlock::TaskVoidType ThrottleBlock<TItem>::Completion() const
+  {
+    return _innerBlock->Completion();
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::Start()
+  {
+    _innerBlock->Start();
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::Complete()
+  {
+    _innerBlock->Complete();
+  }
+
+  template <typename TItem>
+  IDataFlowBlock::TaskVoidType ThrottleBlock<TItem>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::SetFaulted(std::exception_ptr exception)
+  {
+    _innerBlock->SetFaulted(exception);
+  }
+
+  template <typename TItem>
+  bool ThrottleBlock<TItem>::CanAcceptInput(const TItem& item)
+  {
+    return _innerBlock->CanAcceptInput(item);
+  }
+
+  template <typename TItem>
+  IDataFlowBlock::TaskVoidType ThrottleBlock<TItem>::AcceptInputAsync(const TItem& item)
+  {
+    return acceptInputAsync(item);
+  }
+
+  template <typename TItem>
+  IDataFlowBlock::TaskVoidType ThrottleBlock<TItem>::AcceptInputAsync(TItem&& item)
+  {
+    return acceptInputAsync(std::move(item));
+  }
+
+  template <typename TItem>
+  std::size_t ThrottleBlock<TItem>::PendingInputCount() const
+  {
+    //The inner block decrements its counter only after the slot of the item has been released.
+    return _heldItemsCount.load();
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::ConnectTo(const typename IInputBlock<TItem>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->Then(nextBlock);
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::ConnectTo(const typename IInputBlock<TItem>::InputBlockPtr& nextBlock,
+                                       const DataFlowLinkOptions<TItem>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> ThrottleBlock<TItem>::acceptInputAsync(TItem item)
+  {
+    auto freeSlotTask = _freeSlots.WaitAsync(_completionCts.Token());
+    try
+    {
+      co_await freeSlotTask;
+    }
+    catch (const AsyncPrimitives::OperationCanceledException&)
+    {
+      throwCompletedBlockException();
+    }
+
+    ++_heldItemsCount;
+    try
+    {
+      co_await _innerBlock->AcceptInputAsync(std::move(item));
+    }
+    catch (...)
+    {
+      --_heldItemsCount;
+      _freeSlots.Release();
+      throw;
+    }
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::throwCompletedBlockException() const
+  {
+    const auto completion = _innerBlock->Completion();
+    if (completion.IsFaulted())
+    {
+      std::rethrow_exception(completion.Exception());
+    }
+
+    throw std::logic_error("Node does not running");
+  }
+
+  template <typename TItem>
+  Tasks::Task<void> ThrottleBlock<TItem>::throttleItem(const TItem& item,
+                                                       BucketState*& state,
+                                                       const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+  {
+    //The slot is released after the item leaves the block, so the delayed item counts to the bounded capacity.
+    //The slot of the item which faults the block is not released, the waiting producers are released by the completion of the block.
+    auto isItemDelivered = false;
+    Utils::FinallyBlock releaseSlot{[this, &isItemDelivered]
+    {
+      --_heldItemsCount;
+      if (isItemDelivered)
+      {
+        _freeSlots.Release();
+      }
+    }};
+    refillBucket(*state, Clock::now());
+    if (state->Tokens < 1.0)
+    {
+      const auto delay = std::chrono::ceil<Clock::duration>(_tokenInterval * (1.0 - state->Tokens));
+      co_await _timer->DelayAsync(delay);
+      if (_scheduler && Schedulers::Scheduler::CurrentScheduler() != _scheduler)
+      {
+        auto& blockScheduler = *_scheduler;
+        co_await blockScheduler;
+      }
+
+      refillBucket(*state, Clock::now());
+    }
+
+    state->Tokens = std::max(state->Tokens - 1.0, 0.0);
+    co_await outputSink(item);
+    isItemDelivered = true;
+  }
+
+  template <typename TItem>
+  void ThrottleBlock<TItem>::refillBucket(BucketState& state, Clock::time_point now) const
+  {
+    if (!state.IsInitialized)
+    {
+      state.Tokens = _burstSize;
+      state.LastRefill = now;
+      state.IsInitialized = true;
+      return;
+    }
+
+    const std::chrono::duration<double> elapsed = now - state.LastRefill;
+    state.Tokens = std::min(_burstSize, state.Tokens + elapsed / _tokenInterval);
+    state.LastRefill = now;
+  }
+}
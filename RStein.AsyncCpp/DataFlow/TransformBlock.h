@@ -7,6 +7,7 @@ namespace RStein::AsyncCpp::DataFlow
 {
   template<typename TInputItem, typename TOutputItem, typename TState=Detail::NoState>
   class TransformBlock : public IInputOutputBlock<TInputItem, TOutputItem>,
+                         public Detail::IFusibleInputBlock<TInputItem>,
                          public std::enable_shared_from_this<TransformBlock<TInputItem, TOutputItem, TState>>
 
   {
@@ -16,8 +17,12 @@ namespace RStein::AsyncCpp::DataFlow
     using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
 
   public:
-    explicit TransformBlock(typename InnerDataFlowBlock::TransformFuncType transformFunc, typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [] (auto _){return true;});
-    explicit TransformBlock(typename InnerDataFlowBlock::AsyncTransformFuncType transformFunc, typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [] (auto _){return true;});
+    explicit TransformBlock(typename InnerDataFlowBlock::TransformFuncType transformFunc,
+                            typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [] (auto _){return true;},
+                            DataFlowBlockOptions options = DataFlowBlockOptions{});
+    explicit TransformBlock(typename InnerDataFlowBlock::AsyncTransformFuncType transformFunc,
+                            typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [] (auto _){return true;},
+                            DataFlowBlockOptions options = DataFlowBlockOptions{});
     TransformBlock(const TransformBlock& other) = delete;
     TransformBlock(TransformBlock&& other) = delete;
     TransformBlock& operator=(const TransformBlock& other) = delete;
@@ -28,13 +33,26 @@ namespace RStein::AsyncCpp::DataFlow
       [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
       void Start() override;
       void Complete() override;
+      typename IDataFlowBlock::TaskVoidType CompleteAsync() override;
       void SetFaulted(std::exception_ptr exception) override;
       bool CanAcceptInput(const TInputItem& item) override;
 
       typename IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
       IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+      [[nodiscard]] std::size_t PendingInputCount() const override;
+      //Replaces the input queue of the block (for example with the AsyncPriorityProducerConsumerCollection). Must be called before the block starts.
+      void InputItems(std::unique_ptr<AsyncPrimitives::IAsyncProducerConsumerCollection<TInputItem>> inputItems);
+      void AddPredecessor() override;
+      bool TryFuseWithPredecessor() override;
+      void UnfuseFromPredecessor() override;
+      [[nodiscard]] bool IsFusedWithPredecessor() const override;
+      std::optional<IDataFlowBlock::TaskVoidType> AcceptFusedInput(const TInputItem& item) override;
 
       void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock) override;
+      void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                     const DataFlowLinkOptions<TOutputItem>& linkOptions) override;
+      //Removes the links to the nextBlock while the block is running. The disconnected block is not completed together with this block.
+      void DisconnectFrom(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock);
       virtual ~TransformBlock() = default;
  
   private:
@@ -44,9 +62,10 @@ namespace RStein::AsyncCpp::DataFlow
 
   template <typename TInputItem, typename TOutputItem, typename TState>
   TransformBlock<TInputItem, TOutputItem, TState>::TransformBlock(typename InnerDataFlowBlock::TransformFuncType transformFunc,
-                                                                  typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc) : IInputOutputBlock<TInputItem, TOutputItem>{},
-                                                                                                                                  std::enable_shared_from_this<TransformBlock<TInputItem, TOutputItem, TState>>{},
-                                                                                                                                  _innerBlock{std::make_shared<InnerDataFlowBlock>(transformFunc, canAcceptFunc)}
+                                                                  typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc,
+                                                                  DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, TOutputItem>{},
+                                                                                                  std::enable_shared_from_this<TransformBlock<TInputItem, TOutputItem, TState>>{},
+                                                                                                  _innerBlock{std::make_shared<InnerDataFlowBlock>(transformFunc, canAcceptFunc, std::move(options))}
   {
 
   }
@@ -54,9 +73,10 @@ namespace RStein::AsyncCpp::DataFlow
   template <typename TInputItem, typename TOutputItem, typename TState>
   TransformBlock<TInputItem, TOutputItem, TState>::TransformBlock(
       typename InnerDataFlowBlock::AsyncTransformFuncType transformFunc,
-      typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc) : IInputOutputBlock<TInputItem, TOutputItem>{},
-                                                                     std::enable_shared_from_this<TransformBlock<TInputItem, TOutputItem, TState>>{},
-                                                                     _innerBlock{std::make_shared<InnerDataFlowBlock>(transformFunc, canAcceptFunc)}
+      typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc,
+      DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, TOutputItem>{},
+                                      std::enable_shared_from_this<TransformBlock<TInputItem, TOutputItem, TState>>{},
+                                      _innerBlock{std::make_shared<InnerDataFlowBlock>(transformFunc, canAcceptFunc, std::move(options))}
   {
 
   }
@@ -93,6 +113,12 @@ namespace RStein::AsyncCpp::DataFlow
     return _innerBlock->Complete();
   }
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename IDataFlowBlock::TaskVoidType TransformBlock<TInputItem, TOutputItem, TState>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
   template <typename TInputItem, typename TOutputItem, typename TState>
   void TransformBlock<TInputItem, TOutputItem, TState>::SetFaulted(std::exception_ptr exception)
   {
@@ -118,6 +144,12 @@ namespace RStein::AsyncCpp::DataFlow
     return _innerBlock->AcceptInputAsync(item);
   }
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::size_t TransformBlock<TInputItem, TOutputItem, TState>::PendingInputCount() const
+  {
+    return _innerBlock->PendingInputCount();
+  }
+
   template <typename TInputItem, typename TOutputItem, typename TState>
   void TransformBlock<TInputItem, TOutputItem, TState>::ConnectTo(
       const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
@@ -125,4 +157,54 @@ namespace RStein::AsyncCpp::DataFlow
     _innerBlock->Then(nextBlock);
   }
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformBlock<TInputItem, TOutputItem, TState>::ConnectTo(
+      const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+      const DataFlowLinkOptions<TOutputItem>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformBlock<TInputItem, TOutputItem, TState>::DisconnectFrom(
+      const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->DisconnectFrom(nextBlock);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformBlock<TInputItem, TOutputItem, TState>::InputItems(std::unique_ptr<AsyncPrimitives::IAsyncProducerConsumerCollection<TInputItem>> inputItems)
+  {
+    _innerBlock->InputItems(std::move(inputItems));
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformBlock<TInputItem, TOutputItem, TState>::AddPredecessor()
+  {
+    _innerBlock->AddPredecessor();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool TransformBlock<TInputItem, TOutputItem, TState>::TryFuseWithPredecessor()
+  {
+    return _innerBlock->TryFuseWithPredecessor();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformBlock<TInputItem, TOutputItem, TState>::UnfuseFromPredecessor()
+  {
+    _innerBlock->UnfuseFromPredecessor();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool TransformBlock<TInputItem, TOutputItem, TState>::IsFusedWithPredecessor() const
+  {
+    return _innerBlock->IsFusedWithPredecessor();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::optional<IDataFlowBlock::TaskVoidType> TransformBlock<TInputItem, TOutputItem, TState>::AcceptFusedInput(const TInputItem& item)
+  {
+    return _innerBlock->AcceptFusedInput(item);
+  }
 }
\ No newline at end of file
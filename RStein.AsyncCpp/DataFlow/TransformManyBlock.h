@@ -0,0 +1,152 @@
+﻿#pragma once
+#include "IInputOutputBlock.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include <memory>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Transforms one input item to any number of output items. Transformation sends the output items one at a time
+  //to the output sink and awaits the returned task, so the output items are not collected to an intermediate container.
+  //Returned task completes when the propagation window of the block has room for the next output item.
+  template<typename TInputItem, typename TOutputItem, typename TState=Detail::NoState>
+  class TransformManyBlock : public IInputOutputBlock<TInputItem, TOutputItem>,
+                             public std::enable_shared_from_this<TransformManyBlock<TInputItem, TOutputItem, TState>>
+
+  {
+
+  private:
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TInputItem, TOutputItem, TState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+
+  public:
+    using OutputSinkFuncType = typename InnerDataFlowBlock::OutputSinkFuncType;
+
+    explicit TransformManyBlock(typename InnerDataFlowBlock::AsyncTransformManyFuncType transformFunc,
+                                typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc = [] (auto _){return true;},
+                                DataFlowBlockOptions options = DataFlowBlockOptions{});
+    TransformManyBlock(const TransformManyBlock& other) = delete;
+    TransformManyBlock(TransformManyBlock&& other) = delete;
+    TransformManyBlock& operator=(const TransformManyBlock& other) = delete;
+    TransformManyBlock& operator=(TransformManyBlock&& other) = delete;
+
+      [[nodiscard]] std::string Name() const override;
+      void Name(std::string name);  
+      [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+      void Start() override;
+      void Complete() override;
+      typename IDataFlowBlock::TaskVoidType CompleteAsync() override;
+      void SetFaulted(std::exception_ptr exception) override;
+      bool CanAcceptInput(const TInputItem& item) override;
+
+      typename IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
+      IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+      [[nodiscard]] std::size_t PendingInputCount() const override;
+
+      void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock) override;
+      void ConnectTo(const typename IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                     const DataFlowLinkOptions<TOutputItem>& linkOptions) override;
+      virtual ~TransformManyBlock() = default;
+ 
+  private:
+   
+    InnerDataFlowBlockPtr _innerBlock;
+  };
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  TransformManyBlock<TInputItem, TOutputItem, TState>::TransformManyBlock(
+      typename InnerDataFlowBlock::AsyncTransformManyFuncType transformFunc,
+      typename InnerDataFlowBlock::CanAcceptFuncType canAcceptFunc,
+      DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, TOutputItem>{},
+                                      std::enable_shared_from_this<TransformManyBlock<TInputItem, TOutputItem, TState>>{},
+                                      _innerBlock{std::make_shared<InnerDataFlowBlock>(transformFunc,
+                                                                                       typename InnerDataFlowBlock::AsyncFlushFuncType{},
+                                                                                       canAcceptFunc,
+                                                                                       std::move(options))}
+  {
+
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::string TransformManyBlock<TInputItem, TOutputItem, TState>::Name() const
+  {
+    return _innerBlock->Name();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformManyBlock<TInputItem, TOutputItem, TState>::Name(std::string name)
+  {
+    _innerBlock->Name(name);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  IDataFlowBlock::TaskVoidType TransformManyBlock<
+    TInputItem, TOutputItem, TState>::Completion() const
+  {
+    return _innerBlock->Completion();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformManyBlock<TInputItem, TOutputItem, TState>::Start()
+  {
+    _innerBlock ->Start();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformManyBlock<TInputItem, TOutputItem, TState>::Complete()
+  {
+    return _innerBlock->Complete();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename IDataFlowBlock::TaskVoidType TransformManyBlock<TInputItem, TOutputItem, TState>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformManyBlock<TInputItem, TOutputItem, TState>::SetFaulted(std::exception_ptr exception)
+  {
+    _innerBlock->SetFaulted(exception);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool TransformManyBlock<TInputItem, TOutputItem, TState>::CanAcceptInput(const TInputItem& item)
+  {
+    return _innerBlock->CanAcceptInput(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType TransformManyBlock<
+    TInputItem, TOutputItem, TState>::AcceptInputAsync(const TInputItem& item)
+  {
+    return _innerBlock->AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  IDataFlowBlock::TaskVoidType TransformManyBlock<TInputItem, TOutputItem, TState>::AcceptInputAsync(TInputItem&& item)
+  {
+    return _innerBlock->AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::size_t TransformManyBlock<TInputItem, TOutputItem, TState>::PendingInputCount() const
+  {
+    return _innerBlock->PendingInputCount();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformManyBlock<TInputItem, TOutputItem, TState>::ConnectTo(
+      const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->Then(nextBlock);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void TransformManyBlock<TInputItem, TOutputItem, TState>::ConnectTo(
+      const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+      const DataFlowLinkOptions<TOutputItem>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+}
\ No newline at end of file
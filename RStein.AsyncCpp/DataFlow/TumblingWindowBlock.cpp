@@ -0,0 +1,6 @@
+﻿#include "TumblingWindowBlock.h"
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  
+}
\ No newline at end of file
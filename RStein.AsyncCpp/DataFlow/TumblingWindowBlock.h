@@ -0,0 +1,233 @@
+﻿#pragma once
+#include "DataFlowWindowOptions.h"
+#include "IInputOutputBlock.h"
+#include "../Detail/DataFlow/DataFlowBlockCommon.h"
+#include <memory>
+
+namespace RStein::AsyncCpp::DataFlow
+{
+  //Aggregates input items in consecutive non-overlapping windows. The addFunc adds the input item to the accumulator of the current window,
+  //the accumulator is sent to the linked blocks when the window closes and the next window starts with the seed.
+  //Count window closes after windowOptions.Count items. Time window closes when the first item with a timestamp from the next window arrives,
+  //windows are aligned to the multiples of windowOptions.Duration and empty windows are not sent. The partial window is sent when the block is completed.
+  template<typename TInputItem, typename TAccumulate>
+  class TumblingWindowBlock : public IInputOutputBlock<TInputItem, TAccumulate>,
+                              public std::enable_shared_from_this<TumblingWindowBlock<TInputItem, TAccumulate>>
+  {
+  private:
+    struct WindowState
+    {
+      TAccumulate Accumulator{};
+      std::size_t ItemsCount{};
+      long long WindowIndex{};
+    };
+
+    using InnerDataFlowBlock = Detail::DataFlowBlockCommon<TInputItem, TAccumulate, WindowState>;
+    using InnerDataFlowBlockPtr = typename InnerDataFlowBlock::DataFlowBlockCommonPtr;
+
+  public:
+    using AddFuncType = std::function<void(TAccumulate& accumulator, const TInputItem& item)>;
+    using CanAcceptFuncType = typename InnerDataFlowBlock::CanAcceptFuncType;
+
+    TumblingWindowBlock(DataFlowWindowOptions<TInputItem> windowOptions,
+                        AddFuncType addFunc,
+                        TAccumulate seed = TAccumulate{},
+                        CanAcceptFuncType canAcceptFunc = [](auto _){return true;},
+                        DataFlowBlockOptions options = DataFlowBlockOptions{});
+    TumblingWindowBlock(const TumblingWindowBlock& other) = delete;
+    TumblingWindowBlock(TumblingWindowBlock&& other) = delete;
+    TumblingWindowBlock& operator=(const TumblingWindowBlock& other) = delete;
+    TumblingWindowBlock& operator=(TumblingWindowBlock&& other) = delete;
+
+    [[nodiscard]] std::string Name() const override;
+    void Name(std::string name);
+    [[nodiscard]] IDataFlowBlock::TaskVoidType Completion() const override;
+    void Start() override;
+    void Complete() override;
+    IDataFlowBlock::TaskVoidType CompleteAsync() override;
+    void SetFaulted(std::exception_ptr exception) override;
+    bool CanAcceptInput(const TInputItem& item) override;
+
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
+    IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+    [[nodiscard]] std::size_t PendingInputCount() const override;
+
+    void ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock) override;
+    void ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock,
+                   const DataFlowLinkOptions<TAccumulate>& linkOptions) override;
+    virtual ~TumblingWindowBlock() = default;
+
+  private:
+    DataFlowWindowOptions<TInputItem> _windowOptions;
+    AddFuncType _addFunc;
+    TAccumulate _seed;
+    InnerDataFlowBlockPtr _innerBlock;
+
+    Tasks::Task<void> addItem(const TInputItem& item, WindowState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink);
+    Tasks::Task<void> sendWindow(WindowState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink);
+    long long getWindowIndex(const TInputItem& item) const;
+  };
+
+  template <typename TInputItem, typename TAccumulate>
+  TumblingWindowBlock<TInputItem, TAccumulate>::TumblingWindowBlock(DataFlowWindowOptions<TInputItem> windowOptions,
+                                                                    AddFuncType addFunc,
+                                                                    TAccumulate seed,
+                                                                    CanAcceptFuncType canAcceptFunc,
+                                                                    DataFlowBlockOptions options) : IInputOutputBlock<TInputItem, TAccumulate>{},
+                                                                                                    std::enable_shared_from_this<TumblingWindowBlock<TInputItem, TAccumulate>>{},
+                                                                                                    _windowOptions{std::move(windowOptions)},
+                                                                                                    _addFunc{std::move(addFunc)},
+                                                                                                    _seed{std::move(seed)},
+                                                                                                    _innerBlock{}
+  {
+    _windowOptions.Validate();
+    if (!_addFunc)
+    {
+      throw std::invalid_argument("addFunc");
+    }
+
+    _innerBlock = std::make_shared<InnerDataFlowBlock>(typename InnerDataFlowBlock::AsyncTransformManyFuncType{[this](const TInputItem& item, WindowState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+                                                       {
+                                                         return addItem(item, state, outputSink);
+                                                       }},
+                                                       typename InnerDataFlowBlock::AsyncFlushFuncType{[this](WindowState*& state, const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+                                                       {
+                                                         return sendWindow(state, outputSink);
+                                                       }},
+                                                       std::move(canAcceptFunc),
+                                                       std::move(options));
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  std::string TumblingWindowBlock<TInputItem, TAccumulate>::Name() const
+  {
+    return _innerBlock->Name();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void TumblingWindowBlock<TInputItem, TAccumulate>::Name(std::string name)
+  {
+    _innerBlock->Name(name);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType TumblingWindowBlock<TInputItem, TAccumulate>::Completion() const
+  {
+    return _innerBlock->Completion();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void TumblingWindowBlock<TInputItem, TAccumulate>::Start()
+  {
+    _innerBlock->Start();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void TumblingWindowBlock<TInputItem, TAccumulate>::Complete()
+  {
+    _innerBlock->Complete();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType TumblingWindowBlock<TInputItem, TAccumulate>::CompleteAsync()
+  {
+    return _innerBlock->CompleteAsync();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void TumblingWindowBlock<TInputItem, TAccumulate>::SetFaulted(std::exception_ptr exception)
+  {
+    _innerBlock->SetFaulted(exception);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  bool TumblingWindowBlock<TInputItem, TAccumulate>::CanAcceptInput(const TInputItem& item)
+  {
+    return _innerBlock->CanAcceptInput(item);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType TumblingWindowBlock<TInputItem, TAccumulate>::AcceptInputAsync(const TInputItem& item)
+  {
+    return _innerBlock->AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  IDataFlowBlock::TaskVoidType TumblingWindowBlock<TInputItem, TAccumulate>::AcceptInputAsync(TInputItem&& item)
+  {
+    return _innerBlock->AcceptInputAsync(std::move(item));
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  std::size_t TumblingWindowBlock<TInputItem, TAccumulate>::PendingInputCount() const
+  {
+    return _innerBlock->PendingInputCount();
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void TumblingWindowBlock<TInputItem, TAccumulate>::ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock)
+  {
+    _innerBlock->Then(nextBlock);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  void TumblingWindowBlock<TInputItem, TAccumulate>::ConnectTo(const typename IInputBlock<TAccumulate>::InputBlockPtr& nextBlock,
+                                                               const DataFlowLinkOptions<TAccumulate>& linkOptions)
+  {
+    _innerBlock->Then(nextBlock, linkOptions);
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  Tasks::Task<void> TumblingWindowBlock<TInputItem, TAccumulate>::addItem(const TInputItem& item,
+                                                                          WindowState*& state,
+                                                                          const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+  {
+    if (_windowOptions.Mode == DataFlowWindowMode::Time)
+    {
+      const auto windowIndex = getWindowIndex(item);
+      if (state->ItemsCount != 0 && windowIndex != state->WindowIndex)
+      {
+        co_await sendWindow(state, outputSink);
+      }
+
+      state->WindowIndex = windowIndex;
+    }
+
+    if (state->ItemsCount == 0)
+    {
+      state->Accumulator = _seed;
+    }
+
+    _addFunc(state->Accumulator, item);
+    state->ItemsCount++;
+    if (_windowOptions.Mode == DataFlowWindowMode::Count && state->ItemsCount == _windowOptions.Count)
+    {
+      co_await sendWindow(state, outputSink);
+    }
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  Tasks::Task<void> TumblingWindowBlock<TInputItem, TAccumulate>::sendWindow(WindowState*& state,
+                                                                             const typename InnerDataFlowBlock::OutputSinkFuncType& outputSink)
+  {
+    if (state->ItemsCount == 0)
+    {
+      co_return;
+    }
+
+    state->ItemsCount = 0;
+    co_await outputSink(std::move(state->Accumulator));
+  }
+
+  template <typename TInputItem, typename TAccumulate>
+  long long TumblingWindowBlock<TInputItem, TAccumulate>::getWindowIndex(const TInputItem& item) const
+  {
+    const auto timestamp = _windowOptions.TimestampSelector(item).count();
+    const auto duration = _windowOptions.Duration.count();
+    //Floor division, windows before the epoch have negative indices.
+    const auto windowIndex = timestamp / duration;
+    return timestamp % duration < 0
+             ? windowIndex - 1
+             : windowIndex;
+  }
+}
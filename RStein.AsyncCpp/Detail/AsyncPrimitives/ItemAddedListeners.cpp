@@ -0,0 +1 @@
+#include "ItemAddedListeners.h"
@@ -0,0 +1,85 @@
+#pragma once
+#include "../../AsyncPrimitives/IAsyncProducerConsumerCollection.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace RStein::AsyncCpp::Detail
+{
+  //Listeners registered with the IAsyncProducerConsumerCollection (Select).
+  //Notify is cheap when no listener is registered: the collection publishes the item, then Notify reads the listeners count after the fence.
+  //The listener registers itself, then checks the collection (TryTakeMany), so the item added in the meantime is never missed.
+  template<typename TItem>
+  class ItemAddedListeners
+  {
+  public:
+    using ListenerPtr = std::shared_ptr<RStein::AsyncCpp::AsyncPrimitives::IItemAddedListener<TItem>>;
+
+    ItemAddedListeners() : _listenersCount{0},
+                           _listenersMutex{},
+                           _listeners{}
+    {
+    }
+
+    ItemAddedListeners(const ItemAddedListeners& other) = delete;
+    ItemAddedListeners(ItemAddedListeners&& other) noexcept = delete;
+    ItemAddedListeners& operator=(const ItemAddedListeners& other) = delete;
+    ItemAddedListeners& operator=(ItemAddedListeners&& other) noexcept = delete;
+    ~ItemAddedListeners() = default;
+
+    void Add(const ListenerPtr& listener)
+    {
+      {
+        std::lock_guard lock{_listenersMutex};
+        _listeners.push_back(listener);
+        _listenersCount.store(_listeners.size(), std::memory_order_seq_cst);
+      }
+
+      //The listener checks the collection after the registration.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void Remove(const ListenerPtr& listener)
+    {
+      std::lock_guard lock{_listenersMutex};
+      auto listenerIt = std::find(_listeners.begin(), _listeners.end(), listener);
+      if (listenerIt == _listeners.end())
+      {
+        return;
+      }
+
+      _listeners.erase(listenerIt);
+      _listenersCount.store(_listeners.size(), std::memory_order_seq_cst);
+    }
+
+    void Notify(RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TItem>& collection)
+    {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_listenersCount.load(std::memory_order_relaxed) == 0)
+      {
+        return;
+      }
+
+      std::vector<ListenerPtr> listeners;
+      {
+        std::lock_guard lock{_listenersMutex};
+        listeners = _listeners;
+      }
+
+      //Notified listener may take an item from the collection (TryTakeMany). The take may resume a waiting producer, whose item notifies the listeners again, do not hold the lock.
+      for (auto& listener : listeners)
+      {
+        listener->OnItemAdded(collection);
+      }
+    }
+
+  private:
+    std::atomic<std::size_t> _listenersCount;
+    std::mutex _listenersMutex;
+    std::vector<ListenerPtr> _listeners;
+  };
+}
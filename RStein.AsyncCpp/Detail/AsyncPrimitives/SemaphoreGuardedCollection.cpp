@@ -0,0 +1 @@
+#include "SemaphoreGuardedCollection.h"
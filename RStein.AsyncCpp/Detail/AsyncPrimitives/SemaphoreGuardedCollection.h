@@ -0,0 +1,146 @@
+#pragma once
+#include "ItemAddedListeners.h"
+#include "../../AsyncPrimitives/AsyncSemaphore.h"
+#include "../../AsyncPrimitives/CancellationToken.h"
+#include "../../AsyncPrimitives/IAsyncProducerConsumerCollection.h"
+#include "../../Tasks/TaskCombinators.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace RStein::AsyncCpp::Detail
+{
+  //Takes of the unbounded collection which has one semaphore permit for every item that can be taken.
+  //The derived collection (TDerived) keeps the items in its own order. It inserts the items under its lock, then calls publishItems,
+  //so every acquired permit has its item. TDerived::popMany(items, maxItems) takes up to maxItems items in the order of the collection.
+  template<typename TItem, typename TDerived>
+  class SemaphoreGuardedCollection : public RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TItem>
+  {
+  public:
+    SemaphoreGuardedCollection(const SemaphoreGuardedCollection& other) = delete;
+    SemaphoreGuardedCollection(SemaphoreGuardedCollection&& other) noexcept = delete;
+    SemaphoreGuardedCollection& operator=(const SemaphoreGuardedCollection& other) = delete;
+    SemaphoreGuardedCollection& operator=(SemaphoreGuardedCollection&& other) noexcept = delete;
+    virtual ~SemaphoreGuardedCollection() = default;
+
+    Tasks::Task<TItem> TakeAsync() override
+    {
+      return TakeAsync(RStein::AsyncCpp::AsyncPrimitives::CancellationToken::None());
+    }
+
+    Tasks::Task<TItem> TakeAsync(RStein::AsyncCpp::AsyncPrimitives::CancellationToken cancellationToken) override
+    {
+      co_await _asyncSemaphore.WaitAsync(cancellationToken);
+      std::vector<TItem> items;
+      if (popMany(items, 1) == 0)
+      {
+        throw std::logic_error("Could not take item");
+      }
+
+      co_return std::move(items.front());
+    }
+
+    Tasks::Task<std::size_t> TakeManyAsync(std::vector<TItem>& items,
+                                           std::size_t maxItems,
+                                           RStein::AsyncCpp::AsyncPrimitives::CancellationToken cancellationToken) override
+    {
+      if (maxItems == 0)
+      {
+        throw std::invalid_argument("maxItems");
+      }
+
+      //Available items are taken without the coroutine frame.
+      const auto takenCount = TryTakeMany(items, maxItems);
+      if (takenCount > 0)
+      {
+        return Tasks::TaskFromResult(takenCount);
+      }
+
+      return takeManyAsync(items, maxItems, std::move(cancellationToken));
+    }
+
+    std::vector<TItem> TryTakeAll() override
+    {
+      std::vector<TItem> items;
+      TryTakeMany(items, std::numeric_limits<std::size_t>::max());
+      return items;
+    }
+
+    std::size_t TryTakeMany(std::vector<TItem>& items, std::size_t maxItems) override
+    {
+      const auto maxCount = static_cast<int>(std::min<std::size_t>(maxItems, std::numeric_limits<int>::max()));
+      const auto acquiredCount = static_cast<std::size_t>(_asyncSemaphore.TryWaitMany(maxCount));
+      if (acquiredCount == 0)
+      {
+        return 0;
+      }
+
+      return popAcquired(items, acquiredCount);
+    }
+
+    void AddItemAddedListener(const std::shared_ptr<RStein::AsyncCpp::AsyncPrimitives::IItemAddedListener<TItem>>& listener) override
+    {
+      _itemAddedListeners.Add(listener);
+    }
+
+    void RemoveItemAddedListener(const std::shared_ptr<RStein::AsyncCpp::AsyncPrimitives::IItemAddedListener<TItem>>& listener) override
+    {
+      _itemAddedListeners.Remove(listener);
+    }
+
+  protected:
+    SemaphoreGuardedCollection() : RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TItem>(),
+                                   _asyncSemaphore{std::numeric_limits<int>::max(), 0},
+                                   _itemAddedListeners{}
+    {
+    }
+
+    //Releases the permits of the inserted items and notifies the listeners. Must not be called under the lock of the collection.
+    void publishItems(std::size_t itemsCount)
+    {
+      if (itemsCount == 0)
+      {
+        return;
+      }
+
+      for (std::size_t i = 0; i < itemsCount; i++)
+      {
+        _asyncSemaphore.Release();
+      }
+
+      _itemAddedListeners.Notify(*this);
+    }
+
+  private:
+    RStein::AsyncCpp::AsyncPrimitives::AsyncSemaphore _asyncSemaphore;
+    ItemAddedListeners<TItem> _itemAddedListeners;
+
+    std::size_t popMany(std::vector<TItem>& items, std::size_t maxItems)
+    {
+      return static_cast<TDerived&>(*this).popMany(items, maxItems);
+    }
+
+    std::size_t popAcquired(std::vector<TItem>& items, std::size_t acquiredCount)
+    {
+      const auto takenCount = popMany(items, acquiredCount);
+      assert(takenCount == acquiredCount);
+      return takenCount;
+    }
+
+    Tasks::Task<std::size_t> takeManyAsync(std::vector<TItem>& items,
+                                           std::size_t maxItems,
+                                           RStein::AsyncCpp::AsyncPrimitives::CancellationToken cancellationToken)
+    {
+      co_await _asyncSemaphore.WaitAsync(cancellationToken);
+      const auto maxCount = static_cast<int>(std::min<std::size_t>(maxItems - 1, std::numeric_limits<int>::max()));
+      const auto acquiredCount = 1 + static_cast<std::size_t>(_asyncSemaphore.TryWaitMany(maxCount));
+      co_return popAcquired(items, acquiredCount);
+    }
+  };
+}
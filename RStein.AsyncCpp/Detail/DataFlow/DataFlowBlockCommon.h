@@ -1,16 +1,28 @@
 ﻿#pragma once
+#include "../../DataFlow/DataFlowBlockOptions.h"
+#include "../../DataFlow/DataFlowLinkOptions.h"
 #include "../../DataFlow/IInputOutputBlock.h"
+#include "IFusibleInputBlock.h"
 #include "../../AsyncPrimitives/IAsyncProducerConsumerCollection.h"
+#include "../../AsyncPrimitives/CancellationTokenSource.h"
 #include "../../AsyncPrimitives/OperationCanceledException.h"
 #include "../../AsyncPrimitives/SimpleAsyncProducerConsumerCollection.h"
-#include "../../Collections/ThreadSafeMinimalisticVector.h"
+#include "../../AsyncPrimitives/SpscChannel.h"
 #include "../../AsyncPrimitives/FutureEx.h"
+#include "../../Schedulers/Scheduler.h"
 #include "../../DataFlow/IDataFlowBlock.h"
 #include "../../Tasks/TaskCombinators.h"
 #include "../../Utils/FinallyBlock.h"
-#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <limits>
+#include <optional>
 #include <memory>
+#include <mutex>
 #include <functional>
+#include <vector>
 
 namespace RStein::AsyncCpp::Detail
 {
@@ -28,6 +40,7 @@ namespace RStein::AsyncCpp::Detail
   };
   template<typename TInputItem, typename TOutputItem, typename TState = NoState>
   class DataFlowBlockCommon : public RStein::AsyncCpp::DataFlow::IInputOutputBlock<TInputItem, TOutputItem>,
+    public IFusibleInputBlock<TInputItem>,
     public std::enable_shared_from_this<DataFlowBlockCommon<TInputItem, TOutputItem, TState>>
   {
   public:
@@ -37,13 +50,35 @@ namespace RStein::AsyncCpp::Detail
     using AsyncActionFuncType = std::function<typename RStein::AsyncCpp::DataFlow::IInputBlock<TInputItem>::TaskVoidType(const TInputItem& inputItem, TState*& state)>;
     using TransformFuncType = std::function<TOutputItem(const TInputItem& inputItem, TState*& state)>;
     using AsyncTransformFuncType= std::function<typename RStein::AsyncCpp::DataFlow::IInputOutputBlock<TInputItem, TOutputItem>::TaskOutputItemType(const TInputItem& inputItem, TState*& state)>;
+    //Output sink delivers the output item to the linked blocks. Returned task completes when the propagation window has room for the next output item.
+    using OutputSinkFuncType = std::function<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType(TOutputItem outputItem)>;
+    //Transformation produces any number of output items (including none) and sends them to the output sink.
+    using AsyncTransformManyFuncType = std::function<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType(const TInputItem& inputItem, TState*& state, const OutputSinkFuncType& outputSink)>;
+    //Output batch sink delivers (moves) all output items in the vector in one call. The vector must stay alive until the returned task completes.
+    using OutputBatchSinkFuncType = std::function<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType(std::vector<TOutputItem>& outputItems)>;
+    //Transformation receives all input items waiting in the input queue (at most maxBatchSize items) and sends the output items to the output batch sink.
+    using AsyncTransformBatchFuncType = std::function<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType(const std::vector<TInputItem>& inputItems, TState*& state, const OutputBatchSinkFuncType& outputBatchSink)>;
+    //Called after the last input item has been processed. Sends the items buffered in the state to the output sink.
+    using AsyncFlushFuncType = std::function<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType(TState*& state, const OutputSinkFuncType& outputSink)>;
 
     using CanAcceptFuncType = std::function<bool(const TInputItem& item)>;
 
     using DataFlowBlockCommonPtr = std::shared_ptr<DataFlowBlockCommon<TInputItem, TOutputItem, TState>>;
 
-    explicit DataFlowBlockCommon(AsyncTransformFuncType transformFunc, CanAcceptFuncType canAcceptFunc = [] {return true;});
-    explicit DataFlowBlockCommon(TransformFuncType transformFunc, CanAcceptFuncType canAcceptFunc = [] {return true; });
+    explicit DataFlowBlockCommon(AsyncTransformFuncType transformFunc,
+                                 CanAcceptFuncType canAcceptFunc = [] {return true;},
+                                 RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options = RStein::AsyncCpp::DataFlow::DataFlowBlockOptions{});
+    explicit DataFlowBlockCommon(TransformFuncType transformFunc,
+                                 CanAcceptFuncType canAcceptFunc = [] {return true; },
+                                 RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options = RStein::AsyncCpp::DataFlow::DataFlowBlockOptions{});
+    explicit DataFlowBlockCommon(AsyncTransformManyFuncType transformFunc,
+                                 AsyncFlushFuncType flushFunc = AsyncFlushFuncType{},
+                                 CanAcceptFuncType canAcceptFunc = [] {return true; },
+                                 RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options = RStein::AsyncCpp::DataFlow::DataFlowBlockOptions{});
+    explicit DataFlowBlockCommon(AsyncTransformBatchFuncType transformFunc,
+                                 std::size_t maxBatchSize,
+                                 CanAcceptFuncType canAcceptFunc = [] {return true; },
+                                 RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options = RStein::AsyncCpp::DataFlow::DataFlowBlockOptions{});
     DataFlowBlockCommon(const DataFlowBlockCommon& other) = delete;
     DataFlowBlockCommon(DataFlowBlockCommon&& other) = delete;
     DataFlowBlockCommon& operator=(const DataFlowBlockCommon& other) = delete;
@@ -53,14 +88,35 @@ namespace RStein::AsyncCpp::Detail
     [[nodiscard]] RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType Completion() const override;
     void Start() override;
     void Complete() override;
+    RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType CompleteAsync() override;
     void SetFaulted(std::exception_ptr exception) override;
     bool CanAcceptInput(const TInputItem& item) override;
+    //Returns true when the block is started, the canAcceptFunc is not called.
+    //Composite blocks use the method when they do not have the input item of the inner block yet.
+    [[nodiscard]] bool IsAcceptingInput() const;
     RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType AcceptInputAsync(const TInputItem& item) override;
     RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType AcceptInputAsync(TInputItem&& item) override;
+    [[nodiscard]] std::size_t PendingInputCount() const override;
+    //Sets the function which the processing loop runs after the Signal call, between the input items. Must be called before the block starts.
+    //Use for control events (timeouts) which must not pass through the input queue.
+    void SignalFunc(AsyncFlushFuncType signalFunc);
+    //Wakes up the processing loop, which runs the signal function. Signals received before the signal function runs are coalesced.
+    void Signal();
+    //Replaces the input queue of the block (for example with a priority collection). Must be called before the block starts.
+    //The block with the replaced input queue takes one input item at a time and is not fused with its predecessor.
+    void InputItems(std::unique_ptr<RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TInputItem>> inputItems);
+    void AddPredecessor() override;
+    bool TryFuseWithPredecessor() override;
+    void UnfuseFromPredecessor() override;
+    [[nodiscard]] bool IsFusedWithPredecessor() const override;
+    std::optional<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType> AcceptFusedInput(const TInputItem& item) override;
     void ConnectTo(const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock) override;
+    void ConnectTo(const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                   const RStein::AsyncCpp::DataFlow::DataFlowLinkOptions<TOutputItem>& linkOptions) override;
+    //Removes the links to the nextBlock. The block can be disconnected while this block is running, items already being delivered are still delivered.
+    //The disconnected block is not completed together with this block.
+    void DisconnectFrom(const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock);
     virtual ~DataFlowBlockCommon();
-    void removeDeadOutputNodes();
-    typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType propagateOutput(TOutputItem outputItem);
 
   private:
     enum class BlockState
@@ -71,28 +127,138 @@ namespace RStein::AsyncCpp::Detail
       Stopping,
       Stopped
     };
+
+    using OutputBlockPtr = typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr;
+
+    struct OutputLink
+    {
+      OutputBlockPtr Node;
+      RStein::AsyncCpp::Schedulers::Scheduler::SchedulerPtr TaskScheduler;
+    };
+
+    //Immutable list of the linked blocks. ConnectTo replaces the whole list (copy on write),
+    //so the processing loop can use the list without locks and without copying it.
+    struct OutputLinks
+    {
+      //Broadcast links without the scheduler precede the links with the scheduler.
+      std::vector<OutputLink> BroadcastLinks;
+      std::size_t UnscheduledBroadcastLinksCount = 0;
+      std::vector<OutputLink> PartitionedLinks;
+      RStein::AsyncCpp::DataFlow::DataFlowLinkOptions<TOutputItem> PartitionedLinksOptions;
+
+      [[nodiscard]] bool IsEmpty() const
+      {
+        return BroadcastLinks.empty() && PartitionedLinks.empty();
+      }
+
+      template<typename TFunc>
+      void ForEachNode(TFunc&& func) const
+      {
+        for (auto& link : BroadcastLinks)
+        {
+          func(link.Node);
+        }
+
+        for (auto& link : PartitionedLinks)
+        {
+          func(link.Node);
+        }
+      }
+    };
+
+    using OutputLinksPtr = std::shared_ptr<const OutputLinks>;
+
+    static constexpr std::size_t MAX_TAKEN_INPUT_ITEMS = 64;
+
     bool _isAsyncNode;
     TransformFuncType _transformSyncFunc;
     AsyncTransformFuncType _transformAsyncFunc;
+    AsyncTransformManyFuncType _transformManyAsyncFunc;
+    AsyncTransformBatchFuncType _transformBatchAsyncFunc;
+    AsyncFlushFuncType _flushAsyncFunc;
+    AsyncFlushFuncType _signalAsyncFunc;
+    std::size_t _maxBatchSize;
     std::function<bool(const TInputItem&)> _canAcceptFunc;;
+    RStein::AsyncCpp::DataFlow::DataFlowBlockOptions _options;
     std::string _name;
     typename DataFlowBlockCommon::PromiseVoidType _completedTaskPromise;
     typename DataFlowBlockCommon::TaskVoidType _completedTask;
     typename DataFlowBlockCommon::PromiseVoidType _startTaskPromise;
     typename DataFlowBlockCommon::TaskVoidType _startTask;
     typename DataFlowBlockCommon::TaskVoidType _processingTask;
-    BlockState _state;
+    //Written under the _stateMutex, read without the lock by CanAcceptInput and AcceptInputAsync.
+    std::atomic<BlockState> _state;
     std::mutex _stateMutex;
-    RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TInputItem> _inputItems;
+    std::unique_ptr<RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TInputItem>> _inputItems;
+    bool _hasCustomInputItems;
     RStein::AsyncCpp::AsyncPrimitives::CancellationTokenSource _processingCts;
-    RStein::AsyncCpp::Collections::ThreadSafeMinimalisticVector<std::weak_ptr<RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>>> _outputNodes;
+    std::mutex _outputLinksMutex;
+    OutputLinksPtr _outputLinks;
+    std::atomic<unsigned long> _outputLinksVersion;
     int _startCallsCount;
+    std::atomic<std::size_t> _pendingInputCount;
+    //Used only by the processing loop.
+    OutputLinksPtr _processingOutputLinks;
+    unsigned long _processingOutputLinksVersion;
+    std::size_t _nextRoundRobinIndex;
+    std::deque<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> _pendingPropagations;
+    std::vector<TInputItem> _inputBatch;
+    TState _transformState;
+    TState* _transformStatePtr;
+    std::atomic<int> _predecessorsCount;
+    std::atomic<bool> _isFused;
+    bool _hasSpscInputItems;
+    std::atomic<bool> _isAddingSpscInputItem;
+    std::shared_ptr<IFusibleInputBlock<TOutputItem>> _fusedOutputNode;
+    unsigned long _fusedOutputLinksVersion;
+    //AcceptFusedInput processes the item under the lock. The processing loop of the unfused block takes the lock once,
+    //so it does not process its input items while the predecessor is still in the AcceptFusedInput call.
+    std::mutex _fusedInputMutex;
+    std::atomic<bool> _hasFusedPredecessor;
+    //Signal cancels the wake-up token of the pending take, the processing loop replaces the canceled token.
+    std::mutex _signalMutex;
+    std::atomic<bool> _isSignaled;
+    RStein::AsyncCpp::AsyncPrimitives::CancellationTokenSource _wakeUpCts;
 
-    explicit DataFlowBlockCommon(CanAcceptFuncType canAcceptFunc);
+    DataFlowBlockCommon(CanAcceptFuncType canAcceptFunc, RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options);
     typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType runProcessingTask(
         RStein::AsyncCpp::AsyncPrimitives::CancellationToken cancellationToken);
+    std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> propagateOutputInWindow(TOutputItem& outputItem);
+    std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> deliverOutput(TOutputItem& outputItem);
+    typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType deliverOutputBatch(std::vector<TOutputItem>& outputItems);
+    typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType deliverOutputBatchAsync(std::vector<TOutputItem>& outputItems,
+                                                                                                        std::size_t nextOutputItemIndex,
+                                                                                                        typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType pendingDelivery);
+    typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType propagateOutputAfterWindowAsync(OutputLinksPtr outputLinks, TOutputItem outputItem);
+    void removeCompletedPropagations();
+    std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> processFusedInput(const TInputItem& item);
+    void waitForFusedInputEnd();
+    typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType faultOnFailedFusedDeliveryAsync(typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType delivery);
+    bool canAcceptStartedInput(const TInputItem& item);
+    std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> tryPropagateOutputSync(const OutputLinksPtr& outputLinks, TOutputItem& outputItem);
+    typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType propagateOutputAsync(OutputLinksPtr outputLinks,
+                                                                                                      TOutputItem outputItem,
+                                                                                                      std::size_t firstDeliveryIndex,
+                                                                                                      const OutputLink* partitionedLink,
+                                                                                                      std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> pendingDelivery);
+    static const OutputLink& getDeliveryLink(const OutputLinks& outputLinks, const OutputLink* partitionedLink, std::size_t deliveryIndex);
+    const OutputLink* selectPartitionedOutputLink(const OutputLinks& outputLinks, const TOutputItem& outputItem);
+    [[nodiscard]] bool hasDefaultOptions() const;
+    [[nodiscard]] static bool isRunningInScheduler(const RStein::AsyncCpp::Schedulers::Scheduler::SchedulerPtr& scheduler);
+    void tryFuseWithOutputNode();
+    IFusibleInputBlock<TOutputItem>* getFusedOutputNode();
+    OutputLinksPtr getOutputLinks();
+    const OutputLinksPtr& getProcessingOutputLinks();
     void completeCommon(std::exception_ptr exceptionPtr);
+    bool tryStartCompletion(std::exception_ptr exceptionPtr);
+    static typename DataFlowBlockCommon::TaskVoidType finishCompletionAsync(DataFlowBlockCommonPtr sharedThis);
     void throwIfNotStarted();
+    void wakeUpProcessingLoop();
+    void resetSignal(const RStein::AsyncCpp::AsyncPrimitives::CancellationToken& processingCancellationToken);
+    template <typename TUInputItem>
+    typename DataFlowBlockCommon::TaskVoidType addInputItem(TUInputItem&& item);
+    typename DataFlowBlockCommon::TaskVoidType awaitSpscAddAsync(typename DataFlowBlockCommon::TaskVoidType addTask);
+    void endSpscAdd();
 
 
 
@@ -100,7 +266,8 @@ namespace RStein::AsyncCpp::Detail
 
   template <typename TInputItem, typename TOutputItem, typename TState>
   DataFlowBlockCommon<TInputItem, TOutputItem, TState>::DataFlowBlockCommon(AsyncTransformFuncType transformFunc,
-                                                                            CanAcceptFuncType canAcceptFunc) : DataFlowBlockCommon(std::move(canAcceptFunc))
+                                                                            CanAcceptFuncType canAcceptFunc,
+                                                                            RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options) : DataFlowBlockCommon(std::move(canAcceptFunc), std::move(options))
   
   {
     if (!transformFunc)
@@ -114,7 +281,8 @@ namespace RStein::AsyncCpp::Detail
   }
   template <typename TInputItem, typename TOutputItem, typename TState>
   DataFlowBlockCommon<TInputItem, TOutputItem, TState>::DataFlowBlockCommon(TransformFuncType transformFunc,
-                                                                            CanAcceptFuncType canAcceptFunc) : DataFlowBlockCommon(std:: move(canAcceptFunc))
+                                                                            CanAcceptFuncType canAcceptFunc,
+                                                                            RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options) : DataFlowBlockCommon(std:: move(canAcceptFunc), std::move(options))
   
   {
     if (!transformFunc)
@@ -127,15 +295,63 @@ namespace RStein::AsyncCpp::Detail
 
   }
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  DataFlowBlockCommon<TInputItem, TOutputItem, TState>::DataFlowBlockCommon(AsyncTransformManyFuncType transformFunc,
+                                                                            AsyncFlushFuncType flushFunc,
+                                                                            CanAcceptFuncType canAcceptFunc,
+                                                                            RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options) : DataFlowBlockCommon(std::move(canAcceptFunc), std::move(options))
+  
+  {
+    if (!transformFunc)
+    {
+      throw std::invalid_argument("transformFunc");
+    }
+
+    _isAsyncNode = true;
+    _transformManyAsyncFunc = transformFunc;
+    _flushAsyncFunc = flushFunc;
+
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  DataFlowBlockCommon<TInputItem, TOutputItem, TState>::DataFlowBlockCommon(AsyncTransformBatchFuncType transformFunc,
+                                                                            std::size_t maxBatchSize,
+                                                                            CanAcceptFuncType canAcceptFunc,
+                                                                            RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options) : DataFlowBlockCommon(std::move(canAcceptFunc), std::move(options))
+  
+  {
+    if (!transformFunc)
+    {
+      throw std::invalid_argument("transformFunc");
+    }
+
+    if (maxBatchSize == 0)
+    {
+      throw std::invalid_argument("maxBatchSize");
+    }
+
+    _isAsyncNode = true;
+    _transformBatchAsyncFunc = transformFunc;
+    _maxBatchSize = maxBatchSize;
+    _inputBatch.reserve(maxBatchSize);
+  }
+
   
   template <typename TInputItem, typename TOutputItem, typename TState>
-  DataFlowBlockCommon<TInputItem, TOutputItem, TState>::DataFlowBlockCommon(CanAcceptFuncType canAcceptFunc) :
+  DataFlowBlockCommon<TInputItem, TOutputItem, TState>::DataFlowBlockCommon(CanAcceptFuncType canAcceptFunc,
+                                                                            RStein::AsyncCpp::DataFlow::DataFlowBlockOptions options) :
                                                                             RStein::AsyncCpp::DataFlow::IInputOutputBlock<TInputItem, TOutputItem>{},
                                                                             std::enable_shared_from_this<DataFlowBlockCommon<TInputItem, TOutputItem, TState>>{},
                                                                             _isAsyncNode(),
                                                                             _transformSyncFunc{},
                                                                             _transformAsyncFunc{},
+                                                                            _transformManyAsyncFunc{},
+                                                                            _transformBatchAsyncFunc{},
+                                                                            _flushAsyncFunc{},
+                                                                            _signalAsyncFunc{},
+                                                                            _maxBatchSize{1},
                                                                             _canAcceptFunc{std::move(canAcceptFunc)},
+                                                                            _options{std::move(options)},
                                                                             _name{},
                                                                             _completedTaskPromise{},
                                                                             _completedTask{ _completedTaskPromise.GetTask()},
@@ -144,15 +360,47 @@ namespace RStein::AsyncCpp::Detail
                                                                             _processingTask{RStein::AsyncCpp::Tasks::GetCompletedTask()},
                                                                             _state{ BlockState::Created },
                                                                             _stateMutex{},
-                                                                            _inputItems{},
+                                                                            _inputItems{std::make_unique<RStein::AsyncCpp::AsyncPrimitives::SimpleAsyncProducerConsumerCollection<TInputItem>>()},
+                                                                            _hasCustomInputItems{false},
                                                                             _processingCts{RStein::AsyncCpp::AsyncPrimitives::CancellationTokenSource{}},
-                                                                            _outputNodes{ std::vector<std::weak_ptr<RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>>>{}},
-                                                                            _startCallsCount{}
+                                                                            _outputLinksMutex{},
+                                                                            _outputLinks{std::make_shared<OutputLinks>()},
+                                                                            _outputLinksVersion{},
+                                                                            _startCallsCount{},
+                                                                            _pendingInputCount{},
+                                                                            _processingOutputLinks{_outputLinks},
+                                                                            _processingOutputLinksVersion{},
+                                                                            _nextRoundRobinIndex{},
+                                                                            _pendingPropagations{},
+                                                                            _inputBatch{},
+                                                                            _transformState{},
+                                                                            _transformStatePtr{&_transformState},
+                                                                            _predecessorsCount{},
+                                                                            _isFused{false},
+                                                                            _hasSpscInputItems{false},
+                                                                            _isAddingSpscInputItem{false},
+                                                                            _fusedOutputNode{},
+                                                                            _fusedOutputLinksVersion{},
+                                                                            _fusedInputMutex{},
+                                                                            _hasFusedPredecessor{false},
+                                                                            _signalMutex{},
+                                                                            _isSignaled{false},
+                                                                            _wakeUpCts{}
   {
     if (!_canAcceptFunc)
     {
       _canAcceptFunc = [](auto _) {return true; };
     }
+
+    if (_options.MaxPropagationWindow == 0)
+    {
+      throw std::invalid_argument("options.MaxPropagationWindow");
+    }
+
+    if (_options.UseSpscInputForSinglePredecessor && _options.SpscInputCapacity == 0)
+    {
+      throw std::invalid_argument("options.SpscInputCapacity");
+    }
   }
 
 
@@ -191,20 +439,35 @@ namespace RStein::AsyncCpp::Detail
       throw std::logic_error("Could not start node!");
     }
 
-    _processingTask = runProcessingTask(_processingCts.Token());
+    //No item can be accepted before the block starts, so the input queue can be replaced.
+    if (_options.UseSpscInputForSinglePredecessor && !_hasCustomInputItems && _predecessorsCount.load() == 1)
+    {
+      _inputItems = std::make_unique<RStein::AsyncCpp::AsyncPrimitives::SpscChannel<TInputItem>>(_options.SpscInputCapacity);
+      _hasSpscInputItems = true;
+    }
 
-    for (auto& nextBlock : _outputNodes.MapSnapshot<RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr>([](auto &weakPtr){return weakPtr.lock();}))
+    _processingTask = runProcessingTask(_processingCts.Token());
+    //Failed transformation or failed delivery of the output item faults the block.
+    //The continuation runs after the processing task has completed, so SetFaulted does not wait for the running processing task.
+    _processingTask.ContinueWith([weakThis = this->weak_from_this()](const auto& processingTask)
     {
-      
-      if (!nextBlock)
-      {    
-        continue;;
+      if (!processingTask.IsFaulted())
+      {
+        return;
+      }
+
+      if (auto sharedThis = weakThis.lock())
+      {
+        sharedThis->SetFaulted(processingTask.Exception());
       }
+    });
 
+    getOutputLinks()->ForEachNode([](auto& nextBlock)
+    {
       nextBlock->Start();
-    }
+    });
 
-    removeDeadOutputNodes();
+    tryFuseWithOutputNode();
     _state = BlockState::Started;
     
     _startTaskPromise.SetResult();
@@ -217,6 +480,23 @@ namespace RStein::AsyncCpp::Detail
     completeCommon(nullptr);
   }
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType DataFlowBlockCommon<TInputItem, TOutputItem, TState>::CompleteAsync()
+  {
+    {
+      std::lock_guard lock{ _stateMutex };
+      if (!tryStartCompletion(nullptr))
+      {
+        return _completedTask;
+      }
+    }
+
+    //The processing loop drains the input items, the block completes in the continuation of the loop.
+    _processingCts.Cancel();
+    finishCompletionAsync(this->shared_from_this());
+    return _completedTask;
+  }
+
   template <typename TInputItem, typename TOutputItem, typename TState>
   void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::SetFaulted(std::exception_ptr exception)
   {
@@ -227,13 +507,22 @@ namespace RStein::AsyncCpp::Detail
   template <typename TInputItem, typename TOutputItem, typename TState>
   bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::CanAcceptInput(const TInputItem& item)
   {
-    //Avoid lock
+    //Fused block accepts the input item too, the input item unfuses the block (addInputItem).
+    return canAcceptStartedInput(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::IsAcceptingInput() const
+  {
+    return _state.load(std::memory_order_acquire) == BlockState::Started;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::canAcceptStartedInput(const TInputItem& item)
+  {
+    if (_state.load(std::memory_order_acquire) != BlockState::Started)
     {
-      std::lock_guard lock{ _stateMutex };
-      if (_state != BlockState::Started)
-      {
-        return false;
-      }
+      return false;
     }
 
     return _canAcceptFunc(item);
@@ -242,8 +531,7 @@ namespace RStein::AsyncCpp::Detail
   template <typename TInputItem, typename TOutputItem, typename TState>
   void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::throwIfNotStarted()
   {
-    std::lock_guard lock{ _stateMutex };
-    if (_state != BlockState::Started)
+    if (_state.load(std::memory_order_acquire) != BlockState::Started)
     {
       throw std::logic_error("Node does not running");
     }
@@ -253,9 +541,7 @@ namespace RStein::AsyncCpp::Detail
   RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType DataFlowBlockCommon<
     TInputItem, TOutputItem, TState>::AcceptInputAsync(const TInputItem& item)
   {
-    //TODO: Avoid lock
-    throwIfNotStarted();
-    return _inputItems.AddAsync(item);
+    return addInputItem(item);
   }
 
   template <typename TInputItem, typename TOutputItem, typename TState>
@@ -263,190 +549,1102 @@ namespace RStein::AsyncCpp::Detail
                                                                                TOutputItem, TState>::AcceptInputAsync(
       TInputItem&& item)
   {
-    //TODO: Avoid lock
-    throwIfNotStarted();
-    return _inputItems.AddAsync(item);
+    return addInputItem(std::move(item));
   }
 
   template <typename TInputItem, typename TOutputItem, typename TState>
-  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::ConnectTo(const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
+  template <typename TUInputItem>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<TInputItem, TOutputItem, TState>::addInputItem(TUInputItem&& item)
   {
-    if (!nextBlock)
+    throwIfNotStarted();
+    //The item is counted before the processing loop can take it (and decrement the count), the count is returned when the add fails.
+    ++_pendingInputCount;
+    //Input item from another producer unfuses the block, the predecessor delivers its next items through the input queue too.
+    //TryFuseWithPredecessor sets the flag before it checks the count, so either the block is not fused or the block is unfused here.
+    //The processing loop does not process the item until the running AcceptFusedInput call has ended (waitForFusedInputEnd).
+    _isFused.store(false);
+
+    //Single-producer input queue is corrupted by concurrent producers, the add which overlaps the pending add is rejected.
+    if (_hasSpscInputItems && _isAddingSpscInputItem.exchange(true, std::memory_order_acquire))
     {
-      throw std::invalid_argument("nextBlock");
+      --_pendingInputCount;
+      throw std::logic_error("Block with the single-producer input queue accepts one input item at a time.");
+    }
+
+    auto addTask = [this, &item]
+    {
+      try
+      {
+        return _inputItems->AddAsync(std::forward<TUInputItem>(item));
+      }
+      catch (...)
+      {
+        --_pendingInputCount;
+        endSpscAdd();
+        throw;
+      }
+    }();
+
+    if (addTask.IsCompleted())
+    {
+      if (addTask.IsFaulted() || addTask.IsCanceled())
+      {
+        --_pendingInputCount;
+      }
+
+      endSpscAdd();
+      return addTask;
+    }
+
+    if (_hasSpscInputItems)
+    {
+      //The producer may add the next item only after the pending add has ended.
+      return awaitSpscAddAsync(std::move(addTask));
     }
 
-    _outputNodes.Add(nextBlock);
+    //Producer waits for the room in the bounded input queue.
+    addTask.ContinueWith([weakThis = this->weak_from_this()](const auto& completedAddTask)
+    {
+      if (!completedAddTask.IsFaulted() && !completedAddTask.IsCanceled())
+      {
+        return;
+      }
+
+      if (auto sharedThis = weakThis.lock())
+      {
+        --sharedThis->_pendingInputCount;
+      }
+    });
+
+    return addTask;
   }
 
   template <typename TInputItem, typename TOutputItem, typename TState>
-  DataFlowBlockCommon<TInputItem, TOutputItem, TState>::~DataFlowBlockCommon()
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::awaitSpscAddAsync(typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType addTask)
+  {
+    RStein::Utils::FinallyBlock finally
+    {
+      [this]
+      {
+        endSpscAdd();
+      }
+    };
+
+    try
+    {
+      co_await addTask;
+    }
+    catch (...)
+    {
+      --_pendingInputCount;
+      throw;
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::endSpscAdd()
   {
+    if (_hasSpscInputItems)
+    {
+      _isAddingSpscInputItem.store(false, std::memory_order_release);
+    }
+  }
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::size_t DataFlowBlockCommon<TInputItem, TOutputItem, TState>::PendingInputCount() const
+  {
+    return _pendingInputCount.load();
   }
 
   template <typename TInputItem, typename TOutputItem, typename TState>
-  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::removeDeadOutputNodes()
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::ConnectTo(const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
   {
-    _outputNodes.RemoveIf([](std::weak_ptr<RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>> weakPtr){return !weakPtr.lock();});
+    ConnectTo(nextBlock, RStein::AsyncCpp::DataFlow::DataFlowLinkOptions<TOutputItem>::Broadcast());
   }
 
   template <typename TInputItem, typename TOutputItem, typename TState>
-  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
-    TInputItem, TOutputItem, TState>::propagateOutput(TOutputItem outputItem)
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::ConnectTo(const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock,
+                                                                       const RStein::AsyncCpp::DataFlow::DataFlowLinkOptions<TOutputItem>& linkOptions)
   {
-    auto outputNodesSnapshot = _outputNodes.MapSnapshot<RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr>([](auto& weakPtr){return weakPtr.lock();});
-    
-    //Todo: Do not copy nodes
-    //TODO: Optimize cycle
-    //
-    auto shouldRemoveDeadBlocks = false;
-    for (auto nodeIterator = outputNodesSnapshot.begin(); nodeIterator != outputNodesSnapshot.end(); ++nodeIterator)
+    using RStein::AsyncCpp::DataFlow::DataFlowLinkMode;
+    if (!nextBlock)
+    {
+      throw std::invalid_argument("nextBlock");
+    }
+
+    if (linkOptions.Mode == DataFlowLinkMode::HashPartitioned && !linkOptions.KeySelector)
+    {
+      throw std::invalid_argument("linkOptions.KeySelector");
+    }
+
+    std::lock_guard lock{_outputLinksMutex};
+    auto outputLinks = std::make_shared<OutputLinks>(*_outputLinks);
+    if (linkOptions.Mode == DataFlowLinkMode::Broadcast)
     {
-      auto inputNodePtr = *nodeIterator;
-      if (!inputNodePtr)
+      auto& broadcastLinks = outputLinks->BroadcastLinks;
+      if (linkOptions.TaskScheduler)
       {
-        shouldRemoveDeadBlocks = true;
-        continue;
+        broadcastLinks.push_back(OutputLink{nextBlock, linkOptions.TaskScheduler});
       }
-
-      if (!inputNodePtr->CanAcceptInput(outputItem))
+      else
       {
-
-        *nodeIterator = RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr();
+        broadcastLinks.insert(broadcastLinks.begin() + outputLinks->UnscheduledBroadcastLinksCount, OutputLink{nextBlock, linkOptions.TaskScheduler});
+        ++outputLinks->UnscheduledBroadcastLinksCount;
       }
     }
-
-    if(shouldRemoveDeadBlocks)
+    else
     {
-      removeDeadOutputNodes();
+      if (outputLinks->PartitionedLinks.empty())
+      {
+        outputLinks->PartitionedLinksOptions = linkOptions;
+      }
+      else if (outputLinks->PartitionedLinksOptions.Mode != linkOptions.Mode)
+      {
+        throw std::logic_error("All partitioned links of the block must use the same link mode.");
+      }
+
+      outputLinks->PartitionedLinks.push_back(OutputLink{nextBlock, linkOptions.TaskScheduler});
     }
 
-    for (auto& node : outputNodesSnapshot)
+    _outputLinks = std::move(outputLinks);
+    ++_outputLinksVersion;
+    if (auto fusibleBlock = std::dynamic_pointer_cast<IFusibleInputBlock<TOutputItem>>(nextBlock))
     {
-      if (node)
-      {
-        co_await node->AcceptInputAsync(outputItem);
-      }
+      fusibleBlock->AddPredecessor();
     }
   }
 
   template <typename TInputItem, typename TOutputItem, typename TState>
-  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
-    TInputItem, TOutputItem, TState>::runProcessingTask(
-      RStein::AsyncCpp::AsyncPrimitives::CancellationToken cancellationToken)
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::SignalFunc(AsyncFlushFuncType signalFunc)
   {
-    //TODO: Use Scheduler   
-    try
+    if (!signalFunc)
     {
-      TState state{};
-      auto statePtr = &state;     
-      co_await _startTask;
-      TInputItem inputItem;
-      while (!cancellationToken.IsCancellationRequested())
-      {
-        try
-        {
-          inputItem = co_await _inputItems.TakeAsync(cancellationToken);
-        }
-        catch (RStein::AsyncCpp::AsyncPrimitives::OperationCanceledException&)
-        {
-          continue;
-        }
-
-        auto outputItem = _isAsyncNode
-          ? co_await _transformAsyncFunc(inputItem, statePtr)
-          : _transformSyncFunc(inputItem, statePtr);
+      throw std::invalid_argument("signalFunc");
+    }
 
-        propagateOutput(outputItem);
-      }
+    std::lock_guard lock{ _stateMutex };
+    if (_state != BlockState::Created)
+    {
+      throw std::logic_error("Could not set signal function of the started node!");
+    }
 
-      //refactor cycle
-      auto toProcessInputItems = _inputItems.TryTakeAll();
-      for (auto& item : toProcessInputItems)
-      {
-        auto outputRemainingItem = _isAsyncNode
-          ? co_await _transformAsyncFunc(item, statePtr)
-          : _transformSyncFunc(item, statePtr);
+    _signalAsyncFunc = std::move(signalFunc);
+  }
 
-        propagateOutput(outputRemainingItem);
-      }
-    }
-    catch (const std::exception& ex)
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::Signal()
+  {
+    RStein::AsyncCpp::AsyncPrimitives::CancellationTokenSource wakeUpCts{};
     {
-      const auto message = " DataFlow node: " + Name() + " - processing task failed with exception: \n " + ex.what();
-      std::cout << message;
-      const auto exceptionPtr = std::current_exception();
-      //TODO: Schedule call
-      auto callCompleteThread = std::thread{
-          [sharedThis = this->shared_from_this(), exceptionPtr]
-          {
-            sharedThis->SetFaulted(exceptionPtr);
-          }
-      };
-      callCompleteThread.detach();
-      throw;
+      std::lock_guard lock{_signalMutex};
+      _isSignaled = true;
+      wakeUpCts = _wakeUpCts;
     }
-  }
 
+    wakeUpCts.Cancel();
+  }
 
   template <typename TInputItem, typename TOutputItem, typename TState>
-  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::completeCommon(std::exception_ptr exceptionPtr)
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::wakeUpProcessingLoop()
   {
-    if (--_startCallsCount > 0 && exceptionPtr == nullptr)
+    RStein::AsyncCpp::AsyncPrimitives::CancellationTokenSource wakeUpCts{};
     {
-      return;
+      std::lock_guard lock{_signalMutex};
+      wakeUpCts = _wakeUpCts;
     }
 
-    if (_state == BlockState::Created)
+    wakeUpCts.Cancel();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::resetSignal(const RStein::AsyncCpp::AsyncPrimitives::CancellationToken& processingCancellationToken)
+  {
+    std::lock_guard lock{_signalMutex};
+    _isSignaled = false;
+    _wakeUpCts = RStein::AsyncCpp::AsyncPrimitives::CancellationTokenSource{};
+    //Completion of the block must not wait for the next signal.
+    if (processingCancellationToken.IsCancellationRequested())
     {
-      throw std::logic_error("Could not stop node.");
+      _wakeUpCts.Cancel();
     }
+  }
 
-    if (_state == BlockState::Stopped)
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::InputItems(std::unique_ptr<RStein::AsyncCpp::AsyncPrimitives::IAsyncProducerConsumerCollection<TInputItem>> inputItems)
+  {
+    if (!inputItems)
     {
-      return;
+      throw std::invalid_argument("inputItems");
     }
 
-    _state = BlockState::Stopping;
-    RStein::Utils::FinallyBlock finally
+    std::lock_guard lock{ _stateMutex };
+    if (_state != BlockState::Created)
     {
-        [this, isExceptional = exceptionPtr != nullptr, exceptionPtr = exceptionPtr]
-        {
-          _state = BlockState::Stopped;
+      throw std::logic_error("Could not replace input items of the started node!");
+    }
 
-          for (auto& nextBlock : _outputNodes.MapSnapshot<RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr>([](auto &weakPtr){return weakPtr.lock();}))
-          {
-            //TODO: Handle failing output node;
-            if (!nextBlock)
-            {
-              continue;
-            }
+    _inputItems = std::move(inputItems);
+    _hasCustomInputItems = true;
+  }
 
-            if (isExceptional)
-            {
-              nextBlock->SetFaulted(exceptionPtr);
-            }
-            else
-            {
-              nextBlock->Complete();
-            }
-          }
-        }
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::DisconnectFrom(const typename RStein::AsyncCpp::DataFlow::IInputBlock<TOutputItem>::InputBlockPtr& nextBlock)
+  {
+    if (!nextBlock)
+    {
+      throw std::invalid_argument("nextBlock");
+    }
+
+    const auto isNextBlockLink = [&nextBlock](const OutputLink& link)
+    {
+      return link.Node == nextBlock;
     };
 
+    std::lock_guard lock{_outputLinksMutex};
+    auto outputLinks = std::make_shared<OutputLinks>(*_outputLinks);
+    const auto removedLinksCount = std::erase_if(outputLinks->BroadcastLinks, isNextBlockLink) + std::erase_if(outputLinks->PartitionedLinks, isNextBlockLink);
+    if (removedLinksCount == 0)
+    {
+      return;
+    }
 
-      _processingCts.Cancel();
-      _processingTask.Wait();
-      if (exceptionPtr != nullptr)
-      {
-        _completedTaskPromise.TrySetException(exceptionPtr);
-      }
-      else
-      {
-        _completedTaskPromise.TrySetResult();
-      }   
+    outputLinks->UnscheduledBroadcastLinksCount = std::count_if(outputLinks->BroadcastLinks.begin(), outputLinks->BroadcastLinks.end(), [](const OutputLink& link)
+    {
+      return !link.TaskScheduler;
+    });
+
+    _outputLinks = std::move(outputLinks);
+    ++_outputLinksVersion;
   }
-}
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::AddPredecessor()
+  {
+    //Block linked to another predecessor after the start must accept the items of the new predecessor through its input queue.
+    if (++_predecessorsCount > 1)
+    {
+      _isFused.store(false);
+    }
+  }
 
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TryFuseWithPredecessor()
+  {
+    if (_isAsyncNode || !hasDefaultOptions() || _hasCustomInputItems || _predecessorsCount.load() != 1)
+    {
+      return false;
+    }
+
+    //Set before the fusion, the processing loop then waits for the end of the running AcceptFusedInput call when the block is unfused.
+    _hasFusedPredecessor = true;
+    auto isFused = false;
+    if (!_isFused.compare_exchange_strong(isFused, true))
+    {
+      return false;
+    }
+
+    //Input items added before the fusion are processed by the processing loop of this block.
+    if (_pendingInputCount.load() != 0)
+    {
+      _isFused = false;
+      return false;
+    }
+
+    return true;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::UnfuseFromPredecessor()
+  {
+    _isFused = false;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::IsFusedWithPredecessor() const
+  {
+    return _isFused.load();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::optional<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType> DataFlowBlockCommon<TInputItem, TOutputItem, TState>::AcceptFusedInput(const TInputItem& item)
+  {
+    std::exception_ptr exceptionPtr{};
+    {
+      std::lock_guard lock{_fusedInputMutex};
+      if (_isFused.load())
+      {
+        //Same rules as the propagation to the linked block - the block skips the item which it does not accept.
+        if (!canAcceptStartedInput(item))
+        {
+          return std::nullopt;
+        }
+
+        try
+        {
+          return processFusedInput(item);
+        }
+        catch (...)
+        {
+          exceptionPtr = std::current_exception();
+        }
+      }
+    }
+
+    if (exceptionPtr != nullptr)
+    {
+      //Failed transformation or failed delivery of the output item faults only this block, the processing loop of the predecessor continues.
+      //SetFaulted waits for the processing loop, which may wait for the _fusedInputMutex.
+      SetFaulted(exceptionPtr);
+      return std::nullopt;
+    }
+
+    //The block has been unfused since the predecessor selected the fused delivery.
+    if (!CanAcceptInput(item))
+    {
+      return std::nullopt;
+    }
+
+    return AcceptInputAsync(item);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::processFusedInput(const TInputItem& item)
+  {
+    auto outputItem = _transformSyncFunc(item, _transformStatePtr);
+    if (auto* fusedOutputNode = getFusedOutputNode())
+    {
+      return fusedOutputNode->AcceptFusedInput(outputItem);
+    }
+
+    const auto& outputLinks = getProcessingOutputLinks();
+    if (outputLinks->IsEmpty())
+    {
+      return std::nullopt;
+    }
+
+    auto delivery = tryPropagateOutputSync(outputLinks, outputItem);
+    if (!delivery)
+    {
+      return std::nullopt;
+    }
+
+    return faultOnFailedFusedDeliveryAsync(std::move(*delivery));
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::waitForFusedInputEnd()
+  {
+    //The block is unfused when its processing loop has an input item, the next AcceptFusedInput calls do not process the items.
+    if (_hasFusedPredecessor.load() && _hasFusedPredecessor.exchange(false))
+    {
+      std::lock_guard lock{_fusedInputMutex};
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::faultOnFailedFusedDeliveryAsync(typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType delivery)
+  {
+    try
+    {
+      co_await delivery;
+    }
+    catch (...)
+    {
+      SetFaulted(std::current_exception());
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  DataFlowBlockCommon<TInputItem, TOutputItem, TState>::~DataFlowBlockCommon()
+  {
+
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::hasDefaultOptions() const
+  {
+    return _options.MaxPropagationWindow == 1
+           && !_options.ProcessLatestInputOnly
+           && !_options.TaskScheduler
+           && !_options.UseSpscInputForSinglePredecessor
+           && !_options.DisableFusion;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::isRunningInScheduler(const RStein::AsyncCpp::Schedulers::Scheduler::SchedulerPtr& scheduler)
+  {
+    return !scheduler || RStein::AsyncCpp::Schedulers::Scheduler::CurrentScheduler() == scheduler;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::tryFuseWithOutputNode()
+  {
+    //Fusion preserves the order of the output items only with the default options.
+    if (!hasDefaultOptions())
+    {
+      return;
+    }
+
+    OutputLinksPtr outputLinks{};
+    unsigned long outputLinksVersion{};
+    {
+      std::lock_guard lock{_outputLinksMutex};
+      outputLinks = _outputLinks;
+      outputLinksVersion = _outputLinksVersion.load();
+    }
+
+    if (outputLinks->BroadcastLinks.size() != 1 || !outputLinks->PartitionedLinks.empty())
+    {
+      return;
+    }
+
+    const auto& outputLink = outputLinks->BroadcastLinks.front();
+    if (outputLink.TaskScheduler)
+    {
+      return;
+    }
+
+    auto fusibleNode = std::dynamic_pointer_cast<IFusibleInputBlock<TOutputItem>>(outputLink.Node);
+    if (!fusibleNode || !fusibleNode->TryFuseWithPredecessor())
+    {
+      return;
+    }
+
+    _fusedOutputNode = std::move(fusibleNode);
+    _fusedOutputLinksVersion = outputLinksVersion;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  IFusibleInputBlock<TOutputItem>* DataFlowBlockCommon<TInputItem, TOutputItem, TState>::getFusedOutputNode()
+  {
+    if (!_fusedOutputNode)
+    {
+      return nullptr;
+    }
+
+    //Fusion is valid only for the links which existed when the block was started.
+    //The unfused block receives next items through its input queue.
+    getProcessingOutputLinks();
+    if (_processingOutputLinksVersion != _fusedOutputLinksVersion)
+    {
+      _fusedOutputNode->UnfuseFromPredecessor();
+      _fusedOutputNode.reset();
+      return nullptr;
+    }
+
+    //The linked block has been unfused by another producer or by another predecessor.
+    if (!_fusedOutputNode->IsFusedWithPredecessor())
+    {
+      _fusedOutputNode.reset();
+      return nullptr;
+    }
+
+    return _fusedOutputNode.get();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::OutputLinksPtr DataFlowBlockCommon<TInputItem, TOutputItem, TState>::getOutputLinks()
+  {
+    std::lock_guard lock{_outputLinksMutex};
+    return _outputLinks;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  const typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::OutputLinksPtr& DataFlowBlockCommon<TInputItem, TOutputItem, TState>::getProcessingOutputLinks()
+  {
+    //The lock is taken only when the links have been changed since the last call.
+    const auto outputLinksVersion = _outputLinksVersion.load(std::memory_order_acquire);
+    if (outputLinksVersion != _processingOutputLinksVersion)
+    {
+      _processingOutputLinks = getOutputLinks();
+      _processingOutputLinksVersion = outputLinksVersion;
+    }
+
+    return _processingOutputLinks;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::propagateOutputInWindow(TOutputItem& outputItem)
+  {
+    //Returns the task which must complete before the next output item is propagated, or nothing when the item has been sent (or is pending in the window).
+    const auto& outputLinks = getProcessingOutputLinks();
+    if (outputLinks->IsEmpty())
+    {
+      return std::nullopt;
+    }
+
+    removeCompletedPropagations();
+    if (_pendingPropagations.size() >= _options.MaxPropagationWindow)
+    {
+      return propagateOutputAfterWindowAsync(outputLinks, std::move(outputItem));
+    }
+
+    if (auto pendingDelivery = tryPropagateOutputSync(outputLinks, outputItem))
+    {
+      _pendingPropagations.push_back(std::move(*pendingDelivery));
+    }
+
+    return std::nullopt;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::propagateOutputAfterWindowAsync(OutputLinksPtr outputLinks, TOutputItem outputItem)
+  {
+    while (_pendingPropagations.size() >= _options.MaxPropagationWindow)
+    {
+      auto oldestPropagation = std::move(_pendingPropagations.front());
+      _pendingPropagations.pop_front();
+      co_await oldestPropagation;
+    }
+
+    //The awaited delivery may have completed in the scheduler of the linked block.
+    const auto& scheduler = _options.TaskScheduler;
+    if (!isRunningInScheduler(scheduler))
+    {
+      auto& blockScheduler = *scheduler;
+      co_await blockScheduler;
+    }
+
+    if (auto pendingDelivery = tryPropagateOutputSync(outputLinks, outputItem))
+    {
+      _pendingPropagations.push_back(std::move(*pendingDelivery));
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::deliverOutput(TOutputItem& outputItem)
+  {
+    if (auto* fusedOutputNode = getFusedOutputNode())
+    {
+      return fusedOutputNode->AcceptFusedInput(outputItem);
+    }
+
+    return propagateOutputInWindow(outputItem);
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::deliverOutputBatch(std::vector<TOutputItem>& outputItems)
+  {
+    //Output items are delivered without the coroutine frame until the first delivery is pending.
+    for (std::size_t i = 0; i < outputItems.size(); ++i)
+    {
+      //Local item supports the proxy references of the std::vector<bool>.
+      TOutputItem outputItem{std::move(outputItems[i])};
+      auto delivery = deliverOutput(outputItem);
+      if (!delivery)
+      {
+        continue;
+      }
+
+      if (!delivery->IsCompleted())
+      {
+        return deliverOutputBatchAsync(outputItems, i + 1, std::move(*delivery));
+      }
+
+      //Rethrows the failure of the delivery.
+      delivery->Wait();
+    }
+
+    return RStein::AsyncCpp::Tasks::GetCompletedTask();
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::deliverOutputBatchAsync(std::vector<TOutputItem>& outputItems,
+                                                              std::size_t nextOutputItemIndex,
+                                                              typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType pendingDelivery)
+  {
+    co_await pendingDelivery;
+    for (auto i = nextOutputItemIndex; i < outputItems.size(); ++i)
+    {
+      TOutputItem outputItem{std::move(outputItems[i])};
+      if (auto delivery = deliverOutput(outputItem))
+      {
+        co_await *delivery;
+      }
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::removeCompletedPropagations()
+  {
+    //Remove completed deliveries eagerly.
+    //Wait rethrows the failure of the linked block, which faults this block.
+    while (!_pendingPropagations.empty() && _pendingPropagations.front().IsCompleted())
+    {
+      auto completedPropagation = std::move(_pendingPropagations.front());
+      _pendingPropagations.pop_front();
+      completedPropagation.Wait();
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::tryPropagateOutputSync(const OutputLinksPtr& outputLinks, TOutputItem& outputItem)
+  {
+    //Fast path without the coroutine frame - the linked blocks (with the default input queue) accept the item synchronously.
+    //The propagateOutputAsync coroutine continues from the first link which needs another scheduler or which does not accept the item synchronously.
+    //Partitioned node must be selected here, the selection uses the state of the processing loop.
+    const OutputLink* partitionedLink = nullptr;
+    if (!outputLinks->PartitionedLinks.empty())
+    {
+      partitionedLink = selectPartitionedOutputLink(*outputLinks, outputItem);
+    }
+
+    const auto deliveriesCount = outputLinks->BroadcastLinks.size() + (partitionedLink ? 1 : 0);
+    for (std::size_t i = 0; i < deliveriesCount; ++i)
+    {
+      auto& link = getDeliveryLink(*outputLinks, partitionedLink, i);
+      if (!isRunningInScheduler(link.TaskScheduler))
+      {
+        return propagateOutputAsync(outputLinks, std::move(outputItem), i, partitionedLink, std::nullopt);
+      }
+
+      //Partitioned link has been selected for the item.
+      if (&link != partitionedLink && !link.Node->CanAcceptInput(outputItem))
+      {
+        continue;
+      }
+
+      auto delivery = link.Node->AcceptInputAsync(outputItem);
+      if (!delivery.IsCompleted())
+      {
+        if (i + 1 == deliveriesCount)
+        {
+          return delivery;
+        }
+
+        return propagateOutputAsync(outputLinks, std::move(outputItem), i + 1, partitionedLink, std::move(delivery));
+      }
+
+      delivery.Wait();
+    }
+
+    return std::nullopt;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::propagateOutputAsync(OutputLinksPtr outputLinks,
+                                                           TOutputItem outputItem,
+                                                           std::size_t firstDeliveryIndex,
+                                                           const OutputLink* partitionedLink,
+                                                           std::optional<typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType> pendingDelivery)
+  {
+    //The outputLinks keep the partitionedLink alive.
+    if (pendingDelivery)
+    {
+      co_await *pendingDelivery;
+    }
+
+    const auto deliveriesCount = outputLinks->BroadcastLinks.size() + (partitionedLink ? 1 : 0);
+    for (auto i = firstDeliveryIndex; i < deliveriesCount; ++i)
+    {
+      auto& link = getDeliveryLink(*outputLinks, partitionedLink, i);
+      //Link without the scheduler continues in the scheduler of this block, not in the scheduler of the previous link.
+      const auto& linkScheduler = link.TaskScheduler
+                                    ? link.TaskScheduler
+                                    : _options.TaskScheduler;
+      if (!isRunningInScheduler(linkScheduler))
+      {
+        auto& scheduler = *linkScheduler;
+        co_await scheduler;
+      }
+
+      if (&link != partitionedLink && !link.Node->CanAcceptInput(outputItem))
+      {
+        continue;
+      }
+
+      co_await link.Node->AcceptInputAsync(outputItem);
+    }
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  const typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::OutputLink& DataFlowBlockCommon<TInputItem, TOutputItem, TState>::getDeliveryLink(
+      const OutputLinks& outputLinks,
+      const OutputLink* partitionedLink,
+      std::size_t deliveryIndex)
+  {
+    //Links without the scheduler are delivered first, before the delivery hops to the scheduler of another link:
+    //broadcast links without the scheduler, partitioned link without the scheduler, broadcast links with the scheduler, partitioned link with the scheduler.
+    const auto& broadcastLinks = outputLinks.BroadcastLinks;
+    if (!partitionedLink)
+    {
+      return broadcastLinks[deliveryIndex];
+    }
+
+    const auto partitionedLinkIndex = partitionedLink->TaskScheduler
+                                        ? broadcastLinks.size()
+                                        : outputLinks.UnscheduledBroadcastLinksCount;
+    if (deliveryIndex == partitionedLinkIndex)
+    {
+      return *partitionedLink;
+    }
+
+    return broadcastLinks[deliveryIndex < partitionedLinkIndex
+                            ? deliveryIndex
+                            : deliveryIndex - 1];
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  const typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::OutputLink* DataFlowBlockCommon<TInputItem, TOutputItem, TState>::selectPartitionedOutputLink(
+      const OutputLinks& outputLinks,
+      const TOutputItem& outputItem)
+  {
+    using RStein::AsyncCpp::DataFlow::DataFlowLinkMode;
+    const auto& partitionedLinks = outputLinks.PartitionedLinks;
+    const auto& linkOptions = outputLinks.PartitionedLinksOptions;
+    assert(!partitionedLinks.empty());
+    const auto partitionedLinksCount = partitionedLinks.size();
+
+    if (linkOptions.Mode == DataFlowLinkMode::LeastQueued)
+    {
+      const OutputLink* leastQueuedLink = nullptr;
+      auto leastPendingInputCount = std::numeric_limits<std::size_t>::max();
+      for (auto& link : partitionedLinks)
+      {
+        if (!link.Node->CanAcceptInput(outputItem))
+        {
+          continue;
+        }
+
+        const auto pendingInputCount = link.Node->PendingInputCount();
+        if (!leastQueuedLink || pendingInputCount < leastPendingInputCount)
+        {
+          leastQueuedLink = &link;
+          leastPendingInputCount = pendingInputCount;
+        }
+      }
+
+      return leastQueuedLink;
+    }
+
+    //Key affinity - the item is never rerouted, the node selected by the key which does not accept the item skips it (as the broadcast link does).
+    if (linkOptions.Mode == DataFlowLinkMode::HashPartitioned)
+    {
+      auto& keyLink = partitionedLinks[linkOptions.KeySelector(outputItem) % partitionedLinksCount];
+      return keyLink.Node->CanAcceptInput(outputItem)
+               ? &keyLink
+               : nullptr;
+    }
+
+    //Round robin probes the following nodes when the preferred node does not accept the item.
+    const auto firstLinkIndex = _nextRoundRobinIndex++ % partitionedLinksCount;
+    for (std::size_t i = 0; i < partitionedLinksCount; ++i)
+    {
+      auto& link = partitionedLinks[(firstLinkIndex + i) % partitionedLinksCount];
+      if (link.Node->CanAcceptInput(outputItem))
+      {
+        return &link;
+      }
+    }
+
+    return nullptr;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<
+    TInputItem, TOutputItem, TState>::runProcessingTask(
+      RStein::AsyncCpp::AsyncPrimitives::CancellationToken cancellationToken)
+  {
+    //Awaited operations complete in the thread of the producer (or of the linked block),
+    //so the loop returns to the scheduler of the block after every suspension.
+    const auto& scheduler = _options.TaskScheduler;
+    auto& statePtr = _transformStatePtr;
+    const OutputSinkFuncType outputSink = [this](TOutputItem outputItem) -> typename DataFlowBlockCommon::TaskVoidType
+    {
+      auto delivery = deliverOutput(outputItem);
+      return delivery
+               ? std::move(*delivery)
+               : RStein::AsyncCpp::Tasks::GetCompletedTask();
+    };
+    const OutputBatchSinkFuncType outputBatchSink = [this](std::vector<TOutputItem>& outputItems)
+    {
+      return deliverOutputBatch(outputItems);
+    };
+    auto isDraining = false;
+    //Sync transformation is cheap, so the loop takes the waiting input items in one operation instead of paying for a take per item.
+    const auto isSyncTransform = !_isAsyncNode && !_transformManyAsyncFunc && !_transformBatchAsyncFunc;
+    //Order of the replaced input queue (priority) is respected only if the items are taken one by one.
+    const auto maxTakenInputItems = isSyncTransform && !_hasCustomInputItems ? MAX_TAKEN_INPUT_ITEMS : 1;
+    std::vector<TInputItem> takenInputItems{};
+    std::size_t takenInputItemIndex = 0;
+    std::optional<RStein::AsyncCpp::AsyncPrimitives::CancellationRegistration> wakeUpRegistration{};
+    if (_signalAsyncFunc)
+    {
+      //The take waits for the wake-up token, which is canceled by the Signal call and by the completion of the block.
+      wakeUpRegistration.emplace(cancellationToken.Register([this]
+      {
+        wakeUpProcessingLoop();
+      }));
+    }
+
+    co_await _startTask;
+    //Input item type does not have to be default constructible.
+    std::optional<TInputItem> inputItem{};
+    std::optional<TOutputItem> outputItem{};
+    while (true)
+    {
+      //Process items added before the block was completed.
+      isDraining = isDraining || cancellationToken.IsCancellationRequested();
+      if (_signalAsyncFunc && _isSignaled.load())
+      {
+        resetSignal(cancellationToken);
+        if (!isRunningInScheduler(scheduler))
+        {
+          auto& blockScheduler = *scheduler;
+          co_await blockScheduler;
+        }
+
+        co_await _signalAsyncFunc(statePtr, outputSink);
+        continue;
+      }
+
+      if (takenInputItemIndex == takenInputItems.size())
+      {
+        takenInputItems.clear();
+        takenInputItemIndex = 0;
+        if (isDraining)
+        {
+          //Bounded input queue accepts the item of the waiting producer only after the previous items have been taken.
+          if (_inputItems->TryTakeMany(takenInputItems, std::numeric_limits<std::size_t>::max()) == 0)
+          {
+            break;
+          }
+        }
+        else
+        {
+          try
+          {
+            const auto takeCancellationToken = _signalAsyncFunc
+                                                 ? _wakeUpCts.Token()
+                                                 : cancellationToken;
+            co_await _inputItems->TakeManyAsync(takenInputItems, maxTakenInputItems, takeCancellationToken);
+          }
+          catch (RStein::AsyncCpp::AsyncPrimitives::OperationCanceledException&)
+          {
+            continue;
+          }
+        }
+      }
+
+      waitForFusedInputEnd();
+      inputItem.emplace(std::move(takenInputItems[takenInputItemIndex++]));
+
+      if (!isRunningInScheduler(scheduler))
+      {
+        auto& blockScheduler = *scheduler;
+        co_await blockScheduler;
+      }
+
+      if (_options.ProcessLatestInputOnly && _pendingInputCount.load() > 1)
+      {
+        //Newer input item is waiting, skip the stale one.
+        --_pendingInputCount;
+        continue;
+      }
+
+      if (_transformBatchAsyncFunc)
+      {
+        //Take the waiting input items in one bulk operation.
+        _inputBatch.clear();
+        _inputBatch.push_back(std::move(*inputItem));
+        while (_inputBatch.size() < _maxBatchSize && takenInputItemIndex < takenInputItems.size())
+        {
+          _inputBatch.push_back(std::move(takenInputItems[takenInputItemIndex++]));
+        }
+
+        if (!isDraining)
+        {
+          _inputItems->TryTakeMany(_inputBatch, _maxBatchSize - _inputBatch.size());
+        }
+
+        co_await _transformBatchAsyncFunc(_inputBatch, statePtr, outputBatchSink);
+        _pendingInputCount -= _inputBatch.size();
+        continue;
+      }
+
+      if (_transformManyAsyncFunc)
+      {
+        co_await _transformManyAsyncFunc(*inputItem, statePtr, outputSink);
+        --_pendingInputCount;
+        continue;
+      }
+
+      if (_isAsyncNode)
+      {
+        auto asyncOutputItem = co_await _transformAsyncFunc(*inputItem, statePtr);
+        outputItem.emplace(std::move(asyncOutputItem));
+        if (!isRunningInScheduler(scheduler))
+        {
+          auto& blockScheduler = *scheduler;
+          co_await blockScheduler;
+        }
+      }
+      else
+      {
+        outputItem.emplace(_transformSyncFunc(*inputItem, statePtr));
+      }
+
+      --_pendingInputCount;
+      if (auto* fusedOutputNode = getFusedOutputNode())
+      {
+        if (auto fusedDelivery = fusedOutputNode->AcceptFusedInput(*outputItem))
+        {
+          co_await *fusedDelivery;
+        }
+
+        continue;
+      }
+
+      if (auto windowTask = propagateOutputInWindow(*outputItem))
+      {
+        co_await *windowTask;
+      }
+    }
+
+    if (_flushAsyncFunc)
+    {
+      if (!isRunningInScheduler(scheduler))
+      {
+        auto& blockScheduler = *scheduler;
+        co_await blockScheduler;
+      }
+
+      co_await _flushAsyncFunc(statePtr, outputSink);
+    }
+
+    while (!_pendingPropagations.empty())
+    {
+      auto propagation = std::move(_pendingPropagations.front());
+      _pendingPropagations.pop_front();
+      co_await propagation;
+    }
+  }
+
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  void DataFlowBlockCommon<TInputItem, TOutputItem, TState>::completeCommon(std::exception_ptr exceptionPtr)
+  {
+    if (!tryStartCompletion(exceptionPtr))
+    {
+      return;
+    }
+
+    RStein::Utils::FinallyBlock finally
+    {
+        [this, &exceptionPtr]
+        {
+          _state = BlockState::Stopped;
+          const auto isExceptional = exceptionPtr != nullptr;
+
+          getOutputLinks()->ForEachNode([isExceptional, &exceptionPtr](auto& nextBlock)
+          {
+            //TODO: Handle failing output node;
+            if (isExceptional)
+            {
+              nextBlock->SetFaulted(exceptionPtr);
+            }
+            else
+            {
+              nextBlock->Complete();
+            }
+          });
+        }
+    };
+
+
+      _processingCts.Cancel();
+      try
+      {
+        _processingTask.Wait();
+      }
+      catch (...)
+      {
+        //Failed transformation or failed delivery of the output item faults the block.
+        if (exceptionPtr == nullptr)
+        {
+          exceptionPtr = std::current_exception();
+        }
+      }
+
+      if (exceptionPtr != nullptr)
+      {
+        _completedTaskPromise.TrySetException(exceptionPtr);
+      }
+      else
+      {
+        _completedTaskPromise.TrySetResult();
+      }   
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  bool DataFlowBlockCommon<TInputItem, TOutputItem, TState>::tryStartCompletion(std::exception_ptr exceptionPtr)
+  {
+    if (--_startCallsCount > 0 && exceptionPtr == nullptr)
+    {
+      return false;
+    }
+
+    if (_state == BlockState::Created)
+    {
+      throw std::logic_error("Could not stop node.");
+    }
+
+    if (_state == BlockState::Stopped)
+    {
+      return false;
+    }
+
+    _state = BlockState::Stopping;
+    return true;
+  }
+
+  template <typename TInputItem, typename TOutputItem, typename TState>
+  typename DataFlowBlockCommon<TInputItem, TOutputItem, TState>::TaskVoidType DataFlowBlockCommon<TInputItem, TOutputItem, TState>::finishCompletionAsync(DataFlowBlockCommonPtr sharedThis)
+  {
+    std::exception_ptr exceptionPtr{};
+    try
+    {
+      co_await sharedThis->_processingTask;
+    }
+    catch (...)
+    {
+      exceptionPtr = std::current_exception();
+    }
+
+    {
+      std::lock_guard lock{ sharedThis->_stateMutex };
+      sharedThis->_state = BlockState::Stopped;
+    }
+
+    if (exceptionPtr != nullptr)
+    {
+      sharedThis->_completedTaskPromise.TrySetException(exceptionPtr);
+    }
+    else
+    {
+      sharedThis->_completedTaskPromise.TrySetResult();
+    }
+
+    sharedThis->getOutputLinks()->ForEachNode([&exceptionPtr](auto& nextBlock)
+    {
+      if (exceptionPtr != nullptr)
+      {
+        nextBlock->SetFaulted(exceptionPtr);
+      }
+      else
+      {
+        nextBlock->CompleteAsync();
+      }
+    });
+  }
+}
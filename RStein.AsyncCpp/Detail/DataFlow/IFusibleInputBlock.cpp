@@ -0,0 +1,6 @@
+﻿#include "IFusibleInputBlock.h"
+
+namespace RStein::AsyncCpp::Detail
+{
+  
+}
\ No newline at end of file
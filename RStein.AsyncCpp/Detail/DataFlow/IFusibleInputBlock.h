@@ -0,0 +1,36 @@
+﻿#pragma once
+#include "../../DataFlow/IDataFlowBlock.h"
+#include <optional>
+
+namespace RStein::AsyncCpp::Detail
+{
+  //Block which can process the output items of its only predecessor in the processing loop of the predecessor.
+  //Fused blocks do not use the input queue, so every hop does not pay for the queue, the semaphore and the coroutine resume.
+  template<typename TInputItem>
+  class IFusibleInputBlock
+  {
+  public:
+    IFusibleInputBlock() = default;
+    IFusibleInputBlock(const IFusibleInputBlock& other) = delete;
+    IFusibleInputBlock(IFusibleInputBlock&& other) = delete;
+    IFusibleInputBlock& operator=(const IFusibleInputBlock& other) = delete;
+    IFusibleInputBlock& operator=(IFusibleInputBlock&& other) = delete;
+    virtual ~IFusibleInputBlock() = default;
+
+    //Called when the block is linked to the predecessor.
+    virtual void AddPredecessor() = 0;
+    //Returns true when the predecessor may call the AcceptFusedInput method. Fails when the block has more predecessors
+    //or when the block cannot process input items synchronously.
+    //Input item from another producer (AcceptInputAsync) or another linked predecessor unfuses the block.
+    virtual bool TryFuseWithPredecessor() = 0;
+    //Called by the predecessor when the links of the predecessor have changed. The block accepts input items through its input queue again.
+    virtual void UnfuseFromPredecessor() = 0;
+    //Returns false when the block has been unfused, the predecessor then delivers the items through the input queue of the block.
+    [[nodiscard]] virtual bool IsFusedWithPredecessor() const = 0;
+    //Processes the item synchronously. Returns the task of the asynchronous delivery of the output item
+    //or no task when the item has been processed completely.
+    //Failed transformation or failed delivery faults only the fused block, the returned task does not fail.
+    //The unfused block accepts the item as the linked block without the fusion (CanAcceptInput, AcceptInputAsync).
+    virtual std::optional<RStein::AsyncCpp::DataFlow::IDataFlowBlock::TaskVoidType> AcceptFusedInput(const TInputItem& item) = 0;
+  };
+}